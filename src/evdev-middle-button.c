@@ -26,6 +26,7 @@
 #include <stdint.h>
 
 #include "evdev.h"
+#include "libinput-probes.h"
 
 #define MIDDLEBUTTON_TIMEOUT ms2us(50)
 
@@ -43,41 +44,6 @@
  * as-is.
  */
 
-static inline const char*
-middlebutton_state_to_str(enum evdev_middlebutton_state state)
-{
-	switch (state) {
-	CASE_RETURN_STRING(MIDDLEBUTTON_IDLE);
-	CASE_RETURN_STRING(MIDDLEBUTTON_LEFT_DOWN);
-	CASE_RETURN_STRING(MIDDLEBUTTON_RIGHT_DOWN);
-	CASE_RETURN_STRING(MIDDLEBUTTON_MIDDLE);
-	CASE_RETURN_STRING(MIDDLEBUTTON_LEFT_UP_PENDING);
-	CASE_RETURN_STRING(MIDDLEBUTTON_RIGHT_UP_PENDING);
-	CASE_RETURN_STRING(MIDDLEBUTTON_PASSTHROUGH);
-	CASE_RETURN_STRING(MIDDLEBUTTON_IGNORE_LR);
-	CASE_RETURN_STRING(MIDDLEBUTTON_IGNORE_L);
-	CASE_RETURN_STRING(MIDDLEBUTTON_IGNORE_R);
-	}
-
-	return NULL;
-}
-
-static inline const char*
-middlebutton_event_to_str(enum evdev_middlebutton_event event)
-{
-	switch (event) {
-	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_L_DOWN);
-	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_R_DOWN);
-	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_OTHER);
-	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_L_UP);
-	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_R_UP);
-	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_TIMEOUT);
-	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_ALL_UP);
-	}
-
-	return NULL;
-}
-
 static void
 middlebutton_state_error(struct evdev_device *device,
 			 enum evdev_middlebutton_event event)
@@ -547,6 +513,20 @@ evdev_middlebutton_handle_event(struct evdev_device *device,
 		break;
 	}
 
+	LIBINPUT_PROBE3(middlebutton_state,
+			current,
+			event,
+			device->middlebutton.state);
+
+	if (current != device->middlebutton.state)
+		evdev_trace(device,
+			    EVDEV_TRACE_MIDDLEBUTTON,
+			    time,
+			    -1,
+			    current,
+			    event,
+			    device->middlebutton.state);
+
 	log_debug(device->base.seat->libinput,
 		  "middlebuttonstate: %s → %s → %s, rc %d\n",
 		  middlebutton_state_to_str(current),
@@ -31,6 +31,7 @@
 #include "linux/input.h"
 
 #include "evdev-mt-touchpad.h"
+#include "libinput-probes.h"
 
 #define DEFAULT_BUTTON_ENTER_TIMEOUT ms2us(100)
 #define DEFAULT_BUTTON_LEAVE_TIMEOUT ms2us(300)
@@ -46,37 +47,6 @@
  * The state machine only affects the soft button area code.
  */
 
-static inline const char*
-button_state_to_str(enum button_state state) {
-	switch(state) {
-	CASE_RETURN_STRING(BUTTON_STATE_NONE);
-	CASE_RETURN_STRING(BUTTON_STATE_AREA);
-	CASE_RETURN_STRING(BUTTON_STATE_BOTTOM);
-	CASE_RETURN_STRING(BUTTON_STATE_TOP);
-	CASE_RETURN_STRING(BUTTON_STATE_TOP_NEW);
-	CASE_RETURN_STRING(BUTTON_STATE_TOP_TO_IGNORE);
-	CASE_RETURN_STRING(BUTTON_STATE_IGNORE);
-	}
-	return NULL;
-}
-
-static inline const char*
-button_event_to_str(enum button_event event) {
-	switch(event) {
-	CASE_RETURN_STRING(BUTTON_EVENT_IN_BOTTOM_R);
-	CASE_RETURN_STRING(BUTTON_EVENT_IN_BOTTOM_L);
-	CASE_RETURN_STRING(BUTTON_EVENT_IN_TOP_R);
-	CASE_RETURN_STRING(BUTTON_EVENT_IN_TOP_M);
-	CASE_RETURN_STRING(BUTTON_EVENT_IN_TOP_L);
-	CASE_RETURN_STRING(BUTTON_EVENT_IN_AREA);
-	CASE_RETURN_STRING(BUTTON_EVENT_UP);
-	CASE_RETURN_STRING(BUTTON_EVENT_PRESS);
-	CASE_RETURN_STRING(BUTTON_EVENT_RELEASE);
-	CASE_RETURN_STRING(BUTTON_EVENT_TIMEOUT);
-	}
-	return NULL;
-}
-
 static inline bool
 is_inside_bottom_button_area(const struct tp_dispatch *tp,
 			     const struct tp_touch *t)
@@ -426,12 +396,26 @@ tp_button_handle_event(struct tp_dispatch *tp,
 		break;
 	}
 
-	if (current != t->button.state)
+	LIBINPUT_PROBE4(button_state,
+			(int)(t - tp->touches),
+			current,
+			event,
+			t->button.state);
+
+	if (current != t->button.state) {
+		evdev_trace(tp->device,
+			    EVDEV_TRACE_BUTTON,
+			    time,
+			    t - tp->touches,
+			    current,
+			    event,
+			    t->button.state);
 		log_debug(libinput,
 			  "button state: from %s, event %s to %s\n",
 			  button_state_to_str(current),
 			  button_event_to_str(event),
 			  button_state_to_str(t->button.state));
+	}
 }
 
 int
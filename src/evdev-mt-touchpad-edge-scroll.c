@@ -31,6 +31,7 @@
 #include "linux/input.h"
 
 #include "evdev-mt-touchpad.h"
+#include "libinput-probes.h"
 
 /* Use a reasonably large threshold until locked into scrolling mode, to
    avoid accidentally locking in scrolling mode when trying to use the entire
@@ -38,40 +39,6 @@
    to do a small scroll. */
 #define DEFAULT_SCROLL_THRESHOLD TP_MM_TO_DPI_NORMALIZED(3)
 
-enum scroll_event {
-	SCROLL_EVENT_TOUCH,
-	SCROLL_EVENT_MOTION,
-	SCROLL_EVENT_RELEASE,
-	SCROLL_EVENT_TIMEOUT,
-	SCROLL_EVENT_POSTED,
-};
-
-static inline const char*
-edge_state_to_str(enum tp_edge_scroll_touch_state state)
-{
-
-	switch (state) {
-	CASE_RETURN_STRING(EDGE_SCROLL_TOUCH_STATE_NONE);
-	CASE_RETURN_STRING(EDGE_SCROLL_TOUCH_STATE_EDGE_NEW);
-	CASE_RETURN_STRING(EDGE_SCROLL_TOUCH_STATE_EDGE);
-	CASE_RETURN_STRING(EDGE_SCROLL_TOUCH_STATE_AREA);
-	}
-	return NULL;
-}
-
-static inline const char*
-edge_event_to_str(enum scroll_event event)
-{
-	switch (event) {
-	CASE_RETURN_STRING(SCROLL_EVENT_TOUCH);
-	CASE_RETURN_STRING(SCROLL_EVENT_MOTION);
-	CASE_RETURN_STRING(SCROLL_EVENT_RELEASE);
-	CASE_RETURN_STRING(SCROLL_EVENT_TIMEOUT);
-	CASE_RETURN_STRING(SCROLL_EVENT_POSTED);
-	}
-	return NULL;
-}
-
 uint32_t
 tp_touch_get_edge(const struct tp_dispatch *tp, const struct tp_touch *t)
 {
@@ -246,7 +213,8 @@ tp_edge_scroll_handle_area(struct tp_dispatch *tp,
 static void
 tp_edge_scroll_handle_event(struct tp_dispatch *tp,
 			    struct tp_touch *t,
-			    enum scroll_event event)
+			    enum scroll_event event,
+			    uint64_t time)
 {
 	struct libinput *libinput = tp_libinput_context(tp);
 	enum tp_edge_scroll_touch_state current = t->scroll.edge_state;
@@ -266,6 +234,21 @@ tp_edge_scroll_handle_event(struct tp_dispatch *tp,
 		break;
 	}
 
+	LIBINPUT_PROBE4(edge_scroll_state,
+			(int)(t - tp->touches),
+			current,
+			event,
+			t->scroll.edge_state);
+
+	if (current != t->scroll.edge_state)
+		evdev_trace(tp->device,
+			    EVDEV_TRACE_EDGE_SCROLL,
+			    time,
+			    t - tp->touches,
+			    current,
+			    event,
+			    t->scroll.edge_state);
+
 	log_debug(libinput,
 		  "edge state: %s → %s → %s\n",
 		  edge_state_to_str(current),
@@ -278,7 +261,7 @@ tp_edge_scroll_handle_timeout(uint64_t now, void *data)
 {
 	struct tp_touch *t = data;
 
-	tp_edge_scroll_handle_event(t->tp, t, SCROLL_EVENT_TIMEOUT);
+	tp_edge_scroll_handle_event(t->tp, t, SCROLL_EVENT_TIMEOUT, now);
 }
 
 int
@@ -327,13 +310,22 @@ tp_edge_scroll_handle_state(struct tp_dispatch *tp, uint64_t time)
 		case TOUCH_HOVERING:
 			break;
 		case TOUCH_BEGIN:
-			tp_edge_scroll_handle_event(tp, t, SCROLL_EVENT_TOUCH);
+			tp_edge_scroll_handle_event(tp,
+						    t,
+						    SCROLL_EVENT_TOUCH,
+						    time);
 			break;
 		case TOUCH_UPDATE:
-			tp_edge_scroll_handle_event(tp, t, SCROLL_EVENT_MOTION);
+			tp_edge_scroll_handle_event(tp,
+						    t,
+						    SCROLL_EVENT_MOTION,
+						    time);
 			break;
 		case TOUCH_END:
-			tp_edge_scroll_handle_event(tp, t, SCROLL_EVENT_RELEASE);
+			tp_edge_scroll_handle_event(tp,
+						    t,
+						    SCROLL_EVENT_RELEASE,
+						    time);
 			break;
 		}
 	}
@@ -424,7 +416,7 @@ tp_edge_scroll_post_events(struct tp_dispatch *tp, uint64_t time)
 				  &zero_discrete);
 		t->scroll.direction = axis;
 
-		tp_edge_scroll_handle_event(tp, t, SCROLL_EVENT_POSTED);
+		tp_edge_scroll_handle_event(tp, t, SCROLL_EVENT_POSTED, time);
 	}
 
 	return 0; /* Edge touches are suppressed by edge_scroll_touch_active */
@@ -28,23 +28,11 @@
 #include <limits.h>
 
 #include "evdev-mt-touchpad.h"
+#include "libinput-probes.h"
 
 #define DEFAULT_GESTURE_SWITCH_TIMEOUT ms2us(100)
 #define DEFAULT_GESTURE_2FG_SCROLL_TIMEOUT ms2us(500)
 
-static inline const char*
-gesture_state_to_str(enum tp_gesture_state state)
-{
-	switch (state) {
-	CASE_RETURN_STRING(GESTURE_STATE_NONE);
-	CASE_RETURN_STRING(GESTURE_STATE_UNKNOWN);
-	CASE_RETURN_STRING(GESTURE_STATE_SCROLL);
-	CASE_RETURN_STRING(GESTURE_STATE_PINCH);
-	CASE_RETURN_STRING(GESTURE_STATE_SWIPE);
-	}
-	return NULL;
-}
-
 static struct normalized_coords
 tp_get_touches_delta(struct tp_dispatch *tp, bool average)
 {
@@ -138,10 +126,10 @@ tp_gesture_post_pointer_motion(struct tp_dispatch *tp, uint64_t time)
 
 	if (!normalized_is_zero(delta) || !normalized_is_zero(unaccel)) {
 		raw = tp_unnormalize_for_xaxis(tp, unaccel);
-		pointer_notify_motion(&tp->device->base,
-				      time,
-				      &delta,
-				      &raw);
+		evdev_pointer_notify_motion(tp->device,
+					    time,
+					    &delta,
+					    &raw);
 	}
 }
 
@@ -486,6 +474,17 @@ tp_gesture_post_gesture(struct tp_dispatch *tp, uint64_t time)
 		tp->gesture.state =
 			tp_gesture_handle_state_pinch(tp, time);
 
+	LIBINPUT_PROBE2(gesture_state, oldstate, tp->gesture.state);
+
+	if (oldstate != tp->gesture.state)
+		evdev_trace(tp->device,
+			    EVDEV_TRACE_GESTURE,
+			    time,
+			    -1,
+			    oldstate,
+			    0,
+			    tp->gesture.state);
+
 	log_debug(tp_libinput_context(tp),
 		  "gesture state: %s → %s\n",
 		  gesture_state_to_str(oldstate),
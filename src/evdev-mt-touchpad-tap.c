@@ -35,20 +35,12 @@
 #include <unistd.h>
 
 #include "evdev-mt-touchpad.h"
+#include "libinput-probes.h"
 
 #define DEFAULT_TAP_TIMEOUT_PERIOD ms2us(180)
 #define DEFAULT_DRAG_TIMEOUT_PERIOD ms2us(300)
 #define DEFAULT_TAP_MOVE_THRESHOLD TP_MM_TO_DPI_NORMALIZED(3)
 
-enum tap_event {
-	TAP_EVENT_TOUCH = 12,
-	TAP_EVENT_MOTION,
-	TAP_EVENT_RELEASE,
-	TAP_EVENT_BUTTON,
-	TAP_EVENT_TIMEOUT,
-	TAP_EVENT_THUMB,
-};
-
 /*****************************************
  * DO NOT EDIT THIS FILE!
  *
@@ -60,48 +52,6 @@ enum tap_event {
  * Any changes in this file must be represented in the diagram.
  */
 
-static inline const char*
-tap_state_to_str(enum tp_tap_state state)
-{
-	switch(state) {
-	CASE_RETURN_STRING(TAP_STATE_IDLE);
-	CASE_RETURN_STRING(TAP_STATE_HOLD);
-	CASE_RETURN_STRING(TAP_STATE_TOUCH);
-	CASE_RETURN_STRING(TAP_STATE_TAPPED);
-	CASE_RETURN_STRING(TAP_STATE_TOUCH_2);
-	CASE_RETURN_STRING(TAP_STATE_TOUCH_2_HOLD);
-	CASE_RETURN_STRING(TAP_STATE_TOUCH_2_RELEASE);
-	CASE_RETURN_STRING(TAP_STATE_TOUCH_3);
-	CASE_RETURN_STRING(TAP_STATE_TOUCH_3_HOLD);
-	CASE_RETURN_STRING(TAP_STATE_DRAGGING);
-	CASE_RETURN_STRING(TAP_STATE_DRAGGING_WAIT);
-	CASE_RETURN_STRING(TAP_STATE_DRAGGING_OR_DOUBLETAP);
-	CASE_RETURN_STRING(TAP_STATE_DRAGGING_OR_TAP);
-	CASE_RETURN_STRING(TAP_STATE_DRAGGING_2);
-	CASE_RETURN_STRING(TAP_STATE_DRAGGING_3);
-	CASE_RETURN_STRING(TAP_STATE_DRAGGING_3_WAIT);
-	CASE_RETURN_STRING(TAP_STATE_DRAGGING_3_OR_TAP);
-	CASE_RETURN_STRING(TAP_STATE_MULTITAP);
-	CASE_RETURN_STRING(TAP_STATE_MULTITAP_DOWN);
-	CASE_RETURN_STRING(TAP_STATE_DEAD);
-	}
-	return NULL;
-}
-
-static inline const char*
-tap_event_to_str(enum tap_event event)
-{
-	switch(event) {
-	CASE_RETURN_STRING(TAP_EVENT_TOUCH);
-	CASE_RETURN_STRING(TAP_EVENT_MOTION);
-	CASE_RETURN_STRING(TAP_EVENT_RELEASE);
-	CASE_RETURN_STRING(TAP_EVENT_TIMEOUT);
-	CASE_RETURN_STRING(TAP_EVENT_BUTTON);
-	CASE_RETURN_STRING(TAP_EVENT_THUMB);
-	}
-	return NULL;
-}
-
 static void
 tp_tap_notify(struct tp_dispatch *tp,
 	      uint64_t time,
@@ -853,6 +803,17 @@ tp_tap_handle_event(struct tp_dispatch *tp,
 	if (tp->tap.state == TAP_STATE_IDLE || tp->tap.state == TAP_STATE_DEAD)
 		tp_tap_clear_timer(tp);
 
+	LIBINPUT_PROBE3(tap_state, current, event, tp->tap.state);
+
+	if (current != tp->tap.state)
+		evdev_trace(tp->device,
+			    EVDEV_TRACE_TAP,
+			    time,
+			    t ? t - tp->touches : -1,
+			    current,
+			    event,
+			    tp->tap.state);
+
 	log_debug(libinput,
 		  "[%"PRIu64"] tap state: %s → %s → %s\n",
 		  time,
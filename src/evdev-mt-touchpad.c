@@ -30,6 +30,7 @@
 #include <inttypes.h>
 
 #include "evdev-mt-touchpad.h"
+#include "libinput-probes.h"
 
 #define DEFAULT_TRACKPOINT_ACTIVITY_TIMEOUT ms2us(300)
 #define DEFAULT_KEYBOARD_ACTIVITY_TIMEOUT_1 ms2us(200)
@@ -145,9 +146,10 @@ tp_fake_finger_count(struct tp_dispatch *tp)
 	 * time */
 	if (__builtin_popcount(
 		       tp->fake_touches & ~(FAKE_FINGER_OVERFLOW|0x1)) > 1)
-	    log_bug_kernel(tp->device->base.seat->libinput,
-			   "Invalid fake finger state %#x\n",
-			   tp->fake_touches);
+	    log_bug_kernel_ratelimit(tp->device->base.seat->libinput,
+				     &tp->device->kernel_bug_limit,
+				     "Invalid fake finger state %#x\n",
+				     tp->fake_touches);
 
 	if (tp->fake_touches & FAKE_FINGER_OVERFLOW)
 		return FAKE_FINGER_OVERFLOW;
@@ -859,9 +861,12 @@ tp_position_fake_touches(struct tp_dispatch *tp)
 			topmost = t;
 	}
 
+	/* The device claims more fingers than it has slots but none of
+	 * the slots is active */
 	if (!topmost) {
-		log_bug_libinput(tp_libinput_context(tp),
-				 "Unable to find topmost touch\n");
+		log_bug_kernel_ratelimit(tp_libinput_context(tp),
+					 &tp->device->kernel_bug_limit,
+					 "Unable to find topmost touch\n");
 		return;
 	}
 
@@ -1014,6 +1019,11 @@ static void
 tp_handle_state(struct tp_dispatch *tp,
 		uint64_t time)
 {
+	LIBINPUT_PROBE3(tp_handle_state,
+			tp->device->devname,
+			time,
+			tp->nfingers_down);
+
 	tp_process_state(tp, time);
 	tp_post_events(tp, time);
 	tp_post_process_state(tp, time);
@@ -1387,7 +1397,7 @@ tp_interface_device_removed(struct evdev_device *device,
 			    struct evdev_device *removed_device)
 {
 	struct tp_dispatch *tp = (struct tp_dispatch*)device->dispatch;
-	struct libinput_device *dev;
+	struct evdev_device *d;
 
 	if (removed_device == tp->buttons.trackpoint) {
 		/* Clear any pending releases for the trackpoint */
@@ -1411,12 +1421,10 @@ tp_interface_device_removed(struct evdev_device *device,
 	    LIBINPUT_CONFIG_SEND_EVENTS_DISABLED_ON_EXTERNAL_MOUSE)
 		return;
 
-	list_for_each(dev, &device->base.seat->devices_list, link) {
-		struct evdev_device *d = (struct evdev_device*)dev;
-		if (d != removed_device &&
-		    (d->tags & EVDEV_TAG_EXTERNAL_MOUSE)) {
+	evdev_seat_for_each_tagged(d, device->base.seat,
+				   EVDEV_TAG_EXTERNAL_MOUSE) {
+		if (d != removed_device)
 			return;
-		}
 	}
 
 	tp_resume(tp, device);
@@ -1450,6 +1458,9 @@ static struct evdev_dispatch_interface tp_interface = {
 	tp_interface_device_removed,
 	tp_interface_device_removed, /* device_suspended, treat as remove */
 	tp_interface_device_added,   /* device_resumed, treat as add */
+	EVDEV_TAG_EXTERNAL_MOUSE |
+	EVDEV_TAG_TRACKPOINT |
+	EVDEV_TAG_KEYBOARD,
 };
 
 static void
@@ -2042,14 +2053,12 @@ static void
 tp_suspend_conditional(struct tp_dispatch *tp,
 		       struct evdev_device *device)
 {
-	struct libinput_device *dev;
+	struct evdev_device *d;
 
-	list_for_each(dev, &device->base.seat->devices_list, link) {
-		struct evdev_device *d = (struct evdev_device*)dev;
-		if (d->tags & EVDEV_TAG_EXTERNAL_MOUSE) {
-			tp_suspend(tp, device);
-			return;
-		}
+	evdev_seat_for_each_tagged(d, device->base.seat,
+				   EVDEV_TAG_EXTERNAL_MOUSE) {
+		tp_suspend(tp, device);
+		return;
 	}
 }
 
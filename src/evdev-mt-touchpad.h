@@ -147,6 +147,135 @@ enum tp_thumb_state {
 	THUMB_STATE_MAYBE,
 };
 
+enum tap_event {
+	TAP_EVENT_TOUCH = 12,
+	TAP_EVENT_MOTION,
+	TAP_EVENT_RELEASE,
+	TAP_EVENT_BUTTON,
+	TAP_EVENT_TIMEOUT,
+	TAP_EVENT_THUMB,
+};
+
+enum scroll_event {
+	SCROLL_EVENT_TOUCH,
+	SCROLL_EVENT_MOTION,
+	SCROLL_EVENT_RELEASE,
+	SCROLL_EVENT_TIMEOUT,
+	SCROLL_EVENT_POSTED,
+};
+
+static inline const char*
+tap_state_to_str(enum tp_tap_state state)
+{
+	switch(state) {
+	CASE_RETURN_STRING(TAP_STATE_IDLE);
+	CASE_RETURN_STRING(TAP_STATE_HOLD);
+	CASE_RETURN_STRING(TAP_STATE_TOUCH);
+	CASE_RETURN_STRING(TAP_STATE_TAPPED);
+	CASE_RETURN_STRING(TAP_STATE_TOUCH_2);
+	CASE_RETURN_STRING(TAP_STATE_TOUCH_2_HOLD);
+	CASE_RETURN_STRING(TAP_STATE_TOUCH_2_RELEASE);
+	CASE_RETURN_STRING(TAP_STATE_TOUCH_3);
+	CASE_RETURN_STRING(TAP_STATE_TOUCH_3_HOLD);
+	CASE_RETURN_STRING(TAP_STATE_DRAGGING);
+	CASE_RETURN_STRING(TAP_STATE_DRAGGING_WAIT);
+	CASE_RETURN_STRING(TAP_STATE_DRAGGING_OR_DOUBLETAP);
+	CASE_RETURN_STRING(TAP_STATE_DRAGGING_OR_TAP);
+	CASE_RETURN_STRING(TAP_STATE_DRAGGING_2);
+	CASE_RETURN_STRING(TAP_STATE_DRAGGING_3);
+	CASE_RETURN_STRING(TAP_STATE_DRAGGING_3_WAIT);
+	CASE_RETURN_STRING(TAP_STATE_DRAGGING_3_OR_TAP);
+	CASE_RETURN_STRING(TAP_STATE_MULTITAP);
+	CASE_RETURN_STRING(TAP_STATE_MULTITAP_DOWN);
+	CASE_RETURN_STRING(TAP_STATE_DEAD);
+	}
+	return NULL;
+}
+
+static inline const char*
+tap_event_to_str(enum tap_event event)
+{
+	switch(event) {
+	CASE_RETURN_STRING(TAP_EVENT_TOUCH);
+	CASE_RETURN_STRING(TAP_EVENT_MOTION);
+	CASE_RETURN_STRING(TAP_EVENT_RELEASE);
+	CASE_RETURN_STRING(TAP_EVENT_TIMEOUT);
+	CASE_RETURN_STRING(TAP_EVENT_BUTTON);
+	CASE_RETURN_STRING(TAP_EVENT_THUMB);
+	}
+	return NULL;
+}
+
+static inline const char*
+button_state_to_str(enum button_state state) {
+	switch(state) {
+	CASE_RETURN_STRING(BUTTON_STATE_NONE);
+	CASE_RETURN_STRING(BUTTON_STATE_AREA);
+	CASE_RETURN_STRING(BUTTON_STATE_BOTTOM);
+	CASE_RETURN_STRING(BUTTON_STATE_TOP);
+	CASE_RETURN_STRING(BUTTON_STATE_TOP_NEW);
+	CASE_RETURN_STRING(BUTTON_STATE_TOP_TO_IGNORE);
+	CASE_RETURN_STRING(BUTTON_STATE_IGNORE);
+	}
+	return NULL;
+}
+
+static inline const char*
+button_event_to_str(enum button_event event) {
+	switch(event) {
+	CASE_RETURN_STRING(BUTTON_EVENT_IN_BOTTOM_R);
+	CASE_RETURN_STRING(BUTTON_EVENT_IN_BOTTOM_L);
+	CASE_RETURN_STRING(BUTTON_EVENT_IN_TOP_R);
+	CASE_RETURN_STRING(BUTTON_EVENT_IN_TOP_M);
+	CASE_RETURN_STRING(BUTTON_EVENT_IN_TOP_L);
+	CASE_RETURN_STRING(BUTTON_EVENT_IN_AREA);
+	CASE_RETURN_STRING(BUTTON_EVENT_UP);
+	CASE_RETURN_STRING(BUTTON_EVENT_PRESS);
+	CASE_RETURN_STRING(BUTTON_EVENT_RELEASE);
+	CASE_RETURN_STRING(BUTTON_EVENT_TIMEOUT);
+	}
+	return NULL;
+}
+
+static inline const char*
+edge_state_to_str(enum tp_edge_scroll_touch_state state)
+{
+
+	switch (state) {
+	CASE_RETURN_STRING(EDGE_SCROLL_TOUCH_STATE_NONE);
+	CASE_RETURN_STRING(EDGE_SCROLL_TOUCH_STATE_EDGE_NEW);
+	CASE_RETURN_STRING(EDGE_SCROLL_TOUCH_STATE_EDGE);
+	CASE_RETURN_STRING(EDGE_SCROLL_TOUCH_STATE_AREA);
+	}
+	return NULL;
+}
+
+static inline const char*
+edge_event_to_str(enum scroll_event event)
+{
+	switch (event) {
+	CASE_RETURN_STRING(SCROLL_EVENT_TOUCH);
+	CASE_RETURN_STRING(SCROLL_EVENT_MOTION);
+	CASE_RETURN_STRING(SCROLL_EVENT_RELEASE);
+	CASE_RETURN_STRING(SCROLL_EVENT_TIMEOUT);
+	CASE_RETURN_STRING(SCROLL_EVENT_POSTED);
+	}
+	return NULL;
+}
+
+static inline const char*
+gesture_state_to_str(enum tp_gesture_state state)
+{
+	switch (state) {
+	CASE_RETURN_STRING(GESTURE_STATE_NONE);
+	CASE_RETURN_STRING(GESTURE_STATE_UNKNOWN);
+	CASE_RETURN_STRING(GESTURE_STATE_SCROLL);
+	CASE_RETURN_STRING(GESTURE_STATE_PINCH);
+	CASE_RETURN_STRING(GESTURE_STATE_SWIPE);
+	}
+	return NULL;
+}
+
 struct tp_touch {
 	struct tp_dispatch *tp;
 	enum touch_state state;
@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/stat.h>
 #include "linux/input.h"
 #include <unistd.h>
@@ -41,7 +42,9 @@
 #include "libinput.h"
 #include "evdev.h"
 #include "filter.h"
+#include "handoff.h"
 #include "libinput-private.h"
+#include "libinput-probes.h"
 
 #define DEFAULT_WHEEL_CLICK_ANGLE 15
 #define DEFAULT_MIDDLE_BUTTON_SCROLL_TIMEOUT ms2us(200)
@@ -142,6 +145,16 @@ evdev_keyboard_notify_key(struct evdev_device *device,
 		keyboard_notify_key(&device->base, time, key, state);
 }
 
+void
+evdev_pointer_notify_motion(struct evdev_device *device,
+			    uint64_t time,
+			    const struct normalized_coords *delta,
+			    const struct device_float_coords *raw)
+{
+	motion_predictor_feed(&device->pointer.predictor, delta, time);
+	pointer_notify_motion(&device->base, time, delta, raw);
+}
+
 void
 evdev_pointer_notify_physical_button(struct evdev_device *device,
 				     uint64_t time,
@@ -318,17 +331,18 @@ evdev_flush_pending_event(struct evdev_device *device, uint64_t time)
 		if (normalized_is_zero(accel) && normalized_is_zero(unaccel))
 			break;
 
-		pointer_notify_motion(base, time, &accel, &raw);
+		evdev_pointer_notify_motion(device, time, &accel, &raw);
 		break;
 	case EVDEV_ABSOLUTE_MT_DOWN:
 		if (!(device->seat_caps & EVDEV_DEVICE_TOUCH))
 			break;
 
 		if (device->mt.slots[slot].seat_slot != -1) {
-			log_bug_kernel(libinput,
-				       "%s: Driver sent multiple touch down for the "
-				       "same slot",
-				       udev_device_get_devnode(device->udev_device));
+			log_bug_kernel_ratelimit(libinput,
+						 &device->kernel_bug_limit,
+						 "%s: Driver sent multiple touch down for the "
+						 "same slot\n",
+						 udev_device_get_devnode(device->udev_device));
 			break;
 		}
 
@@ -586,11 +600,12 @@ evdev_process_touch(struct evdev_device *device,
 	switch (e->code) {
 	case ABS_MT_SLOT:
 		if ((size_t)e->value >= device->mt.slots_len) {
-			log_bug_libinput(device->base.seat->libinput,
-					 "%s exceeds slots (%d of %zd)\n",
-					 device->devname,
-					 e->value,
-					 device->mt.slots_len);
+			log_bug_kernel_ratelimit(device->base.seat->libinput,
+						 &device->kernel_bug_limit,
+						 "%s exceeds slots (%d of %zd)\n",
+						 device->devname,
+						 e->value,
+						 device->mt.slots_len);
 			e->value = device->mt.slots_len - 1;
 		}
 		evdev_flush_pending_event(device, time);
@@ -609,11 +624,19 @@ evdev_process_touch(struct evdev_device *device,
 		device->mt.slots[device->mt.slot].point.x = e->value;
 		if (device->pending_event == EVDEV_NONE)
 			device->pending_event = EVDEV_ABSOLUTE_MT_MOTION;
+		else
+			device_stat_add(&device->base,
+					LIBINPUT_STAT_EVENTS_MERGED,
+					1);
 		break;
 	case ABS_MT_POSITION_Y:
 		device->mt.slots[device->mt.slot].point.y = e->value;
 		if (device->pending_event == EVDEV_NONE)
 			device->pending_event = EVDEV_ABSOLUTE_MT_MOTION;
+		else
+			device_stat_add(&device->base,
+					LIBINPUT_STAT_EVENTS_MERGED,
+					1);
 		break;
 	}
 }
@@ -627,11 +650,19 @@ evdev_process_absolute_motion(struct evdev_device *device,
 		device->abs.point.x = e->value;
 		if (device->pending_event == EVDEV_NONE)
 			device->pending_event = EVDEV_ABSOLUTE_MOTION;
+		else
+			device_stat_add(&device->base,
+					LIBINPUT_STAT_EVENTS_MERGED,
+					1);
 		break;
 	case ABS_Y:
 		device->abs.point.y = e->value;
 		if (device->pending_event == EVDEV_NONE)
 			device->pending_event = EVDEV_ABSOLUTE_MOTION;
+		else
+			device_stat_add(&device->base,
+					LIBINPUT_STAT_EVENTS_MERGED,
+					1);
 		break;
 	}
 }
@@ -695,12 +726,20 @@ evdev_process_relative(struct evdev_device *device,
 	case REL_X:
 		if (device->pending_event != EVDEV_RELATIVE_MOTION)
 			evdev_flush_pending_event(device, time);
+		else
+			device_stat_add(&device->base,
+					LIBINPUT_STAT_EVENTS_MERGED,
+					1);
 		device->rel.x += e->value;
 		device->pending_event = EVDEV_RELATIVE_MOTION;
 		break;
 	case REL_Y:
 		if (device->pending_event != EVDEV_RELATIVE_MOTION)
 			evdev_flush_pending_event(device, time);
+		else
+			device_stat_add(&device->base,
+					LIBINPUT_STAT_EVENTS_MERGED,
+					1);
 		device->rel.y += e->value;
 		device->pending_event = EVDEV_RELATIVE_MOTION;
 		break;
@@ -796,8 +835,7 @@ evdev_tag_trackpoint(struct evdev_device *device,
 {
 	if (libevdev_has_property(device->evdev,
 				  INPUT_PROP_POINTING_STICK) ||
-	    udev_device_get_property_value(udev_device,
-					   "ID_INPUT_POINTINGSTICK"))
+	    evdev_device_get_property(device, "ID_INPUT_POINTINGSTICK"))
 		device->tags |= EVDEV_TAG_TRACKPOINT;
 }
 
@@ -962,6 +1000,7 @@ struct evdev_dispatch_interface fallback_interface = {
 	NULL, /* device_removed */
 	NULL, /* device_suspended */
 	NULL, /* device_resumed */
+	0, /* pair_tags */
 };
 
 static uint32_t
@@ -1316,6 +1355,7 @@ static inline void
 evdev_process_event(struct evdev_device *device, struct input_event *e)
 {
 	struct evdev_dispatch *dispatch = device->dispatch;
+	struct libinput *libinput = device->base.seat->libinput;
 	uint64_t time = s2us(e->time.tv_sec) + e->time.tv_usec;
 
 #if 0
@@ -1331,7 +1371,20 @@ evdev_process_event(struct evdev_device *device, struct input_event *e)
 			  e->value);
 #endif
 
+	/* the processing time is taken per frame, the clock is too
+	 * expensive to read for every event */
+	if (device->frame_start == 0)
+		device->frame_start = libinput_now(libinput);
+
 	dispatch->interface->process(dispatch, device, e, time);
+
+	if (libevdev_event_is_code(e, EV_SYN, SYN_REPORT)) {
+		device_stat_add(&device->base, LIBINPUT_STAT_FRAMES, 1);
+		device_stat_add(&device->base,
+				LIBINPUT_STAT_DISPATCH_TIME,
+				libinput_now(libinput) - device->frame_start);
+		device->frame_start = 0;
+	}
 }
 
 static inline void
@@ -1352,6 +1405,32 @@ evdev_device_dispatch_one(struct evdev_device *device,
 	}
 }
 
+/* Events read from the kernel carry the real time. With a virtual
+ * clock they happen at the current virtual time instead, otherwise the
+ * timers armed from event times would not line up with the clock. */
+static inline void
+evdev_event_set_virtual_time(struct libinput *libinput,
+			     struct input_event *ev)
+{
+	if (!libinput->use_virtual_time)
+		return;
+
+	ev->time.tv_sec = libinput->virtual_time / s2us(1);
+	ev->time.tv_usec = libinput->virtual_time % s2us(1);
+}
+
+static void
+evdev_note_syn_dropped(struct evdev_device *device)
+{
+	struct libinput *libinput = device->base.seat->libinput;
+
+	device_stat_add(&device->base, LIBINPUT_STAT_SYN_DROPPED, 1);
+	log_info_ratelimit(libinput,
+			   &device->syn_drop_limit,
+			   "SYN_DROPPED event from \"%s\" - some input events have been lost.\n",
+			   device->devname);
+}
+
 static int
 evdev_sync_device(struct evdev_device *device)
 {
@@ -1363,6 +1442,8 @@ evdev_sync_device(struct evdev_device *device)
 					 LIBEVDEV_READ_FLAG_SYNC, &ev);
 		if (rc < 0)
 			break;
+		device_stat_add(&device->base, LIBINPUT_STAT_EVDEV_EVENTS, 1);
+		evdev_event_set_virtual_time(device->base.seat->libinput, &ev);
 		evdev_device_dispatch_one(device, &ev);
 	} while (rc == LIBEVDEV_READ_STATUS_SYNC);
 
@@ -1375,19 +1456,20 @@ evdev_device_dispatch(void *data)
 	struct evdev_device *device = data;
 	struct libinput *libinput = device->base.seat->libinput;
 	struct input_event ev;
+	unsigned int nevents = 0;
 	int rc;
 
+	LIBINPUT_PROBE1(dispatch_enter, device->devname);
+
 	/* If the compositor is repainting, this function is called only once
 	 * per frame and we have to process all the events available on the
 	 * fd, otherwise there will be input lag. */
 	do {
 		rc = libevdev_next_event(device->evdev,
 					 LIBEVDEV_READ_FLAG_NORMAL, &ev);
+		evdev_event_set_virtual_time(libinput, &ev);
 		if (rc == LIBEVDEV_READ_STATUS_SYNC) {
-			log_info_ratelimit(libinput,
-					   &device->syn_drop_limit,
-					   "SYN_DROPPED event from \"%s\" - some input events have been lost.\n",
-					   device->devname);
+			evdev_note_syn_dropped(device);
 
 			/* send one more sync event so we handle all
 			   currently pending events before we sync up
@@ -1400,15 +1482,37 @@ evdev_device_dispatch(void *data)
 				rc = LIBEVDEV_READ_STATUS_SUCCESS;
 		} else if (rc == LIBEVDEV_READ_STATUS_SUCCESS) {
 			evdev_device_dispatch_one(device, &ev);
+			nevents++;
 		}
 	} while (rc == LIBEVDEV_READ_STATUS_SUCCESS);
 
+	device_stat_add(&device->base, LIBINPUT_STAT_EVDEV_EVENTS, nevents);
+	LIBINPUT_PROBE2(dispatch_exit, device->devname, nevents);
+
 	if (rc != -EAGAIN && rc != -EINTR) {
 		libinput_remove_source(libinput, device->source);
 		device->source = NULL;
 	}
 }
 
+void
+evdev_device_dispatch_event(struct evdev_device *device,
+			    const struct input_event *ev)
+{
+	struct input_event e = *ev;
+
+	/* A recorded SYN_DROPPED is followed by the recorded sync
+	 * events, handle it like evdev_device_dispatch() does */
+	if (libevdev_event_is_code(&e, EV_SYN, SYN_DROPPED)) {
+		evdev_note_syn_dropped(device);
+		e.code = SYN_REPORT;
+	} else {
+		device_stat_add(&device->base, LIBINPUT_STAT_EVDEV_EVENTS, 1);
+	}
+
+	evdev_device_dispatch_one(device, &e);
+}
+
 static inline int
 evdev_init_accel(struct evdev_device *device,
 		 enum libinput_config_accel_profile which)
@@ -1561,8 +1665,7 @@ evdev_read_wheel_click_prop(struct evdev_device *device)
 	const char *prop;
 	int angle = DEFAULT_WHEEL_CLICK_ANGLE;
 
-	prop = udev_device_get_property_value(device->udev_device,
-					      "MOUSE_WHEEL_CLICK_ANGLE");
+	prop = evdev_device_get_property(device, "MOUSE_WHEEL_CLICK_ANGLE");
 	if (prop) {
 		angle = parse_mouse_wheel_click_angle_property(prop);
 		if (!angle) {
@@ -1585,8 +1688,8 @@ evdev_get_trackpoint_dpi(struct evdev_device *device)
 	const char *trackpoint_accel;
 	double accel = DEFAULT_TRACKPOINT_ACCEL;
 
-	trackpoint_accel = udev_device_get_property_value(
-				device->udev_device, "POINTINGSTICK_CONST_ACCEL");
+	trackpoint_accel = evdev_device_get_property(device,
+						     "POINTINGSTICK_CONST_ACCEL");
 	if (trackpoint_accel) {
 		accel = parse_trackpoint_accel_property(trackpoint_accel);
 		if (accel == 0.0) {
@@ -1621,8 +1724,7 @@ evdev_read_dpi_prop(struct evdev_device *device)
 	if (device->tags & EVDEV_TAG_TRACKPOINT)
 		return evdev_get_trackpoint_dpi(device);
 
-	mouse_dpi = udev_device_get_property_value(device->udev_device,
-						   "MOUSE_DPI");
+	mouse_dpi = evdev_device_get_property(device, "MOUSE_DPI");
 	if (mouse_dpi) {
 		dpi = parse_mouse_dpi_property(mouse_dpi);
 		if (!dpi) {
@@ -1669,8 +1771,7 @@ evdev_read_model_flags(struct evdev_device *device)
 	uint32_t model_flags = 0;
 
 	while (m->property) {
-		if (!!udev_device_get_property_value(device->udev_device,
-						     m->property))
+		if (!!evdev_device_get_property(device, m->property))
 			model_flags |= m->model;
 		m++;
 	}
@@ -1683,12 +1784,10 @@ evdev_read_attr_res_prop(struct evdev_device *device,
 			 size_t *xres,
 			 size_t *yres)
 {
-	struct udev_device *udev;
 	const char *res_prop;
 
-	udev = device->udev_device;
-	res_prop = udev_device_get_property_value(udev,
-						   "LIBINPUT_ATTR_RESOLUTION_HINT");
+	res_prop = evdev_device_get_property(device,
+					     "LIBINPUT_ATTR_RESOLUTION_HINT");
 	if (!res_prop)
 		return false;
 
@@ -1700,12 +1799,10 @@ evdev_read_attr_size_prop(struct evdev_device *device,
 			  size_t *size_x,
 			  size_t *size_y)
 {
-	struct udev_device *udev;
 	const char *size_prop;
 
-	udev = device->udev_device;
-	size_prop = udev_device_get_property_value(udev,
-						   "LIBINPUT_ATTR_SIZE_HINT");
+	size_prop = evdev_device_get_property(device,
+					      "LIBINPUT_ATTR_SIZE_HINT");
 	if (!size_prop)
 		return false;
 
@@ -1767,6 +1864,16 @@ evdev_device_get_udev_tags(struct evdev_device *device,
 	const struct evdev_udev_tag_match *match;
 	int i;
 
+	/* Recordings only have the device's own properties */
+	if (!udev_device) {
+		for (match = evdev_udev_tag_matches; match->name; match++) {
+			if (evdev_device_get_property(device, match->name))
+				tags |= match->tag;
+		}
+
+		return tags;
+	}
+
 	for (i = 0; i < 2 && udev_device; i++) {
 		match = evdev_udev_tag_matches;
 		while (match->name) {
@@ -1987,6 +2094,9 @@ evdev_configure_device(struct evdev_device *device)
 	const char *devnode = udev_device_get_devnode(device->udev_device);
 	enum evdev_device_udev_tags udev_tags;
 
+	if (!devnode)
+		devnode = evdev_device_get_sysname(device);
+
 	udev_tags = evdev_device_get_udev_tags(device, device->udev_device);
 
 	if ((udev_tags & EVDEV_UDEV_TAG_INPUT) == 0 ||
@@ -2130,26 +2240,87 @@ evdev_configure_device(struct evdev_device *device)
 }
 
 static void
-evdev_notify_added_device(struct evdev_device *device)
+evdev_device_link_tags(struct evdev_device *device)
 {
-	struct libinput_device *dev;
+	struct libinput_seat *seat = device->base.seat;
+	unsigned int i;
 
-	list_for_each(dev, &device->base.seat->devices_list, link) {
-		struct evdev_device *d = (struct evdev_device*)dev;
-		if (dev == &device->base)
+	for (i = 0; i < LIBINPUT_SEAT_TAG_COUNT; i++) {
+		if (!(device->tags & (1 << i)))
 			continue;
 
-		/* Notify existing device d about addition of device device */
-		if (d->dispatch->interface->device_added)
+		list_insert(seat->tagged_devices[i].prev,
+			    &device->tag_link[i]);
+	}
+	device->linked_tags = device->tags;
+
+	if (device->dispatch->interface->pair_tags) {
+		list_insert(seat->pairing_devices.prev,
+			    &device->pairing_link);
+		device->is_pairing = true;
+	}
+}
+
+static void
+evdev_device_unlink_tags(struct evdev_device *device)
+{
+	unsigned int i;
+
+	for (i = 0; i < LIBINPUT_SEAT_TAG_COUNT; i++) {
+		if (device->linked_tags & (1 << i))
+			list_remove(&device->tag_link[i]);
+	}
+	device->linked_tags = 0;
+
+	if (device->is_pairing) {
+		list_remove(&device->pairing_link);
+		device->is_pairing = false;
+	}
+}
+
+static inline bool
+evdev_device_pairs_with(struct evdev_device *device,
+			struct evdev_device *other)
+{
+	return other != device &&
+	       (device->dispatch->interface->pair_tags & other->tags);
+}
+
+static void
+evdev_notify_added_device(struct evdev_device *device)
+{
+	struct libinput_seat *seat = device->base.seat;
+	struct evdev_dispatch_interface *interface = device->dispatch->interface;
+	struct evdev_device *d;
+	uint32_t earlier_tags;
+	unsigned int i;
+
+	evdev_device_link_tags(device);
+
+	/* Notify existing devices d about addition of device device */
+	list_for_each(d, &seat->pairing_devices, pairing_link) {
+		if (evdev_device_pairs_with(d, device) &&
+		    d->dispatch->interface->device_added)
 			d->dispatch->interface->device_added(d, device);
+	}
+
+	/* Notify new device device about existing devices d with the
+	 * tags it pairs with, and about those that are suspended. A
+	 * device with several tags is only passed for its lowest tag. */
+	for (i = 0; i < LIBINPUT_SEAT_TAG_COUNT; i++) {
+		if (!(interface->pair_tags & (1 << i)))
+			continue;
 
-		/* Notify new device device about existing device d */
-		if (device->dispatch->interface->device_added)
-			device->dispatch->interface->device_added(device, d);
+		earlier_tags = interface->pair_tags & ((1 << i) - 1);
+		list_for_each(d, &seat->tagged_devices[i], tag_link[i]) {
+			if (d == device || (d->tags & earlier_tags))
+				continue;
 
-		/* Notify new device device if existing device d is suspended */
-		if (d->suspended && device->dispatch->interface->device_suspended)
-			device->dispatch->interface->device_suspended(device, d);
+			if (interface->device_added)
+				interface->device_added(device, d);
+			if (d->suspended && interface->device_suspended)
+				interface->device_suspended(device, d);
+		}
 	}
 
 	notify_added_device(&device->base);
@@ -2179,15 +2350,14 @@ out:
 }
 
 static int
-evdev_set_device_group(struct evdev_device *device,
-		       struct udev_device *udev_device)
+evdev_set_device_group(struct evdev_device *device)
 {
 	struct libinput *libinput = device->base.seat->libinput;
 	struct libinput_device_group *group = NULL;
 	const char *udev_group;
 
-	udev_group = udev_device_get_property_value(udev_device,
-						    "LIBINPUT_DEVICE_GROUP");
+	udev_group = evdev_device_get_property(device,
+					       "LIBINPUT_DEVICE_GROUP");
 	if (udev_group)
 		group = libinput_device_group_find_group(libinput, udev_group);
 
@@ -2215,56 +2385,112 @@ evdev_drain_fd(int fd)
 	}
 }
 
-struct evdev_device *
-evdev_device_create(struct libinput_seat *seat,
-		    struct udev_device *udev_device)
+/* Properties that libinput derives its configuration from, see
+ * evdev_device_init() */
+static bool
+evdev_key_property_is_relevant(const char *name)
 {
-	struct libinput *libinput = seat->libinput;
-	struct evdev_device *device = NULL;
-	int rc;
-	int fd;
-	int unhandled_device = 0;
-	const char *devnode = udev_device_get_devnode(udev_device);
+	static const char *prefixes[] = {
+		"ID_INPUT",
+		"LIBINPUT_",
+		"MOUSE_",
+		"POINTINGSTICK_",
+	};
+	unsigned int i;
 
-	/* Use non-blocking mode so that we can loop on read on
-	 * evdev_device_data() until all events on the fd are
-	 * read.  mtdev_get() also expects this. */
-	fd = open_restricted(libinput, devnode,
-			     O_RDWR | O_NONBLOCK | O_CLOEXEC);
-	if (fd < 0) {
-		log_info(libinput,
-			 "opening input device '%s' failed (%s).\n",
-			 devnode, strerror(-fd));
-		return NULL;
+	for (i = 0; i < ARRAY_LENGTH(prefixes); i++) {
+		if (strneq(name, prefixes[i], strlen(prefixes[i])))
+			return true;
 	}
 
-	if (!evdev_device_have_same_syspath(udev_device, fd))
-		goto err;
+	return false;
+}
 
-	device = zalloc(sizeof *device);
-	if (device == NULL)
-		goto err;
+/* The hashes of the properties are summed up so the key does not
+ * depend on the property order */
+static uint64_t
+evdev_key_hash_properties(struct udev_device *udev_device)
+{
+	struct udev_list_entry *entry;
+	const char *name, *value;
+	uint64_t hash = 0, h;
 
-	libinput_device_init(&device->base, seat);
-	libinput_seat_ref(seat);
+	udev_list_entry_foreach(entry,
+			udev_device_get_properties_list_entry(udev_device)) {
+		name = udev_list_entry_get_name(entry);
+		value = udev_list_entry_get_value(entry);
+		if (!value)
+			value = "";
 
-	evdev_drain_fd(fd);
+		if (!evdev_key_property_is_relevant(name))
+			continue;
 
-	rc = libevdev_new_from_fd(fd, &device->evdev);
-	if (rc != 0)
-		goto err;
+		h = hash_data(HASH_INIT, name, strlen(name) + 1);
+		hash += hash_data(h, value, strlen(value) + 1);
+	}
 
-	libevdev_set_clock_id(device->evdev, CLOCK_MONOTONIC);
+	return hash;
+}
+
+static void
+evdev_device_key_init(struct evdev_device *device,
+		      struct evdev_device_key *key)
+{
+	struct libevdev *evdev = device->evdev;
+	const struct input_absinfo *abs;
+	const char *name = libevdev_get_name(evdev);
+	unsigned int code;
+	int32_t values[6];
+
+	memset(key, 0, sizeof(*key));
+	key->bustype = libevdev_get_id_bustype(evdev);
+	key->vendor = libevdev_get_id_vendor(evdev);
+	key->product = libevdev_get_id_product(evdev);
+	key->version = libevdev_get_id_version(evdev);
+	key->name_hash = hash_data(HASH_INIT, name, strlen(name));
+
+	key->absinfo_hash = HASH_INIT;
+	for (code = 0; code < ABS_CNT; code++) {
+		abs = libevdev_get_abs_info(evdev, code);
+		if (!abs)
+			continue;
+
+		/* the current value doesn't describe the device */
+		values[0] = code;
+		values[1] = abs->minimum;
+		values[2] = abs->maximum;
+		values[3] = abs->fuzz;
+		values[4] = abs->flat;
+		values[5] = abs->resolution;
+		key->absinfo_hash = hash_data(key->absinfo_hash,
+					      values,
+					      sizeof(values));
+	}
+
+	key->properties_hash = evdev_key_hash_properties(device->udev_device);
+}
+
+/* Set up the device once device->evdev and either the udev device or
+ * the recording are set. Returns 0 on success, -1 on error and 1 if the
+ * device is not handled by libinput */
+static int
+evdev_device_init(struct evdev_device *device)
+{
+	struct libinput *libinput = device->base.seat->libinput;
+
+	/* the key must be taken before the absinfo is fixed up */
+	if (device->udev_device) {
+		evdev_device_key_init(device, &device->handoff_key);
+		device->handoff = handoff_take(libinput, device);
+	}
 
 	device->seat_caps = 0;
 	device->is_mt = 0;
 	device->mtdev = NULL;
-	device->udev_device = udev_device_ref(udev_device);
 	device->rel.x = 0;
 	device->rel.y = 0;
 	device->abs.seat_slot = -1;
 	device->dispatch = NULL;
-	device->fd = fd;
 	device->pending_event = EVDEV_NONE;
 	device->devname = libevdev_get_name(device->evdev);
 	device->scroll.threshold = 5.0; /* Default may be overridden */
@@ -2274,53 +2500,416 @@ evdev_device_create(struct libinput_seat *seat,
 		evdev_read_wheel_click_prop(device);
 	device->model_flags = evdev_read_model_flags(device);
 	device->dpi = DEFAULT_MOUSE_DPI;
+	motion_predictor_reset(&device->pointer.predictor);
 
 	/* at most 5 SYN_DROPPED log-messages per 30s */
 	ratelimit_init(&device->syn_drop_limit, s2us(30), 5);
 	/* at most 5 log-messages per 5s */
 	ratelimit_init(&device->nonpointer_rel_limit, s2us(5), 5);
+	/* at most 5 invalid event sequence log-messages per 30s */
+	ratelimit_init(&device->kernel_bug_limit, s2us(30), 5);
 
 	matrix_init_identity(&device->abs.calibration);
 	matrix_init_identity(&device->abs.usermatrix);
 	matrix_init_identity(&device->abs.default_calibration);
 
 	if (evdev_configure_device(device) == -1)
-		goto err;
+		return -1;
 
-	if (device->seat_caps == 0) {
-		unhandled_device = 1;
-		goto err;
-	}
+	if (device->seat_caps == 0)
+		return 1;
 
 	/* If the dispatch was not set up use the fallback. */
 	if (device->dispatch == NULL)
 		device->dispatch = fallback_dispatch_create(&device->base);
 	if (device->dispatch == NULL)
+		return -1;
+
+	if (evdev_set_device_group(device))
+		return -1;
+
+	return 0;
+}
+
+void
+evdev_device_save_state(struct evdev_device *device,
+			struct evdev_device_state *state)
+{
+	size_t slot, nslots;
+	int code;
+
+	memset(state, 0, sizeof(*state));
+	for (slot = 0; slot < ARRAY_LENGTH(state->seat_slots); slot++)
+		state->seat_slots[slot] = -1;
+	state->abs_seat_slot = -1;
+
+	if (device->pointer.filter)
+		state->filter_state_size =
+			filter_save_state(device->pointer.filter,
+					  state->filter_state,
+					  sizeof(state->filter_state));
+
+	/* other dispatches keep their own key and touch state */
+	if (device->dispatch->interface != &fallback_interface)
+		return;
+
+	for (code = 0; code < KEY_CNT; code++) {
+		if (hw_is_key_down(device, code))
+			state->keys[code / 64] |= 1ULL << (code % 64);
+	}
+
+	nslots = min(device->mt.slots_len, ARRAY_LENGTH(state->seat_slots));
+	for (slot = 0; slot < nslots; slot++)
+		state->seat_slots[slot] = device->mt.slots[slot].seat_slot;
+	state->abs_seat_slot = device->abs.seat_slot;
+}
+
+static void
+evdev_restore_key(struct evdev_device *device, uint64_t time, int code)
+{
+	struct libinput_seat *seat = device->base.seat;
+	enum evdev_key_type type;
+	int button = code;
+
+	if (!libevdev_has_event_code(device->evdev, EV_KEY, code))
+		return;
+
+	type = get_key_type(code);
+	switch (type) {
+	case EVDEV_KEY_TYPE_NONE:
+		return;
+	case EVDEV_KEY_TYPE_KEY:
+		break;
+	case EVDEV_KEY_TYPE_BUTTON:
+		/* The state of the middle button emulation and button
+		 * scrolling isn't carried over, they would drop the
+		 * release of a button they didn't see pressed */
+		if (device->middlebutton.enabled ||
+		    (device->scroll.method == LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN &&
+		     code == (int)device->scroll.button))
+			return;
+		button = evdev_to_left_handed(device, code);
+		break;
+	}
+
+	hw_set_key_down(device, code, 1);
+	update_key_down_count(device, button, 1);
+	seat->button_count[button]++;
+
+	/* released while no context was reading the device */
+	if (libevdev_get_event_value(device->evdev, EV_KEY, code) != 0)
+		return;
+
+	hw_set_key_down(device, code, 0);
+	if (type == EVDEV_KEY_TYPE_KEY)
+		evdev_keyboard_notify_key(device,
+					  time,
+					  code,
+					  LIBINPUT_KEY_STATE_RELEASED);
+	else
+		evdev_pointer_notify_button(device,
+					    time,
+					    button,
+					    LIBINPUT_BUTTON_STATE_RELEASED);
+}
+
+static inline bool
+evdev_restore_seat_slot(struct libinput_seat *seat, int32_t seat_slot)
+{
+	if (seat_slot < 0 || seat_slot >= 32 ||
+	    seat->slot_map & (1 << seat_slot))
+		return false;
+
+	seat->slot_map |= 1 << seat_slot;
+
+	return true;
+}
+
+static void
+evdev_restore_touches(struct evdev_device *device,
+		      uint64_t time,
+		      const struct evdev_device_state *state)
+{
+	struct libinput_device *base = &device->base;
+	struct libinput_seat *seat = base->seat;
+	bool need_frame = false;
+	size_t slot, nslots;
+	int32_t seat_slot;
+
+	/* mtdev devices don't have the slot state in libevdev */
+	if (!(device->seat_caps & EVDEV_DEVICE_TOUCH) || device->mtdev)
+		return;
+
+	nslots = min(device->mt.slots_len, ARRAY_LENGTH(state->seat_slots));
+	for (slot = 0; slot < nslots; slot++) {
+		seat_slot = state->seat_slots[slot];
+		if (!evdev_restore_seat_slot(seat, seat_slot))
+			continue;
+
+		device->mt.slots[slot].seat_slot = seat_slot;
+
+		/* lifted while no context was reading the device */
+		if (libevdev_get_slot_value(device->evdev,
+					    slot,
+					    ABS_MT_TRACKING_ID) < 0) {
+			device->mt.slots[slot].seat_slot = -1;
+			seat->slot_map &= ~(1 << seat_slot);
+			touch_notify_touch_up(base, time, slot, seat_slot);
+			need_frame = true;
+		}
+	}
+
+	seat_slot = state->abs_seat_slot;
+	if (!device->is_mt && evdev_restore_seat_slot(seat, seat_slot)) {
+		device->abs.seat_slot = seat_slot;
+
+		if (libevdev_get_event_value(device->evdev,
+					     EV_KEY,
+					     BTN_TOUCH) == 0) {
+			device->abs.seat_slot = -1;
+			seat->slot_map &= ~(1 << seat_slot);
+			touch_notify_touch_up(base, time, -1, seat_slot);
+			need_frame = true;
+		}
+	}
+
+	if (need_frame)
+		touch_notify_frame(base, time);
+}
+
+/* Take over the state a previous context had for this device. Keys
+ * and touches that ended in the meantime are released right away so
+ * the caller sees them end in the new context. */
+void
+evdev_device_restore_state(struct evdev_device *device,
+			   const struct evdev_device_state *state)
+{
+	struct libinput *libinput = device->base.seat->libinput;
+	uint64_t time;
+	int code;
+
+	if (state->filter_state_size > 0 && device->pointer.filter)
+		filter_restore_state(device->pointer.filter,
+				     state->filter_state,
+				     state->filter_state_size);
+
+	if (device->dispatch->interface != &fallback_interface)
+		return;
+
+	if ((time = libinput_now(libinput)) == 0)
+		return;
+
+	for (code = 0; code < KEY_CNT; code++) {
+		if (state->keys[code / 64] & (1ULL << (code % 64)))
+			evdev_restore_key(device, time, code);
+	}
+
+	evdev_restore_touches(device, time, state);
+}
+
+/* Open the device node of udev_device. Returns the fd or a negative
+ * errno */
+int
+evdev_device_open(struct libinput *libinput,
+		  struct udev_device *udev_device)
+{
+	int fd;
+	const char *devnode = udev_device_get_devnode(udev_device);
+
+	/* Use non-blocking mode so that we can loop on read on
+	 * evdev_device_data() until all events on the fd are
+	 * read.  mtdev_get() also expects this. */
+	fd = open_restricted(libinput, devnode,
+			     O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) {
+		log_info(libinput,
+			 "opening input device '%s' failed (%s).\n",
+			 devnode, strerror(-fd));
+		return fd;
+	}
+
+	return evdev_device_verify_fd(libinput, udev_device, fd);
+}
+
+/* Check that fd, opened from the device node of udev_device, is still
+ * that device. Returns the fd or -ENODEV, the fd is closed on error */
+int
+evdev_device_verify_fd(struct libinput *libinput,
+		       struct udev_device *udev_device,
+		       int fd)
+{
+	if (!evdev_device_have_same_syspath(udev_device, fd)) {
+		close_restricted(libinput, fd);
+		return -ENODEV;
+	}
+
+	return fd;
+}
+
+/* Read the device description from fd. This only uses the fd and the
+ * new libevdev context, it may be called from any thread. Returns 0 or
+ * a negative errno */
+int
+evdev_device_probe(int fd, struct libevdev **evdev)
+{
+	int rc;
+
+	evdev_drain_fd(fd);
+
+	rc = libevdev_new_from_fd(fd, evdev);
+	if (rc != 0)
+		return rc;
+
+	libevdev_set_clock_id(*evdev, CLOCK_MONOTONIC);
+
+	return 0;
+}
+
+struct evdev_device *
+evdev_device_create(struct libinput_seat *seat,
+		    struct udev_device *udev_device)
+{
+	struct libinput *libinput = seat->libinput;
+	struct libevdev *evdev;
+	int fd;
+
+	fd = evdev_device_open(libinput, udev_device);
+	if (fd < 0)
+		return NULL;
+
+	if (evdev_device_probe(fd, &evdev) != 0) {
+		close_restricted(libinput, fd);
+		return NULL;
+	}
+
+	return evdev_device_create_probed(seat, udev_device, fd, evdev);
+}
+
+/* Create a device from an fd returned by evdev_device_open() and the
+ * libevdev context from evdev_device_probe(). The device takes
+ * ownership of both, they are released on error */
+struct evdev_device *
+evdev_device_create_probed(struct libinput_seat *seat,
+			   struct udev_device *udev_device,
+			   int fd,
+			   struct libevdev *evdev)
+{
+	struct libinput *libinput = seat->libinput;
+	struct evdev_device *device = NULL;
+	int rc;
+	int unhandled_device = 0;
+
+	device = zalloc(sizeof *device);
+	if (device == NULL) {
+		libevdev_free(evdev);
 		goto err;
+	}
+
+	libinput_device_init(&device->base, seat);
+	libinput_seat_ref(seat);
+
+	device->evdev = evdev;
+	device->udev_device = udev_device_ref(udev_device);
+	device->fd = fd;
+
+	rc = evdev_device_init(device);
+	if (rc != 0) {
+		unhandled_device = rc == 1;
+		goto err;
+	}
 
 	device->source =
 		libinput_add_fd(libinput, fd, evdev_device_dispatch, device);
 	if (!device->source)
 		goto err;
 
-	if (evdev_set_device_group(device, udev_device))
-		goto err;
-
 	list_insert(seat->devices_list.prev, &device->base.link);
 
 	evdev_notify_added_device(device);
 
+	if (device->handoff) {
+		evdev_device_restore_state(device, &device->handoff->state);
+		handoff_entry_destroy(device->handoff);
+		device->handoff = NULL;
+	}
+
 	return device;
 
 err:
-	if (fd >= 0)
-		close_restricted(libinput, fd);
+	close_restricted(libinput, fd);
 	if (device)
 		evdev_device_destroy(device);
 
 	return unhandled_device ? EVDEV_UNHANDLED_DEVICE :  NULL;
 }
 
+/* Create a device from a recorded description, the device takes
+ * ownership of evdev. Events are fed with evdev_device_dispatch_event() */
+struct evdev_device *
+evdev_device_create_from_recording(struct libinput_seat *seat,
+				   struct libevdev *evdev,
+				   const char *sysname,
+				   const char *properties,
+				   size_t properties_size)
+{
+	struct libinput *libinput = seat->libinput;
+	struct evdev_device *device;
+	int rc;
+
+	device = zalloc(sizeof *device);
+	if (device == NULL) {
+		libevdev_free(evdev);
+		return NULL;
+	}
+
+	libinput_device_init(&device->base, seat);
+	libinput_seat_ref(seat);
+
+	device->evdev = evdev;
+	device->fd = -1;
+	device->recording.sysname = strdup(sysname);
+	if (!device->recording.sysname) {
+		rc = -1;
+		goto err;
+	}
+
+	if (properties_size > 0) {
+		device->recording.properties = malloc(properties_size);
+		if (!device->recording.properties) {
+			rc = -1;
+			goto err;
+		}
+		memcpy(device->recording.properties,
+		       properties,
+		       properties_size);
+		device->recording.properties_size = properties_size;
+	}
+
+	/* mtdev needs an fd */
+	if (evdev_need_mtdev(device)) {
+		log_info(libinput,
+			 "input device '%s' needs mtdev, cannot be replayed\n",
+			 libevdev_get_name(evdev));
+		rc = -1;
+		goto err;
+	}
+
+	rc = evdev_device_init(device);
+	if (rc != 0)
+		goto err;
+
+	list_insert(seat->devices_list.prev, &device->base.link);
+
+	evdev_notify_added_device(device);
+
+	return device;
+
+err:
+	evdev_device_destroy(device);
+
+	return rc == 1 ? EVDEV_UNHANDLED_DEVICE : NULL;
+}
+
 const char *
 evdev_device_get_output(struct evdev_device *device)
 {
@@ -2330,9 +2919,33 @@ evdev_device_get_output(struct evdev_device *device)
 const char *
 evdev_device_get_sysname(struct evdev_device *device)
 {
+	if (!device->udev_device)
+		return device->recording.sysname;
+
 	return udev_device_get_sysname(device->udev_device);
 }
 
+const char *
+evdev_device_get_property(struct evdev_device *device,
+			  const char *key)
+{
+	const char *p = device->recording.properties;
+	const char *end = p + device->recording.properties_size;
+	size_t len = strlen(key);
+
+	if (device->udev_device)
+		return udev_device_get_property_value(device->udev_device,
+						      key);
+
+	while (p && p < end) {
+		if (strncmp(p, key, len) == 0 && p[len] == '=')
+			return &p[len + 1];
+		p += strlen(p) + 1;
+	}
+
+	return NULL;
+}
+
 const char *
 evdev_device_get_name(struct evdev_device *device)
 {
@@ -2467,6 +3080,83 @@ evdev_device_get_size(struct evdev_device *device,
 	return 0;
 }
 
+int
+evdev_device_predict_pointer(struct evdev_device *device,
+			     uint64_t time,
+			     double *dx,
+			     double *dy)
+{
+	struct normalized_coords delta;
+	bool rc;
+
+	if (!(device->seat_caps & EVDEV_DEVICE_POINTER)) {
+		*dx = 0.0;
+		*dy = 0.0;
+		return -1;
+	}
+
+	rc = motion_predictor_predict(&device->pointer.predictor,
+				      time,
+				      &delta);
+	*dx = delta.x;
+	*dy = delta.y;
+
+	return rc ? 0 : 1;
+}
+
+static int
+write_all(int fd, const void *data, size_t len)
+{
+	const char *p = data;
+	ssize_t rc;
+
+	while (len > 0) {
+		rc = write(fd, p, len);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		p += rc;
+		len -= rc;
+	}
+
+	return 0;
+}
+
+int
+evdev_device_dump_trace(struct evdev_device *device, int fd)
+{
+	struct evdev_trace_header header;
+	size_t first, nentries;
+	int rc;
+
+	nentries = min(device->trace.count, EVDEV_TRACE_SIZE);
+	first = (device->trace.count - nentries) % EVDEV_TRACE_SIZE;
+
+	header.magic = EVDEV_TRACE_MAGIC;
+	header.version = EVDEV_TRACE_VERSION;
+	header.nentries = nentries;
+	header.entry_size = sizeof(struct evdev_trace_entry);
+
+	rc = write_all(fd, &header, sizeof(header));
+	if (rc != 0)
+		return rc;
+
+	/* oldest entries first, the ring may wrap around */
+	rc = write_all(fd,
+		       &device->trace.entries[first],
+		       min(nentries, EVDEV_TRACE_SIZE - first) *
+				sizeof(struct evdev_trace_entry));
+	if (rc != 0 || first + nentries <= EVDEV_TRACE_SIZE)
+		return rc;
+
+	return write_all(fd,
+			 &device->trace.entries[0],
+			 (first + nentries - EVDEV_TRACE_SIZE) *
+				sizeof(struct evdev_trace_entry));
+}
+
 int
 evdev_device_has_button(struct evdev_device *device, uint32_t code)
 {
@@ -2605,17 +3295,14 @@ evdev_stop_scroll(struct evdev_device *device,
 void
 evdev_notify_suspended_device(struct evdev_device *device)
 {
-	struct libinput_device *it;
+	struct evdev_device *d;
 
 	if (device->suspended)
 		return;
 
-	list_for_each(it, &device->base.seat->devices_list, link) {
-		struct evdev_device *d = (struct evdev_device*)it;
-		if (it == &device->base)
-			continue;
-
-		if (d->dispatch->interface->device_suspended)
+	list_for_each(d, &device->base.seat->pairing_devices, pairing_link) {
+		if (evdev_device_pairs_with(d, device) &&
+		    d->dispatch->interface->device_suspended)
 			d->dispatch->interface->device_suspended(d, device);
 	}
 
@@ -2625,32 +3312,30 @@ evdev_notify_suspended_device(struct evdev_device *device)
 void
 evdev_notify_resumed_device(struct evdev_device *device)
 {
-	struct libinput_device *it;
+	struct evdev_device *d;
 
 	if (!device->suspended)
 		return;
 
-	list_for_each(it, &device->base.seat->devices_list, link) {
-		struct evdev_device *d = (struct evdev_device*)it;
-		if (it == &device->base)
-			continue;
-
-		if (d->dispatch->interface->device_resumed)
+	list_for_each(d, &device->base.seat->pairing_devices, pairing_link) {
+		if (evdev_device_pairs_with(d, device) &&
+		    d->dispatch->interface->device_resumed)
 			d->dispatch->interface->device_resumed(d, device);
 	}
 
 	device->suspended = 0;
 }
 
-int
-evdev_device_suspend(struct evdev_device *device)
+static void
+evdev_device_close_fd(struct evdev_device *device)
 {
-	evdev_notify_suspended_device(device);
-
 	if (device->dispatch->interface->suspend)
 		device->dispatch->interface->suspend(device->dispatch,
 						     device);
 
+	motion_predictor_reset(&device->pointer.predictor);
+	device->frame_start = 0;
+
 	if (device->source) {
 		libinput_remove_source(device->base.seat->libinput,
 				       device->source);
@@ -2666,33 +3351,31 @@ evdev_device_suspend(struct evdev_device *device)
 		close_restricted(device->base.seat->libinput, device->fd);
 		device->fd = -1;
 	}
-
-	return 0;
 }
 
-int
-evdev_device_resume(struct evdev_device *device)
+/* Attach a newly opened fd to a device that was suspended. The fd is
+ * closed on error */
+static int
+evdev_device_attach_fd(struct evdev_device *device, int fd)
 {
 	struct libinput *libinput = device->base.seat->libinput;
-	int fd;
-	const char *devnode;
 	struct input_event ev;
+	struct input_id id;
 	enum libevdev_read_status status;
 
-	if (device->fd != -1)
-		return 0;
+	device->session_suspended = false;
 
-	if (device->was_removed)
+	if (!evdev_device_have_same_syspath(device->udev_device, fd)) {
+		close_restricted(libinput, fd);
 		return -ENODEV;
+	}
 
-	devnode = udev_device_get_devnode(device->udev_device);
-	fd = open_restricted(libinput, devnode,
-			     O_RDWR | O_NONBLOCK | O_CLOEXEC);
-
-	if (fd < 0)
-		return -errno;
-
-	if (!evdev_device_have_same_syspath(device->udev_device, fd)) {
+	/* The event node may have been recycled for a different device
+	 * while our fd was closed */
+	if (ioctl(fd, EVIOCGID, &id) < 0 ||
+	    id.bustype != libevdev_get_id_bustype(device->evdev) ||
+	    id.vendor != libevdev_get_id_vendor(device->evdev) ||
+	    id.product != libevdev_get_id_product(device->evdev)) {
 		close_restricted(libinput, fd);
 		return -ENODEV;
 	}
@@ -2730,25 +3413,119 @@ evdev_device_resume(struct evdev_device *device)
 
 	memset(device->hw_key_mask, 0, sizeof(device->hw_key_mask));
 
+	return 0;
+}
+
+static int
+evdev_device_reopen_fd(struct evdev_device *device)
+{
+	struct libinput *libinput = device->base.seat->libinput;
+	const char *devnode;
+	int fd;
+
+	device->session_suspended = false;
+
+	if (device->was_removed || !device->udev_device)
+		return -ENODEV;
+
+	devnode = udev_device_get_devnode(device->udev_device);
+	fd = open_restricted(libinput, devnode,
+			     O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+	if (fd < 0)
+		return -errno;
+
+	return evdev_device_attach_fd(device, fd);
+}
+
+int
+evdev_device_suspend(struct evdev_device *device)
+{
+	evdev_notify_suspended_device(device);
+
+	evdev_device_close_fd(device);
+
+	/* The fd is now closed for good, a session resume must not
+	 * re-open it */
+	device->session_suspended = false;
+
+	return 0;
+}
+
+int
+evdev_device_resume(struct evdev_device *device)
+{
+	struct libinput *libinput = device->base.seat->libinput;
+	int rc;
+
+	if (device->fd != -1)
+		return 0;
+
+	/* Devices are re-opened when the session resumes */
+	if (libinput->session_suspended) {
+		device->session_suspended = true;
+		evdev_notify_resumed_device(device);
+		return 0;
+	}
+
+	rc = evdev_device_reopen_fd(device);
+	if (rc != 0)
+		return rc;
+
 	evdev_notify_resumed_device(device);
 
 	return 0;
 }
 
 void
-evdev_device_remove(struct evdev_device *device)
+evdev_device_session_suspend(struct evdev_device *device)
 {
-	struct libinput_device *dev;
+	if (device->fd == -1)
+		return;
 
-	list_for_each(dev, &device->base.seat->devices_list, link) {
-		struct evdev_device *d = (struct evdev_device*)dev;
-		if (dev == &device->base)
-			continue;
+	evdev_device_close_fd(device);
+	device->session_suspended = true;
+}
+
+int
+evdev_device_session_resume(struct evdev_device *device)
+{
+	if (!device->session_suspended || device->fd != -1)
+		return 0;
+
+	return evdev_device_reopen_fd(device);
+}
 
-		if (d->dispatch->interface->device_removed)
+int
+evdev_device_session_resume_fd(struct evdev_device *device, int fd)
+{
+	if (device->was_removed) {
+		close_restricted(device->base.seat->libinput, fd);
+		return -ENODEV;
+	}
+
+	/* Re-opened or disabled in the meantime */
+	if (!device->session_suspended || device->fd != -1) {
+		close_restricted(device->base.seat->libinput, fd);
+		return 0;
+	}
+
+	return evdev_device_attach_fd(device, fd);
+}
+
+void
+evdev_device_remove(struct evdev_device *device)
+{
+	struct evdev_device *d;
+
+	list_for_each(d, &device->base.seat->pairing_devices, pairing_link) {
+		if (evdev_device_pairs_with(d, device) &&
+		    d->dispatch->interface->device_removed)
 			d->dispatch->interface->device_removed(d, device);
 	}
 
+	evdev_device_unlink_tags(device);
+
 	evdev_device_suspend(device);
 
 	if (device->dispatch->interface->remove)
@@ -2777,9 +3554,12 @@ evdev_device_destroy(struct evdev_device *device)
 		libinput_device_group_unref(device->base.group);
 
 	filter_destroy(device->pointer.filter);
+	handoff_entry_destroy(device->handoff);
 	libinput_seat_unref(device->base.seat);
 	libevdev_free(device->evdev);
 	udev_device_unref(device->udev_device);
+	free(device->recording.sysname);
+	free(device->recording.properties);
 	free(device->mt.slots);
 	free(device);
 }
@@ -29,6 +29,7 @@
 #include "config.h"
 
 #include <stdbool.h>
+#include <strings.h>
 #include "linux/input.h"
 #include <libevdev/libevdev.h>
 
@@ -70,6 +71,21 @@ enum evdev_device_tags {
 	EVDEV_TAG_KEYBOARD = (1 << 3),
 };
 
+/* The seat keeps one list per tag, update this when adding a tag */
+_Static_assert(EVDEV_TAG_KEYBOARD == 1 << (LIBINPUT_SEAT_TAG_COUNT - 1),
+	       "LIBINPUT_SEAT_TAG_COUNT does not match enum evdev_device_tags");
+
+static inline unsigned int
+evdev_tag_index(enum evdev_device_tags tag)
+{
+	return ffs(tag) - 1;
+}
+
+/* Iterate over the evdev devices in seat with the given single tag */
+#define evdev_seat_for_each_tagged(d, seat, tag)			\
+	list_for_each(d, &(seat)->tagged_devices[evdev_tag_index(tag)],	\
+		      tag_link[evdev_tag_index(tag)])
+
 enum evdev_middlebutton_state {
 	MIDDLEBUTTON_IDLE,
 	MIDDLEBUTTON_LEFT_DOWN,
@@ -93,6 +109,41 @@ enum evdev_middlebutton_event {
 	MIDDLEBUTTON_EVENT_ALL_UP,
 };
 
+static inline const char*
+middlebutton_state_to_str(enum evdev_middlebutton_state state)
+{
+	switch (state) {
+	CASE_RETURN_STRING(MIDDLEBUTTON_IDLE);
+	CASE_RETURN_STRING(MIDDLEBUTTON_LEFT_DOWN);
+	CASE_RETURN_STRING(MIDDLEBUTTON_RIGHT_DOWN);
+	CASE_RETURN_STRING(MIDDLEBUTTON_MIDDLE);
+	CASE_RETURN_STRING(MIDDLEBUTTON_LEFT_UP_PENDING);
+	CASE_RETURN_STRING(MIDDLEBUTTON_RIGHT_UP_PENDING);
+	CASE_RETURN_STRING(MIDDLEBUTTON_PASSTHROUGH);
+	CASE_RETURN_STRING(MIDDLEBUTTON_IGNORE_LR);
+	CASE_RETURN_STRING(MIDDLEBUTTON_IGNORE_L);
+	CASE_RETURN_STRING(MIDDLEBUTTON_IGNORE_R);
+	}
+
+	return NULL;
+}
+
+static inline const char*
+middlebutton_event_to_str(enum evdev_middlebutton_event event)
+{
+	switch (event) {
+	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_L_DOWN);
+	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_R_DOWN);
+	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_OTHER);
+	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_L_UP);
+	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_R_UP);
+	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_TIMEOUT);
+	CASE_RETURN_STRING(MIDDLEBUTTON_EVENT_ALL_UP);
+	}
+
+	return NULL;
+}
+
 enum evdev_device_model {
 	EVDEV_MODEL_DEFAULT = 0,
 	EVDEV_MODEL_LENOVO_X230 = (1 << 0),
@@ -111,6 +162,68 @@ enum evdev_device_model {
 	EVDEV_MODEL_APPLE_INTERNAL_KEYBOARD = (1 << 13),
 };
 
+/* Number of state machine transitions kept per device, must be a power
+ * of two */
+#define EVDEV_TRACE_SIZE 512
+#define EVDEV_TRACE_MAGIC 0x52544c4c /* "LLTR" */
+#define EVDEV_TRACE_VERSION 1
+
+enum evdev_trace_subsystem {
+	EVDEV_TRACE_TAP = 1,
+	EVDEV_TRACE_BUTTON,
+	EVDEV_TRACE_EDGE_SCROLL,
+	EVDEV_TRACE_GESTURE,
+	EVDEV_TRACE_MIDDLEBUTTON,
+};
+
+/* The trace as written by evdev_device_dump_trace(): one header
+ * followed by header.nentries entries, oldest first, in host byte
+ * order. */
+struct evdev_trace_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t nentries;
+	uint32_t entry_size;
+};
+
+struct evdev_trace_entry {
+	uint64_t time;
+	uint8_t subsystem; /* enum evdev_trace_subsystem */
+	uint8_t old_state;
+	uint8_t event; /* 0 for subsystems without events */
+	uint8_t new_state;
+	int32_t touch; /* touch index or -1 */
+};
+
+/* Touches in slots beyond this are not carried over by a handoff */
+#define EVDEV_STATE_MAX_SLOTS 32
+
+/* The runtime state of a device that a new context takes over, see
+ * libinput_handoff_save() */
+struct evdev_device_state {
+	uint64_t keys[(KEY_CNT + 63) / 64]; /* hw_key_mask, by key code */
+	int32_t seat_slots[EVDEV_STATE_MAX_SLOTS]; /* by slot, or -1 */
+	int32_t abs_seat_slot; /* of a single-touch device, or -1 */
+	uint32_t filter_state_size; /* 0 if there is no filter state */
+	uint8_t filter_state[MOTION_FILTER_STATE_MAX_SIZE];
+};
+
+/* Everything the configuration of a device is derived from, a device
+ * only takes over the state of a handoff if its key still matches. The
+ * name and the udev properties are hashed, only the properties that
+ * affect the configuration are included in the hash. */
+struct evdev_device_key {
+	uint16_t bustype;
+	uint16_t vendor;
+	uint16_t product;
+	uint16_t version;
+	uint64_t name_hash;
+	uint64_t absinfo_hash;
+	uint64_t properties_hash;
+};
+
+struct handoff_entry;
+
 struct mt_slot {
 	int32_t seat_slot;
 	struct device_coords point;
@@ -128,6 +241,18 @@ struct evdev_device {
 	const char *devname;
 	bool was_removed;
 	int fd;
+	/* fd closed by evdev_device_session_suspend() */
+	bool session_suspended;
+	/* the backend's index of devices by device number */
+	struct hash_node devnum_node;
+
+	/* Devices created from a recording have no udev device and no
+	 * fd, the udev properties are a "KEY=value\0" list instead */
+	struct {
+		char *sysname;
+		char *properties;
+		size_t properties_size;
+	} recording;
 	struct {
 		const struct input_absinfo *absinfo_x, *absinfo_y;
 		int fake_resolution;
@@ -185,12 +310,20 @@ struct evdev_device {
 	enum evdev_device_seat_capability seat_caps;
 	enum evdev_device_tags tags;
 
+	/* Links in the seat's tagged_devices and pairing_devices lists,
+	 * see evdev_notify_added_device() */
+	struct list tag_link[LIBINPUT_SEAT_TAG_COUNT];
+	uint32_t linked_tags; /* enum evdev_device_tags */
+	struct list pairing_link;
+	bool is_pairing;
+
 	int is_mt;
 	int suspended;
 
 	struct {
 		struct libinput_device_config_accel config;
 		struct motion_filter *filter;
+		struct motion_predictor predictor;
 	} pointer;
 
 	/* Bitmask of pressed keys used to ignore initial release events from
@@ -226,8 +359,25 @@ struct evdev_device {
 	int dpi; /* HW resolution */
 	struct ratelimit syn_drop_limit; /* ratelimit for SYN_DROPPED logging */
 	struct ratelimit nonpointer_rel_limit; /* ratelimit for REL_* events from non-pointer devices */
+	struct ratelimit kernel_bug_limit; /* ratelimit for invalid event sequences */
 
 	uint32_t model_flags;
+
+	/* libinput_now() at the first event of the current frame, 0
+	 * between frames, see LIBINPUT_STAT_DISPATCH_TIME */
+	uint64_t frame_start;
+
+	/* the identity a handoff is keyed by, only set for devices with
+	 * a udev device */
+	struct evdev_device_key handoff_key;
+	/* state taken over from a previous context, applied once the
+	 * device is added */
+	struct handoff_entry *handoff;
+
+	struct {
+		struct evdev_trace_entry entries[EVDEV_TRACE_SIZE];
+		uint64_t count; /* total number of entries recorded */
+	} trace;
 };
 
 #define EVDEV_UNHANDLED_DEVICE ((struct evdev_device *) 1)
@@ -266,6 +416,10 @@ struct evdev_dispatch_interface {
 	/* A device was resumed */
 	void (*device_resumed)(struct evdev_device *device,
 			       struct evdev_device *resumed_device);
+
+	/* The tags (enum evdev_device_tags) of the devices passed to
+	 * device_added and friends, other devices are not passed */
+	uint32_t pair_tags;
 };
 
 struct evdev_dispatch {
@@ -282,6 +436,47 @@ struct evdev_device *
 evdev_device_create(struct libinput_seat *seat,
 		    struct udev_device *device);
 
+int
+evdev_device_open(struct libinput *libinput,
+		  struct udev_device *udev_device);
+
+int
+evdev_device_verify_fd(struct libinput *libinput,
+		       struct udev_device *udev_device,
+		       int fd);
+
+int
+evdev_device_probe(int fd, struct libevdev **evdev);
+
+struct evdev_device *
+evdev_device_create_probed(struct libinput_seat *seat,
+			   struct udev_device *udev_device,
+			   int fd,
+			   struct libevdev *evdev);
+
+struct evdev_device *
+evdev_device_create_from_recording(struct libinput_seat *seat,
+				   struct libevdev *evdev,
+				   const char *sysname,
+				   const char *properties,
+				   size_t properties_size);
+
+void
+evdev_device_dispatch_event(struct evdev_device *device,
+			    const struct input_event *ev);
+
+void
+evdev_device_save_state(struct evdev_device *device,
+			struct evdev_device_state *state);
+
+void
+evdev_device_restore_state(struct evdev_device *device,
+			   const struct evdev_device_state *state);
+
+const char *
+evdev_device_get_property(struct evdev_device *device,
+			  const char *key);
+
 int
 evdev_device_init_pointer_acceleration(struct evdev_device *device,
 				       struct motion_filter *filter);
@@ -336,6 +531,15 @@ evdev_device_get_size(struct evdev_device *device,
 		      double *w,
 		      double *h);
 
+int
+evdev_device_predict_pointer(struct evdev_device *device,
+			     uint64_t time,
+			     double *dx,
+			     double *dy);
+
+int
+evdev_device_dump_trace(struct evdev_device *device, int fd);
+
 int
 evdev_device_has_button(struct evdev_device *device, uint32_t code);
 
@@ -357,6 +561,17 @@ evdev_device_suspend(struct evdev_device *device);
 int
 evdev_device_resume(struct evdev_device *device);
 
+void
+evdev_device_session_suspend(struct evdev_device *device);
+
+int
+evdev_device_session_resume(struct evdev_device *device);
+
+/* Like evdev_device_session_resume() but with an fd opened by the
+ * caller, the fd is always consumed */
+int
+evdev_device_session_resume_fd(struct evdev_device *device, int fd);
+
 void
 evdev_notify_suspended_device(struct evdev_device *device);
 
@@ -369,6 +584,12 @@ evdev_keyboard_notify_key(struct evdev_device *device,
 			  int key,
 			  enum libinput_key_state state);
 
+void
+evdev_pointer_notify_motion(struct evdev_device *device,
+			    uint64_t time,
+			    const struct normalized_coords *delta,
+			    const struct device_float_coords *raw);
+
 void
 evdev_pointer_notify_button(struct evdev_device *device,
 			    uint64_t time,
@@ -442,4 +663,27 @@ evdev_to_left_handed(struct evdev_device *device,
 	return button;
 }
 
+static inline void
+evdev_trace(struct evdev_device *device,
+	    enum evdev_trace_subsystem subsystem,
+	    uint64_t time,
+	    int touch,
+	    unsigned int old_state,
+	    unsigned int event,
+	    unsigned int new_state)
+{
+	struct evdev_trace_entry *entry;
+
+	entry = &device->trace.entries[device->trace.count %
+				       EVDEV_TRACE_SIZE];
+	entry->time = time;
+	entry->subsystem = subsystem;
+	entry->old_state = old_state;
+	entry->event = event;
+	entry->new_state = new_state;
+	entry->touch = touch;
+
+	device->trace.count++;
+}
+
 #endif /* EVDEV_H */
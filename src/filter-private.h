@@ -44,6 +44,10 @@ struct motion_filter_interface {
 	void (*destroy)(struct motion_filter *filter);
 	bool (*set_speed)(struct motion_filter *filter,
 			  double speed_adjustment);
+	size_t (*save_state)(struct motion_filter *filter,
+			     void *data, size_t size);
+	bool (*restore_state)(struct motion_filter *filter,
+			      const void *data, size_t size);
 };
 
 struct motion_filter {
@@ -30,11 +30,13 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <limits.h>
+#include <string.h>
 #include <math.h>
 
 #include "filter.h"
 #include "libinput-util.h"
 #include "filter-private.h"
+#include "libinput-probes.h"
 
 /* Once normalized, touchpads see the same acceleration as mice. that is
  * technically correct but subjectively wrong, we expect a touchpad to be a
@@ -61,7 +63,15 @@ filter_dispatch(struct motion_filter *filter,
 		const struct normalized_coords *unaccelerated,
 		void *data, uint64_t time)
 {
-	return filter->interface->filter(filter, unaccelerated, data, time);
+	struct normalized_coords accelerated;
+
+	accelerated = filter->interface->filter(filter,
+						unaccelerated,
+						data,
+						time);
+	LIBINPUT_PROBE3(filter_dispatch, unaccelerated, &accelerated, time);
+
+	return accelerated;
 }
 
 struct normalized_coords
@@ -108,6 +118,155 @@ filter_get_type(struct motion_filter *filter)
 	return filter->interface->type;
 }
 
+size_t
+filter_save_state(struct motion_filter *filter,
+		  void *data, size_t size)
+{
+	if (!filter->interface->save_state)
+		return 0;
+
+	return filter->interface->save_state(filter, data, size);
+}
+
+bool
+filter_restore_state(struct motion_filter *filter,
+		     const void *data, size_t size)
+{
+	if (!filter->interface->restore_state)
+		return false;
+
+	return filter->interface->restore_state(filter, data, size);
+}
+
+/*
+ * Motion predictor constants
+ */
+
+#define PREDICTION_MOTION_TIMEOUT ms2us(50)	/* pause that ends a motion */
+#define PREDICTION_MAX_HORIZON ms2us(50)	/* max extrapolation time */
+
+void
+motion_predictor_reset(struct motion_predictor *predictor)
+{
+	predictor->cur_tracker = 0;
+	predictor->ntrackers = 0;
+	predictor->dir = UNDEFINED_DIRECTION;
+}
+
+static inline struct motion_predictor_tracker *
+predictor_tracker_by_offset(struct motion_predictor *predictor,
+			    unsigned int offset)
+{
+	unsigned int index =
+		(predictor->cur_tracker + MOTION_PREDICTOR_NUM_TRACKERS - offset)
+		% MOTION_PREDICTOR_NUM_TRACKERS;
+	return &predictor->trackers[index];
+}
+
+void
+motion_predictor_feed(struct motion_predictor *predictor,
+		      const struct normalized_coords *delta,
+		      uint64_t time)
+{
+	struct motion_predictor_tracker *tracker;
+	int dir;
+
+	if (normalized_is_zero(*delta))
+		return;
+
+	dir = normalized_get_direction(*delta);
+
+	/* A pause or a direction change starts a new motion, the
+	 * velocity of the previous one is useless for the prediction */
+	if (predictor->ntrackers > 0) {
+		tracker = predictor_tracker_by_offset(predictor, 0);
+		if (time < tracker->time ||
+		    time - tracker->time > PREDICTION_MOTION_TIMEOUT ||
+		    (predictor->dir & dir) == 0)
+			motion_predictor_reset(predictor);
+	}
+
+	predictor->cur_tracker = (predictor->cur_tracker + 1) %
+					MOTION_PREDICTOR_NUM_TRACKERS;
+	tracker = predictor_tracker_by_offset(predictor, 0);
+	tracker->delta = *delta;
+	tracker->time = time;
+
+	predictor->dir &= dir;
+	if (predictor->ntrackers < MOTION_PREDICTOR_NUM_TRACKERS)
+		predictor->ntrackers++;
+}
+
+bool
+motion_predictor_predict(struct motion_predictor *predictor,
+			 uint64_t time,
+			 struct normalized_coords *delta)
+{
+	struct motion_predictor_tracker *tracker, *prev, *newest, *oldest;
+	struct normalized_coords sum = { 0.0, 0.0 };
+	double velocity; /* units/us */
+	double vmin = 0.0, vmax = 0.0; /* units/us */
+	double confidence; /* unitless factor */
+	uint64_t span, tdelta;
+	unsigned int offset;
+
+	delta->x = 0.0;
+	delta->y = 0.0;
+
+	/* Need at least two events to have a velocity */
+	if (predictor->ntrackers < 2)
+		return false;
+
+	newest = predictor_tracker_by_offset(predictor, 0);
+	oldest = predictor_tracker_by_offset(predictor,
+					     predictor->ntrackers - 1);
+
+	/* The pointer has stopped by the time requested */
+	if (time > newest->time &&
+	    time - newest->time > PREDICTION_MOTION_TIMEOUT)
+		return false;
+
+	span = newest->time - oldest->time;
+	if (span == 0)
+		return false;
+
+	/* The oldest delta happened before the time span we know
+	 * about, so it is not part of the average */
+	for (offset = 0; offset < predictor->ntrackers - 1; offset++) {
+		tracker = predictor_tracker_by_offset(predictor, offset);
+		prev = predictor_tracker_by_offset(predictor, offset + 1);
+
+		sum.x += tracker->delta.x;
+		sum.y += tracker->delta.y;
+
+		tdelta = tracker->time - prev->time;
+		if (tdelta == 0)
+			continue;
+
+		velocity = normalized_length(tracker->delta) / tdelta;
+		if (vmax == 0.0 || velocity < vmin)
+			vmin = velocity;
+		if (velocity > vmax)
+			vmax = velocity;
+	}
+
+	if (vmax == 0.0)
+		return false;
+
+	if (time <= newest->time)
+		return true;
+
+	/* A motion with a steady velocity is predicted with full
+	 * confidence, an erratic one is damped towards no motion */
+	confidence = vmin / vmax;
+	tdelta = min(time - newest->time, PREDICTION_MAX_HORIZON);
+
+	delta->x = sum.x / span * tdelta * confidence;
+	delta->y = sum.y / span * tdelta * confidence;
+
+	return true;
+}
+
 /*
  * Default parameters for pointer acceleration profiles.
  */
@@ -156,6 +315,16 @@ struct pointer_accelerator {
 	double dpi_factor;
 };
 
+/* The motion history of a struct pointer_accelerator as written by
+ * accelerator_save_state(). The tracker timestamps are in
+ * CLOCK_MONOTONIC and stay valid across processes. */
+struct pointer_accelerator_state {
+	double last_velocity;	/* units/us */
+	int32_t cur_tracker;
+	uint32_t padding;
+	struct pointer_tracker trackers[NUM_POINTER_TRACKERS];
+};
+
 struct pointer_accelerator_flat {
 	struct motion_filter base;
 
@@ -727,6 +896,49 @@ trackpoint_accel_profile(struct motion_filter *filter,
 	return factor;
 }
 
+static size_t
+accelerator_save_state(struct motion_filter *filter,
+		       void *data, size_t size)
+{
+	struct pointer_accelerator *accel =
+		(struct pointer_accelerator *) filter;
+	struct pointer_accelerator_state state;
+
+	if (size < sizeof(state) || !accel->trackers)
+		return 0;
+
+	memset(&state, 0, sizeof(state));
+	state.last_velocity = accel->last_velocity;
+	state.cur_tracker = accel->cur_tracker;
+	memcpy(state.trackers, accel->trackers, sizeof(state.trackers));
+	memcpy(data, &state, sizeof(state));
+
+	return sizeof(state);
+}
+
+static bool
+accelerator_restore_state(struct motion_filter *filter,
+			  const void *data, size_t size)
+{
+	struct pointer_accelerator *accel =
+		(struct pointer_accelerator *) filter;
+	struct pointer_accelerator_state state;
+
+	if (size != sizeof(state) || !accel->trackers)
+		return false;
+
+	memcpy(&state, data, sizeof(state));
+	if (state.cur_tracker < 0 ||
+	    state.cur_tracker >= NUM_POINTER_TRACKERS)
+		return false;
+
+	accel->last_velocity = state.last_velocity;
+	accel->cur_tracker = state.cur_tracker;
+	memcpy(accel->trackers, state.trackers, sizeof(state.trackers));
+
+	return true;
+}
+
 struct motion_filter_interface accelerator_interface = {
 	.type = LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE,
 	.filter = accelerator_filter,
@@ -734,6 +946,8 @@ struct motion_filter_interface accelerator_interface = {
 	.restart = accelerator_restart,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
+	.save_state = accelerator_save_state,
+	.restore_state = accelerator_restore_state,
 };
 
 static struct pointer_accelerator *
@@ -782,6 +996,8 @@ struct motion_filter_interface accelerator_interface_low_dpi = {
 	.restart = accelerator_restart,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
+	.save_state = accelerator_save_state,
+	.restore_state = accelerator_restore_state,
 };
 
 struct motion_filter *
@@ -806,6 +1022,8 @@ struct motion_filter_interface accelerator_interface_touchpad = {
 	.restart = accelerator_restart,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
+	.save_state = accelerator_save_state,
+	.restore_state = accelerator_restore_state,
 };
 
 struct motion_filter *
@@ -830,6 +1048,8 @@ struct motion_filter_interface accelerator_interface_x230 = {
 	.restart = accelerator_restart,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
+	.save_state = accelerator_save_state,
+	.restore_state = accelerator_restore_state,
 };
 
 /* The Lenovo x230 has a bad touchpad. This accel method has been
@@ -869,6 +1089,8 @@ struct motion_filter_interface accelerator_interface_trackpoint = {
 	.restart = accelerator_restart,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
+	.save_state = accelerator_save_state,
+	.restore_state = accelerator_restore_state,
 };
 
 struct motion_filter *
@@ -948,6 +1170,8 @@ struct motion_filter_interface accelerator_interface_flat = {
 	.restart = NULL,
 	.destroy = accelerator_destroy_flat,
 	.set_speed = accelerator_set_speed_flat,
+	.save_state = NULL,
+	.restore_state = NULL,
 };
 
 struct motion_filter *
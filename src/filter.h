@@ -77,6 +77,65 @@ filter_get_speed(struct motion_filter *filter);
 enum libinput_config_accel_profile
 filter_get_type(struct motion_filter *filter);
 
+/* The largest state filter_save_state() writes */
+#define MOTION_FILTER_STATE_MAX_SIZE 1024
+
+/* Write the motion history of the filter to data, up to size bytes.
+ * Returns the number of bytes written, 0 if the filter has no history
+ * or it doesn't fit */
+size_t
+filter_save_state(struct motion_filter *filter,
+		  void *data, size_t size);
+
+/* Restore the motion history written by filter_save_state() of a
+ * filter of the same kind. Returns false if the state doesn't match
+ * the filter, the filter is unchanged in that case */
+bool
+filter_restore_state(struct motion_filter *filter,
+		     const void *data, size_t size);
+
+/*
+ * Motion predictor, extrapolates the recent (accelerated) pointer motion
+ * into the near future. The predictor only considers the current motion,
+ * i.e. it starts from scratch after a pause or a change in direction.
+ */
+#define MOTION_PREDICTOR_NUM_TRACKERS 8
+
+struct motion_predictor_tracker {
+	struct normalized_coords delta; /* delta of this event */
+	uint64_t time; /* us */
+};
+
+struct motion_predictor {
+	struct motion_predictor_tracker trackers[MOTION_PREDICTOR_NUM_TRACKERS];
+	unsigned int cur_tracker;
+	unsigned int ntrackers; /* number of trackers in current motion */
+	int dir; /* direction mask common to all trackers */
+};
+
+void
+motion_predictor_reset(struct motion_predictor *predictor);
+
+void
+motion_predictor_feed(struct motion_predictor *predictor,
+		      const struct normalized_coords *delta,
+		      uint64_t time);
+
+/**
+ * Predict the motion between the most recent event and the given time.
+ *
+ * The velocity is averaged over the current motion and damped by how
+ * consistent the velocity was within that motion (the confidence), the
+ * extrapolation is capped to a maximum horizon.
+ *
+ * @return true if a prediction is available, false otherwise. If false,
+ * delta is set to zero.
+ */
+bool
+motion_predictor_predict(struct motion_predictor *predictor,
+			 uint64_t time,
+			 struct normalized_coords *delta);
+
 typedef double (*accel_profile_func_t)(struct motion_filter *filter,
 				       void *data,
 				       double velocity,
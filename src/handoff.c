@@ -0,0 +1,422 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "evdev.h"
+#include "handoff.h"
+#include "libinput-private.h"
+#include "libinput-version.h"
+
+/*
+ * Format of the state written by libinput_handoff_save(): a struct
+ * handoff_header followed by header.ndevices records. Each record is a
+ * struct handoff_record followed by record.devnode_len bytes of the
+ * null-terminated device node. All values are in host byte order, the
+ * state is only read by the same version of libinput on the same
+ * machine, the header carries the version and record size to enforce
+ * that.
+ */
+#define HANDOFF_MAGIC "LIBINPHO"
+#define HANDOFF_VERSION 3
+
+struct handoff_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t ndevices;
+	char libinput_version[32]; /* LIBINPUT_VERSION, 0-padded */
+	uint32_t record_size; /* sizeof(struct handoff_record) */
+	uint32_t padding; /* unused, 0 */
+};
+
+struct handoff_record {
+	struct evdev_device_key key;
+	struct evdev_device_state state;
+	uint32_t devnode_len; /* including the null byte */
+	uint32_t padding; /* unused, 0 */
+};
+
+void
+handoff_entry_destroy(struct handoff_entry *entry)
+{
+	if (!entry)
+		return;
+
+	free(entry->devnode);
+	free(entry);
+}
+
+static struct handoff_entry *
+handoff_find(struct libinput *libinput, const char *devnode)
+{
+	struct hash_node *node;
+	struct handoff_entry *entry;
+
+	for (node = hash_index_first(&libinput->handoff.index,
+				     hash_string(devnode));
+	     node;
+	     node = hash_index_next(node)) {
+		entry = container_of(node, entry, node);
+		if (streq(entry->devnode, devnode))
+			return entry;
+	}
+
+	return NULL;
+}
+
+static void
+handoff_entry_remove(struct libinput *libinput, struct handoff_entry *entry)
+{
+	list_remove(&entry->link);
+	hash_index_remove(&libinput->handoff.index, &entry->node);
+}
+
+struct handoff_entry *
+handoff_take(struct libinput *libinput, struct evdev_device *device)
+{
+	struct handoff_entry *entry;
+	const char *devnode;
+
+	if (list_empty(&libinput->handoff.entries))
+		return NULL;
+
+	devnode = udev_device_get_devnode(device->udev_device);
+	if (!devnode)
+		return NULL;
+
+	entry = handoff_find(libinput, devnode);
+	if (!entry)
+		return NULL;
+
+	handoff_entry_remove(libinput, entry);
+
+	if (memcmp(&entry->key, &device->handoff_key, sizeof(entry->key)) != 0) {
+		log_info(libinput,
+			 "%s: device changed since the handoff, ignoring its state\n",
+			 devnode);
+		handoff_entry_destroy(entry);
+		return NULL;
+	}
+
+	return entry;
+}
+
+void
+handoff_init(struct libinput *libinput)
+{
+	list_init(&libinput->handoff.entries);
+	hash_index_init(&libinput->handoff.index);
+}
+
+void
+handoff_destroy(struct libinput *libinput)
+{
+	struct handoff_entry *entry, *tmp;
+
+	list_for_each_safe(entry, tmp, &libinput->handoff.entries, link)
+		handoff_entry_destroy(entry);
+
+	hash_index_destroy(&libinput->handoff.index);
+	handoff_init(libinput);
+}
+
+/* The fd may be a pipe or a socket, short reads and writes are not
+ * errors */
+static int
+handoff_write(int fd, const void *data, size_t size)
+{
+	const char *p = data;
+	ssize_t len;
+
+	while (size > 0) {
+		len = write(fd, p, size);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		p += len;
+		size -= len;
+	}
+
+	return 0;
+}
+
+static int
+handoff_read(int fd, void *data, size_t size)
+{
+	char *p = data;
+	ssize_t len;
+
+	while (size > 0) {
+		len = read(fd, p, size);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		if (len == 0)
+			return -EINVAL;
+		p += len;
+		size -= len;
+	}
+
+	return 0;
+}
+
+/* Check that the rest of a regular file is large enough for ndevices
+ * records. Pipes and sockets have no known size, there the records are
+ * read until the data runs out. */
+static bool
+handoff_fits_file(int fd, uint32_t ndevices)
+{
+	struct stat st;
+	off_t offset;
+	const size_t min_record_size = sizeof(struct handoff_record) + 2;
+
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+		return true;
+
+	offset = lseek(fd, 0, SEEK_CUR);
+	if (offset < 0 || offset > st.st_size)
+		return true;
+
+	return ndevices <= (uint64_t)(st.st_size - offset) / min_record_size;
+}
+
+static void
+handoff_header_init(struct handoff_header *header)
+{
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, HANDOFF_MAGIC, sizeof(header->magic));
+	header->version = HANDOFF_VERSION;
+	snprintf(header->libinput_version,
+		 sizeof(header->libinput_version),
+		 "%s",
+		 LIBINPUT_VERSION);
+	header->record_size = sizeof(struct handoff_record);
+}
+
+static inline bool
+handoff_device_is_saved(struct evdev_device *device)
+{
+	return device->udev_device &&
+	       device->fd >= 0 &&
+	       udev_device_get_devnode(device->udev_device);
+}
+
+LIBINPUT_EXPORT int
+libinput_handoff_save(struct libinput *libinput, int fd)
+{
+	struct handoff_header header;
+	struct handoff_record *record;
+	struct libinput_seat *seat;
+	struct libinput_device *base;
+	struct evdev_device *device;
+	const char *devnode;
+	int rc;
+
+	handoff_header_init(&header);
+	list_for_each(seat, &libinput->seat_list, link) {
+		list_for_each(base, &seat->devices_list, link) {
+			device = (struct evdev_device *) base;
+			if (handoff_device_is_saved(device))
+				header.ndevices++;
+		}
+	}
+
+	rc = handoff_write(fd, &header, sizeof(header));
+	if (rc != 0)
+		return rc;
+
+	record = zalloc(sizeof(*record));
+	if (!record)
+		return -ENOMEM;
+
+	list_for_each(seat, &libinput->seat_list, link) {
+		list_for_each(base, &seat->devices_list, link) {
+			device = (struct evdev_device *) base;
+			if (!handoff_device_is_saved(device))
+				continue;
+
+			devnode = udev_device_get_devnode(device->udev_device);
+
+			memset(record, 0, sizeof(*record));
+			record->key = device->handoff_key;
+			evdev_device_save_state(device, &record->state);
+			record->devnode_len = strlen(devnode) + 1;
+
+			rc = handoff_write(fd, record, sizeof(*record));
+			if (rc == 0)
+				rc = handoff_write(fd,
+						   devnode,
+						   record->devnode_len);
+			if (rc != 0)
+				goto out;
+		}
+	}
+
+out:
+	free(record);
+
+	return rc;
+}
+
+static bool
+handoff_state_is_valid(const struct evdev_device_state *state)
+{
+	size_t i;
+
+	if (state->filter_state_size > sizeof(state->filter_state))
+		return false;
+
+	for (i = 0; i < ARRAY_LENGTH(state->seat_slots); i++) {
+		if (state->seat_slots[i] < -1 || state->seat_slots[i] >= 32)
+			return false;
+	}
+
+	return state->abs_seat_slot >= -1 && state->abs_seat_slot < 32;
+}
+
+LIBINPUT_EXPORT int
+libinput_handoff_load(struct libinput *libinput, int fd)
+{
+	struct handoff_header header, expected;
+	struct handoff_record *record;
+	struct handoff_entry **entries = NULL, **tmp;
+	struct handoff_entry *entry, *old;
+	uint32_t i, n = 0, nalloc = 0;
+	int rc;
+
+	rc = handoff_read(fd, &header, sizeof(header));
+	if (rc != 0)
+		return rc;
+
+	handoff_header_init(&expected);
+	if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+	    header.version != expected.version ||
+	    memcmp(header.libinput_version,
+		   expected.libinput_version,
+		   sizeof(header.libinput_version)) != 0 ||
+	    header.record_size != expected.record_size ||
+	    !handoff_fits_file(fd, header.ndevices))
+		return -EINVAL;
+
+	record = zalloc(sizeof(*record));
+	if (!record)
+		return -ENOMEM;
+
+	/* read everything first so a truncated state doesn't leave
+	 * half of it behind. The entries array grows as the records come
+	 * in, a bogus device count on a pipe only costs what was actually
+	 * sent. */
+	for (n = 0; n < header.ndevices; n++) {
+		if (n == nalloc) {
+			nalloc = min(max(nalloc * 2, 16U), header.ndevices);
+			tmp = realloc(entries, nalloc * sizeof(*entries));
+			if (!tmp) {
+				rc = -ENOMEM;
+				goto out;
+			}
+			entries = tmp;
+			memset(&entries[n], 0, (nalloc - n) * sizeof(*entries));
+		}
+
+		rc = handoff_read(fd, record, sizeof(*record));
+		if (rc != 0)
+			goto out;
+
+		if (record->devnode_len < 2 ||
+		    record->devnode_len > PATH_MAX ||
+		    !handoff_state_is_valid(&record->state)) {
+			rc = -EINVAL;
+			goto out;
+		}
+
+		entry = zalloc(sizeof(*entry));
+		if (!entry) {
+			rc = -ENOMEM;
+			goto out;
+		}
+		entries[n] = entry;
+
+		entry->devnode = zalloc(record->devnode_len);
+		if (!entry->devnode) {
+			rc = -ENOMEM;
+			goto out;
+		}
+
+		rc = handoff_read(fd, entry->devnode, record->devnode_len);
+		if (rc != 0)
+			goto out;
+
+		if (entry->devnode[record->devnode_len - 1] != '\0' ||
+		    strlen(entry->devnode) != record->devnode_len - 1) {
+			rc = -EINVAL;
+			goto out;
+		}
+
+		entry->key = record->key;
+		entry->state = record->state;
+	}
+
+	/* Grow the index first, nothing below may fail once the first
+	 * entry replaced an old one */
+	if (!hash_index_reserve(&libinput->handoff.index,
+				libinput->handoff.index.count + n)) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < n; i++) {
+		entry = entries[i];
+		old = handoff_find(libinput, entry->devnode);
+		if (old) {
+			handoff_entry_remove(libinput, old);
+			handoff_entry_destroy(old);
+		}
+
+		/* cannot fail, the index has buckets */
+		hash_index_insert(&libinput->handoff.index,
+				  &entry->node,
+				  hash_string(entry->devnode));
+		list_insert(&libinput->handoff.entries, &entry->link);
+		entries[i] = NULL;
+	}
+
+out:
+	for (i = 0; i < nalloc; i++)
+		handoff_entry_destroy(entries[i]);
+	free(entries);
+	free(record);
+
+	return rc;
+}
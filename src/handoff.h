@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include "evdev.h"
+#include "libinput-util.h"
+
+struct libinput;
+
+/* The state of a device loaded by libinput_handoff_load() that no
+ * device took over yet */
+struct handoff_entry {
+	struct list link;
+	struct hash_node node; /* by devnode */
+	char *devnode;
+	struct evdev_device_key key;
+	struct evdev_device_state state;
+};
+
+void
+handoff_init(struct libinput *libinput);
+
+void
+handoff_destroy(struct libinput *libinput);
+
+/* Remove and return the entry for the device node of device, or NULL.
+ * An entry for a different device on the same node is discarded. */
+struct handoff_entry *
+handoff_take(struct libinput *libinput, struct evdev_device *device);
+
+void
+handoff_entry_destroy(struct handoff_entry *entry);
+
+#endif
@@ -66,6 +66,28 @@ struct libinput_interface_backend {
 				  const char *seat_name);
 };
 
+/* A FIFO of events that grows as needed */
+struct event_ring {
+	struct libinput_event **events;
+	size_t count;
+	size_t len;
+	size_t in;
+	size_t out;
+};
+
+/* Events of the seats and device groups assigned to this queue, see
+ * libinput_seat_set_event_queue() */
+struct libinput_event_queue {
+	struct libinput *libinput; /* NULL once the context is destroyed */
+	int refcount;
+	struct list link;
+	struct event_ring events;
+	int fd; /* eventfd, readable while events are queued */
+};
+
+/* Size of the stats arrays, indexed by enum libinput_stat */
+#define LIBINPUT_STAT_COUNT (LIBINPUT_STAT_DISPATCH_TIME + 1)
+
 struct libinput {
 	int epoll_fd;
 	struct list source_destroy_list;
@@ -73,16 +95,16 @@ struct libinput {
 	struct list seat_list;
 
 	struct {
-		struct list list;
+		struct list list; /* sorted by expire time */
 		struct libinput_source *source;
 		int fd;
+		uint64_t armed; /* expire time the timerfd is set to, or 0 */
 	} timer;
 
-	struct libinput_event **events;
-	size_t events_count;
-	size_t events_len;
-	size_t events_in;
-	size_t events_out;
+	/* events not routed to a struct libinput_event_queue */
+	struct event_ring events;
+	struct list event_queues; /* struct libinput_event_queue */
+	uint32_t last_export_id; /* of the most recently added device */
 
 	const struct libinput_interface *interface;
 	const struct libinput_interface_backend *interface_backend;
@@ -93,14 +115,53 @@ struct libinput {
 	int refcount;
 
 	struct list device_group_list;
+	/* struct libinput_device_group with an identifier, by identifier */
+	struct hash_index device_groups;
+
+	struct {
+		const struct libinput_async_interface *interface;
+		struct list pending; /* waiting for the caller */
+		struct list completed; /* waiting for dispatch */
+		struct libinput_source *source;
+		int fd; /* eventfd, signalled on completion */
+	} open;
+
+	/* Set while a soft suspend keeps the devices with their fds
+	 * closed, see evdev_device_session_suspend() */
+	bool session_suspended;
+
+	/* device state loaded by libinput_handoff_load() until a device
+	 * takes it over, struct handoff_entry */
+	struct {
+		struct list entries;
+		struct hash_index index; /* by devnode */
+	} handoff;
+
+	uint64_t stats[LIBINPUT_STAT_COUNT];
+
+	/* If set, libinput_now() returns virtual_time and timers only
+	 * trigger through libinput_timer_advance() */
+	bool use_virtual_time;
+	uint64_t virtual_time;
+	/* If set, only the backend moves the virtual clock */
+	bool virtual_time_locked;
 };
 
 typedef void (*libinput_seat_destroy_func) (struct libinput_seat *seat);
 
+/* Number of bits in enum evdev_device_tags */
+#define LIBINPUT_SEAT_TAG_COUNT 4
+
 struct libinput_seat {
 	struct libinput *libinput;
 	struct list link;
 	struct list devices_list;
+
+	/* The evdev devices of this seat by tag bit and the devices
+	 * whose dispatch pairs with tagged devices, maintained by
+	 * evdev.c so pairing doesn't need to walk all devices */
+	struct list tagged_devices[LIBINPUT_SEAT_TAG_COUNT];
+	struct list pairing_devices;
 	void *user_data;
 	int refcount;
 	libinput_seat_destroy_func destroy;
@@ -111,6 +172,8 @@ struct libinput_seat {
 	uint32_t slot_map;
 
 	uint32_t button_count[KEY_CNT];
+
+	struct libinput_event_queue *event_queue;
 };
 
 struct libinput_device_config_tap {
@@ -234,13 +297,26 @@ struct libinput_device_config {
 };
 
 struct libinput_device_group {
+	struct libinput *libinput;
 	int refcount;
 	void *user_data;
 	char *identifier; /* unique identifier or NULL for singletons */
 
 	struct list link;
+	struct hash_node node; /* only used with an identifier */
+
+	struct libinput_event_queue *event_queue;
+};
+
+enum latency_stage {
+	LATENCY_STAGE_KERNEL_TO_DISPATCH,
+	LATENCY_STAGE_DISPATCH_TO_DEQUEUE,
+	LATENCY_STAGE_COUNT,
 };
 
+/* Number of device event types we keep latency histograms for */
+#define LATENCY_EVENT_TYPE_COUNT 16
+
 struct libinput_device {
 	struct libinput_seat *seat;
 	struct libinput_device_group *group;
@@ -248,12 +324,20 @@ struct libinput_device {
 	struct list event_listeners;
 	void *user_data;
 	int refcount;
+	uint32_t export_id; /* see libinput_device_get_export_id() */
 	struct libinput_device_config config;
+
+	uint64_t stats[LIBINPUT_STAT_COUNT];
+
+	/* allocated on first use */
+	struct latency_histogram *latency[LATENCY_STAGE_COUNT]
+					 [LATENCY_EVENT_TYPE_COUNT];
 };
 
 struct libinput_event {
 	enum libinput_event_type type;
 	struct libinput_device *device;
+	uint64_t post_time; /* 0 if not a device event */
 };
 
 struct libinput_event_listener {
@@ -456,6 +540,9 @@ libinput_now(struct libinput *libinput)
 {
 	struct timespec ts = { 0, 0 };
 
+	if (libinput->use_virtual_time)
+		return libinput->virtual_time;
+
 	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
 		log_error(libinput, "clock_gettime failed: %s\n", strerror(errno));
 		return 0;
@@ -464,6 +551,16 @@ libinput_now(struct libinput *libinput)
 	return s2us(ts.tv_sec) + ns2us(ts.tv_nsec);
 }
 
+/* Add to the device's counter and the context-wide counter */
+static inline void
+device_stat_add(struct libinput_device *device,
+		enum libinput_stat stat,
+		uint64_t value)
+{
+	device->stats[stat] += value;
+	device->seat->libinput->stats[stat] += value;
+}
+
 static inline struct device_float_coords
 device_delta(struct device_coords a, struct device_coords b)
 {
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LIBINPUT_PROBES_H
+#define LIBINPUT_PROBES_H
+
+/*
+ * Static tracepoints, compiled in with --enable-usdt-probes. The probes
+ * use the "libinput" provider and can be listed with e.g.
+ * 	tplist -l /usr/lib/libinput.so
+ * or
+ * 	bpftrace -l 'usdt:/usr/lib/libinput.so:*'
+ *
+ * dispatch_enter(devname)
+ * dispatch_exit(devname, nevents) - nevents is the number of
+ * 		evdev events read in this dispatch
+ * tp_handle_state(devname, time, nfingers_down)
+ * filter_dispatch(in, out, time) - in and out are pointers to the
+ * 		struct normalized_coords before/after acceleration
+ * post_event(type, queue_depth)
+ * timer_expired(lateness) - in us
+ * tap_state(old, event, new)
+ * button_state(slot, old, event, new)
+ * edge_scroll_state(slot, old, event, new)
+ * gesture_state(old, new)
+ * middlebutton_state(old, event, new)
+ *
+ * The state arguments are the numeric values of the respective internal
+ * enums and may change between versions.
+ *
+ * Without probe support, the arguments are never evaluated.
+ */
+
+#ifdef HAVE_USDT_PROBES
+#include <sys/sdt.h>
+
+#define LIBINPUT_PROBE1(name_, a1_) \
+	DTRACE_PROBE1(libinput, name_, a1_)
+#define LIBINPUT_PROBE2(name_, a1_, a2_) \
+	DTRACE_PROBE2(libinput, name_, a1_, a2_)
+#define LIBINPUT_PROBE3(name_, a1_, a2_, a3_) \
+	DTRACE_PROBE3(libinput, name_, a1_, a2_, a3_)
+#define LIBINPUT_PROBE4(name_, a1_, a2_, a3_, a4_) \
+	DTRACE_PROBE4(libinput, name_, a1_, a2_, a3_, a4_)
+#else
+/* Reference the arguments so they don't trigger unused warnings, the
+ * compiler drops the dead code */
+#define LIBINPUT_PROBE1(name_, a1_) \
+	do { if (0) { (void)(a1_); } } while (0)
+#define LIBINPUT_PROBE2(name_, a1_, a2_) \
+	do { if (0) { (void)(a1_); (void)(a2_); } } while (0)
+#define LIBINPUT_PROBE3(name_, a1_, a2_, a3_) \
+	do { if (0) { (void)(a1_); (void)(a2_); (void)(a3_); } } while (0)
+#define LIBINPUT_PROBE4(name_, a1_, a2_, a3_, a4_) \
+	do { if (0) { (void)(a1_); (void)(a2_); (void)(a3_); (void)(a4_); } } while (0)
+#endif
+
+#endif /* LIBINPUT_PROBES_H */
@@ -0,0 +1,288 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LIBINPUT_SHM_RING_H
+#define LIBINPUT_SHM_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @defgroup shm Shared-memory event ring
+ *
+ * Layout of the shared-memory event ring written with
+ * libinput_shm_ring_publish(), and a header-only reader for it. Readers
+ * only need this header, they do not link against libinput.
+ *
+ * Layout:
+ * struct libinput_shm_ring_header		at offset 0
+ * struct libinput_shm_record[capacity]		at offset
+ * 						sizeof(struct libinput_shm_ring_header)
+ *
+ * The ring has a single writer and any number of readers, readers never
+ * write to the ring and never block the writer. Record n (counting from
+ * 0) is stored in slot n % capacity, its seq field is n + 1 once the
+ * record is complete and 0 while it is being written. The header's head
+ * is the number of records written so far.
+ *
+ * A reader that falls more than capacity records behind loses records,
+ * libinput_shm_reader_consume() detects a record that was overwritten
+ * while it was being read. All values are in host byte order.
+ *
+ * @code
+ * struct libinput_shm_reader reader;
+ * const struct libinput_shm_record *record;
+ *
+ * libinput_shm_reader_init(&reader, fd);
+ * while ((record = libinput_shm_reader_peek(&reader))) {
+ *	handle_record(record);
+ *	if (!libinput_shm_reader_consume(&reader, record))
+ *		discard_handled_record();
+ * }
+ * @endcode
+ */
+
+#define LIBINPUT_SHM_RING_MAGIC 0x52534c4c /* "LLSR" */
+#define LIBINPUT_SHM_RING_VERSION 1
+
+/**
+ * @ingroup shm
+ */
+struct libinput_shm_ring_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t record_size; /* sizeof(struct libinput_shm_record) */
+	uint32_t capacity; /* number of records, a power of two */
+	uint64_t head; /* number of records written */
+	uint64_t reserved[5];
+};
+
+/**
+ * @ingroup shm
+ *
+ * A processed event. Which member of the union is valid depends on the
+ * type, device events have no data and a time of 0. Touch coordinates
+ * and absolute pointer coordinates are in mm, see
+ * libinput_event_touch_get_x() and
+ * libinput_event_pointer_get_absolute_x().
+ */
+struct libinput_shm_record {
+	uint64_t seq; /* record number + 1, 0 while being written */
+	uint64_t time_usec;
+	uint32_t type; /* enum libinput_event_type */
+	uint32_t device_id; /* libinput_device_get_export_id() */
+	union {
+		struct {
+			uint32_t key;
+			uint32_t state; /* enum libinput_key_state */
+			uint32_t seat_key_count;
+		} keyboard; /* KEYBOARD_KEY */
+		struct {
+			double dx;
+			double dy;
+			double dx_unaccelerated;
+			double dy_unaccelerated;
+		} motion; /* POINTER_MOTION */
+		struct {
+			double x;
+			double y;
+		} motion_absolute; /* POINTER_MOTION_ABSOLUTE */
+		struct {
+			uint32_t button;
+			uint32_t state; /* enum libinput_button_state */
+			uint32_t seat_button_count;
+		} button; /* POINTER_BUTTON */
+		struct {
+			uint32_t source; /* enum libinput_pointer_axis_source */
+			uint32_t axes; /* 1 << enum libinput_pointer_axis */
+			double value[2]; /* by enum libinput_pointer_axis */
+			double discrete[2];
+		} axis; /* POINTER_AXIS */
+		struct {
+			int32_t slot;
+			int32_t seat_slot;
+			double x; /* TOUCH_DOWN and TOUCH_MOTION only */
+			double y;
+		} touch; /* TOUCH_* but TOUCH_FRAME */
+		struct {
+			int32_t finger_count;
+			int32_t cancelled; /* *_END only */
+			double dx;
+			double dy;
+			double dx_unaccelerated;
+			double dy_unaccelerated;
+			double scale; /* GESTURE_PINCH_* only */
+			double angle_delta; /* GESTURE_PINCH_* only */
+		} gesture; /* GESTURE_* */
+		uint8_t reserved[72];
+	} u;
+};
+
+/**
+ * @ingroup shm
+ *
+ * The state of a reader, see libinput_shm_reader_init().
+ */
+struct libinput_shm_reader {
+	const struct libinput_shm_ring_header *header;
+	const struct libinput_shm_record *records;
+	size_t map_size;
+	uint32_t capacity;
+	uint64_t next; /* number of the next record to read */
+	uint64_t lost; /* records overwritten before they were read */
+};
+
+/**
+ * @ingroup shm
+ *
+ * Map the ring from the fd returned by libinput_shm_ring_get_fd(). The
+ * reader starts with the next record written, records already in the
+ * ring are skipped. The fd may be closed after this call.
+ *
+ * @return 0 on success or a negative errno on failure
+ */
+static inline int
+libinput_shm_reader_init(struct libinput_shm_reader *reader, int fd)
+{
+	const struct libinput_shm_ring_header *header;
+	struct stat st;
+	void *map;
+
+	if (fstat(fd, &st) < 0)
+		return -errno;
+
+	if ((size_t)st.st_size < sizeof(*header))
+		return -EINVAL;
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		return -errno;
+
+	header = (const struct libinput_shm_ring_header *)map;
+	if (header->magic != LIBINPUT_SHM_RING_MAGIC ||
+	    header->version != LIBINPUT_SHM_RING_VERSION ||
+	    header->record_size != sizeof(struct libinput_shm_record) ||
+	    header->capacity == 0 ||
+	    (header->capacity & (header->capacity - 1)) != 0 ||
+	    sizeof(*header) + (size_t)header->capacity * header->record_size >
+			(size_t)st.st_size) {
+		munmap(map, st.st_size);
+		return -EINVAL;
+	}
+
+	reader->header = header;
+	reader->records = (const struct libinput_shm_record *)(header + 1);
+	reader->map_size = st.st_size;
+	reader->capacity = header->capacity;
+	reader->next = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+	reader->lost = 0;
+
+	return 0;
+}
+
+/**
+ * @ingroup shm
+ *
+ * Unmap the ring.
+ */
+static inline void
+libinput_shm_reader_fini(struct libinput_shm_reader *reader)
+{
+	munmap((void *)reader->header, reader->map_size);
+	reader->header = NULL;
+	reader->records = NULL;
+}
+
+/**
+ * @ingroup shm
+ *
+ * Return the next record without copying it, or NULL if the reader has
+ * read all records. Records the reader fell behind on are skipped and
+ * counted in lost. The record may be overwritten while the caller reads
+ * it, the caller must pass it to libinput_shm_reader_consume() before it
+ * relies on what it read.
+ */
+static inline const struct libinput_shm_record *
+libinput_shm_reader_peek(struct libinput_shm_reader *reader)
+{
+	const struct libinput_shm_record *record;
+	uint64_t head, seq;
+
+	while (true) {
+		head = __atomic_load_n(&reader->header->head, __ATOMIC_ACQUIRE);
+		if (reader->next == head)
+			return NULL;
+
+		if (head - reader->next > reader->capacity) {
+			reader->lost += head - reader->capacity - reader->next;
+			reader->next = head - reader->capacity;
+		}
+
+		record = &reader->records[reader->next & (reader->capacity - 1)];
+		seq = __atomic_load_n(&record->seq, __ATOMIC_ACQUIRE);
+		if (seq == reader->next + 1)
+			return record;
+
+		/* overwritten since we read the head */
+		reader->lost++;
+		reader->next++;
+	}
+}
+
+/**
+ * @ingroup shm
+ *
+ * Advance past the record returned by libinput_shm_reader_peek().
+ *
+ * @return true if the record was intact while the caller read it, false
+ * if it was overwritten and what the caller read must be discarded
+ */
+static inline bool
+libinput_shm_reader_consume(struct libinput_shm_reader *reader,
+			    const struct libinput_shm_record *record)
+{
+	uint64_t seq;
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	seq = __atomic_load_n(&record->seq, __ATOMIC_RELAXED);
+	reader->next++;
+
+	if (seq != reader->next) {
+		reader->lost++;
+		return false;
+	}
+
+	return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* LIBINPUT_SHM_RING_H */
@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LIBINPUT_TEST_H
+#define LIBINPUT_TEST_H
+
+#include <stdint.h>
+
+#include "libinput.h"
+
+/*
+ * Hooks for the test suite. These are not exported from libinput.so, they
+ * are only available when linking against the libinput-core convenience
+ * library.
+ */
+
+/*
+ * Switch the context to a virtual clock. The virtual clock starts at the
+ * current time and from then on only moves forward with
+ * libinput_advance_virtual_time(). Timestamps of events read from the
+ * devices are replaced with the virtual time at the time of reading, and
+ * timers no longer wake up the libinput fd, they fire during
+ * libinput_advance_virtual_time() instead.
+ *
+ * A context cannot switch back to the real clock. Replay contexts
+ * already use a virtual clock, this is a noop for them.
+ *
+ * Returns 0 on success or a negative errno on failure.
+ */
+int
+libinput_enable_virtual_time(struct libinput *libinput);
+
+/*
+ * Advance the virtual clock by usec. All timers that expire within that
+ * interval fire in order, each with its own expiry time as the current
+ * time.
+ *
+ * Fails with -EINVAL unless libinput_enable_virtual_time() was called on
+ * this context or the context was created with
+ * libinput_replay_create_manual_context(). Other replay contexts drive
+ * the clock from the recording, it cannot be advanced by the caller.
+ */
+int
+libinput_advance_virtual_time(struct libinput *libinput, uint64_t usec);
+
+/*
+ * Create a replay context that never replays frames on
+ * libinput_dispatch(). Frames are only replayed by libinput_replay_step()
+ * and the virtual clock only moves with the replayed frames and
+ * libinput_advance_virtual_time(). Together with
+ * libinput_replay_device_inject_event() this allows for in-process
+ * devices driven entirely by the caller.
+ */
+struct libinput *
+libinput_replay_create_manual_context(const struct libinput_interface *interface,
+				      void *user_data);
+
+/*
+ * Process an evdev event on a device created by
+ * libinput_replay_add_recording() as if the device had sent it at the
+ * current virtual time. Any libinput events are available with
+ * libinput_get_event() when this function returns.
+ *
+ * Like a kernel device, the event only takes effect once the frame is
+ * terminated by an EV_SYN/SYN_REPORT event, and events with a code the
+ * device does not have are discarded.
+ *
+ * Returns 0 on success, -ENODEV if the device has been removed, or
+ * -EINVAL if the device is not a replay device or the type or code is
+ * out of range.
+ */
+int
+libinput_replay_device_inject_event(struct libinput_device *device,
+				    unsigned int type,
+				    unsigned int code,
+				    int value);
+
+#endif /* LIBINPUT_TEST_H */
@@ -119,6 +119,241 @@ ratelimit_test(struct ratelimit *r)
 	return RATELIMIT_EXCEEDED;
 }
 
+unsigned int
+latency_histogram_bucket(uint64_t value)
+{
+	unsigned int msb;
+	unsigned int sub;
+
+	if (value < LATENCY_HISTOGRAM_SUB_BUCKETS)
+		return value;
+
+	msb = 63 - __builtin_clzll(value);
+	if (msb > 31)
+		return LATENCY_HISTOGRAM_NBUCKETS - 1;
+
+	sub = (value >> (msb - 2)) & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1);
+
+	return (msb - 1) * LATENCY_HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+uint64_t
+latency_histogram_bucket_lower_bound(unsigned int bucket)
+{
+	unsigned int sub = bucket % LATENCY_HISTOGRAM_SUB_BUCKETS;
+	unsigned int shift = bucket / LATENCY_HISTOGRAM_SUB_BUCKETS;
+
+	if (bucket < LATENCY_HISTOGRAM_SUB_BUCKETS)
+		return bucket;
+
+	return (uint64_t)(LATENCY_HISTOGRAM_SUB_BUCKETS + sub) << (shift - 1);
+}
+
+void
+latency_histogram_add(struct latency_histogram *h, uint64_t value)
+{
+	h->buckets[latency_histogram_bucket(value)]++;
+	h->count++;
+	if (value > h->max)
+		h->max = value;
+}
+
+/*
+ * Returns the upper bound of the bucket that contains the given
+ * percentile, capped to the largest value seen. The result is accurate
+ * to within 25% of the real value.
+ */
+uint64_t
+latency_histogram_percentile(const struct latency_histogram *h,
+			     double percentile)
+{
+	uint64_t threshold, sum = 0;
+	unsigned int i;
+
+	if (h->count == 0)
+		return 0;
+
+	if (percentile <= 0.0)
+		percentile = 0.0;
+	else if (percentile >= 100.0)
+		return h->max;
+
+	threshold = (uint64_t)(h->count * percentile / 100.0 + 0.5);
+	if (threshold == 0)
+		threshold = 1;
+
+	for (i = 0; i < LATENCY_HISTOGRAM_NBUCKETS - 1; i++) {
+		sum += h->buckets[i];
+		if (sum >= threshold) {
+			uint64_t upper;
+
+			upper = latency_histogram_bucket_lower_bound(i + 1) - 1;
+			return min(upper, h->max);
+		}
+	}
+
+	return h->max;
+}
+
+uint64_t
+hash_data(uint64_t hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+uint64_t
+hash_string(const char *str)
+{
+	return hash_data(HASH_INIT, str, strlen(str));
+}
+
+/* The finalizer of splitmix64, spreads sequential values like device
+ * numbers across all bits */
+uint64_t
+hash_uint64(uint64_t value)
+{
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ULL;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebULL;
+	value ^= value >> 31;
+
+	return value;
+}
+
+void
+hash_index_init(struct hash_index *index)
+{
+	index->buckets = NULL;
+	index->nbuckets = 0;
+	index->count = 0;
+}
+
+void
+hash_index_destroy(struct hash_index *index)
+{
+	free(index->buckets);
+	hash_index_init(index);
+}
+
+static bool
+hash_index_resize(struct hash_index *index, size_t nbuckets)
+{
+	struct hash_node **buckets, *node, *next;
+	size_t i, b;
+
+	buckets = zalloc(nbuckets * sizeof(*buckets));
+	if (!buckets)
+		return false;
+
+	for (i = 0; i < index->nbuckets; i++) {
+		for (node = index->buckets[i]; node; node = next) {
+			next = node->next;
+			b = node->hash & (nbuckets - 1);
+			node->next = buckets[b];
+			buckets[b] = node;
+		}
+	}
+
+	free(index->buckets);
+	index->buckets = buckets;
+	index->nbuckets = nbuckets;
+
+	return true;
+}
+
+/* Grow the index so it holds count nodes without resizing. Inserting
+ * into an index that has buckets cannot fail. */
+bool
+hash_index_reserve(struct hash_index *index, size_t count)
+{
+	size_t nbuckets = max(index->nbuckets, 16U);
+
+	while (nbuckets < count)
+		nbuckets *= 2;
+
+	if (nbuckets == index->nbuckets)
+		return true;
+
+	return hash_index_resize(index, nbuckets);
+}
+
+/* Returns false if the index has no buckets and allocating them failed.
+ * If growing the index fails, the node is still inserted. */
+bool
+hash_index_insert(struct hash_index *index,
+		  struct hash_node *node,
+		  uint64_t hash)
+{
+	size_t b;
+
+	if (index->count >= index->nbuckets &&
+	    !hash_index_resize(index, max(index->nbuckets * 2, 16U)) &&
+	    index->nbuckets == 0)
+		return false;
+
+	b = hash & (index->nbuckets - 1);
+	node->hash = hash;
+	node->next = index->buckets[b];
+	index->buckets[b] = node;
+	index->count++;
+
+	return true;
+}
+
+void
+hash_index_remove(struct hash_index *index, struct hash_node *node)
+{
+	struct hash_node **p;
+
+	if (index->nbuckets == 0)
+		return;
+
+	p = &index->buckets[node->hash & (index->nbuckets - 1)];
+	while (*p && *p != node)
+		p = &(*p)->next;
+
+	if (*p) {
+		*p = node->next;
+		node->next = NULL;
+		index->count--;
+	}
+}
+
+static struct hash_node *
+hash_node_find(struct hash_node *node, uint64_t hash)
+{
+	while (node && node->hash != hash)
+		node = node->next;
+
+	return node;
+}
+
+/* The first node with the given hash, continue with
+ * hash_index_next() */
+struct hash_node *
+hash_index_first(const struct hash_index *index, uint64_t hash)
+{
+	if (index->nbuckets == 0)
+		return NULL;
+
+	return hash_node_find(index->buckets[hash & (index->nbuckets - 1)],
+			      hash);
+}
+
+struct hash_node *
+hash_index_next(const struct hash_node *node)
+{
+	return hash_node_find(node->next, node->hash);
+}
+
 /* Helper function to parse the mouse DPI tag from udev.
  * The tag is of the form:
  * MOUSE_DPI=400 *1000 2000
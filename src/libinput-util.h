@@ -293,6 +293,55 @@ struct ratelimit {
 void ratelimit_init(struct ratelimit *r, uint64_t ival_ms, unsigned int burst);
 enum ratelimit_state ratelimit_test(struct ratelimit *r);
 
+/* Log-linear histogram of latencies in us: values 0-3 have a bucket
+ * each, every power of two above that is split into 4 linear buckets.
+ * Anything beyond 2^32us ends up in the last bucket. */
+#define LATENCY_HISTOGRAM_SUB_BUCKETS 4
+#define LATENCY_HISTOGRAM_NBUCKETS 124
+
+struct latency_histogram {
+	uint64_t count;
+	uint64_t max;
+	uint64_t buckets[LATENCY_HISTOGRAM_NBUCKETS];
+};
+
+unsigned int latency_histogram_bucket(uint64_t value);
+uint64_t latency_histogram_bucket_lower_bound(unsigned int bucket);
+void latency_histogram_add(struct latency_histogram *h, uint64_t value);
+uint64_t latency_histogram_percentile(const struct latency_histogram *h,
+				      double percentile);
+
+/* 64-bit FNV-1a, start with HASH_INIT */
+#define HASH_INIT 0xcbf29ce484222325ULL
+
+uint64_t hash_data(uint64_t hash, const void *data, size_t len);
+uint64_t hash_string(const char *str);
+uint64_t hash_uint64(uint64_t value);
+
+/* An intrusive hash index. Elements embed a struct hash_node, several
+ * elements may have the same hash, the caller compares the full key. */
+struct hash_node {
+	struct hash_node *next;
+	uint64_t hash;
+};
+
+struct hash_index {
+	struct hash_node **buckets;
+	size_t nbuckets; /* 0 or a power of two */
+	size_t count;
+};
+
+void hash_index_init(struct hash_index *index);
+void hash_index_destroy(struct hash_index *index);
+bool hash_index_reserve(struct hash_index *index, size_t count);
+bool hash_index_insert(struct hash_index *index,
+		       struct hash_node *node,
+		       uint64_t hash);
+void hash_index_remove(struct hash_index *index, struct hash_node *node);
+struct hash_node *hash_index_first(const struct hash_index *index,
+				   uint64_t hash);
+struct hash_node *hash_index_next(const struct hash_node *node);
+
 int parse_mouse_dpi_property(const char *prop);
 int parse_mouse_wheel_click_angle_property(const char *prop);
 double parse_trackpoint_accel_property(const char *prop);
@@ -29,13 +29,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 #include <assert.h>
 
 #include "libinput.h"
 #include "libinput-private.h"
+#include "libinput-test.h"
 #include "evdev.h"
 #include "timer.h"
+#include "open-async.h"
+#include "handoff.h"
+#include "libinput-probes.h"
 
 #define require_event_type(li_, type_, retval_, ...)	\
 	if (type_ == LIBINPUT_EVENT_NONE) abort(); \
@@ -214,6 +219,12 @@ libinput_log_set_handler(struct libinput *libinput,
 static void
 libinput_device_group_destroy(struct libinput_device_group *group);
 
+static bool
+event_ring_init(struct event_ring *ring);
+
+static void
+libinput_event_queue_release(struct libinput_event_queue *queue);
+
 static void
 libinput_post_event(struct libinput *libinput,
 		    struct libinput_event *event);
@@ -932,9 +943,7 @@ libinput_init(struct libinput *libinput,
 	if (libinput->epoll_fd < 0)
 		return -1;
 
-	libinput->events_len = 4;
-	libinput->events = zalloc(libinput->events_len * sizeof(*libinput->events));
-	if (!libinput->events) {
+	if (!event_ring_init(&libinput->events)) {
 		close(libinput->epoll_fd);
 		return -1;
 	}
@@ -948,9 +957,13 @@ libinput_init(struct libinput *libinput,
 	list_init(&libinput->source_destroy_list);
 	list_init(&libinput->seat_list);
 	list_init(&libinput->device_group_list);
+	hash_index_init(&libinput->device_groups);
+	list_init(&libinput->event_queues);
+	handoff_init(libinput);
+	libinput_open_subsys_init(libinput);
 
 	if (libinput_timer_subsys_init(libinput) != 0) {
-		free(libinput->events);
+		free(libinput->events.events);
 		close(libinput->epoll_fd);
 		return -1;
 	}
@@ -988,6 +1001,7 @@ libinput_unref(struct libinput *libinput)
 	struct libinput_device *device, *next_device;
 	struct libinput_seat *seat, *next_seat;
 	struct libinput_device_group *group, *next_group;
+	struct libinput_event_queue *queue, *next_queue;
 
 	if (libinput == NULL)
 		return NULL;
@@ -1004,7 +1018,10 @@ libinput_unref(struct libinput *libinput)
 	while ((event = libinput_get_event(libinput)))
 	       libinput_event_destroy(event);
 
-	free(libinput->events);
+	free(libinput->events.events);
+
+	list_for_each_safe(queue, next_queue, &libinput->event_queues, link)
+		libinput_event_queue_release(queue);
 
 	list_for_each_safe(seat, next_seat, &libinput->seat_list, link) {
 		list_for_each_safe(device, next_device,
@@ -1021,7 +1038,10 @@ libinput_unref(struct libinput *libinput)
 			   link) {
 		libinput_device_group_destroy(group);
 	}
+	hash_index_destroy(&libinput->device_groups);
 
+	handoff_destroy(libinput);
+	libinput_open_subsys_destroy(libinput);
 	libinput_timer_subsys_destroy(libinput);
 	libinput_drop_destroyed_sources(libinput);
 	close(libinput->epoll_fd);
@@ -1074,12 +1094,17 @@ libinput_seat_init(struct libinput_seat *seat,
 		   const char *logical_name,
 		   libinput_seat_destroy_func destroy)
 {
+	size_t i;
+
 	seat->refcount = 1;
 	seat->libinput = libinput;
 	seat->physical_name = strdup(physical_name);
 	seat->logical_name = strdup(logical_name);
 	seat->destroy = destroy;
 	list_init(&seat->devices_list);
+	for (i = 0; i < ARRAY_LENGTH(seat->tagged_devices); i++)
+		list_init(&seat->tagged_devices[i]);
+	list_init(&seat->pairing_devices);
 	list_insert(&libinput->seat_list, &seat->link);
 }
 
@@ -1093,6 +1118,7 @@ libinput_seat_ref(struct libinput_seat *seat)
 static void
 libinput_seat_destroy(struct libinput_seat *seat)
 {
+	libinput_event_queue_unref(seat->event_queue);
 	list_remove(&seat->link);
 	free(seat->logical_name);
 	free(seat->physical_name);
@@ -1148,6 +1174,7 @@ libinput_device_init(struct libinput_device *device,
 {
 	device->seat = seat;
 	device->refcount = 1;
+	device->export_id = ++seat->libinput->last_export_id;
 	list_init(&device->event_listeners);
 }
 
@@ -1161,7 +1188,14 @@ libinput_device_ref(struct libinput_device *device)
 static void
 libinput_device_destroy(struct libinput_device *device)
 {
+	unsigned int stage, type;
+
 	assert(list_empty(&device->event_listeners));
+
+	for (stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+		for (type = 0; type < LATENCY_EVENT_TYPE_COUNT; type++)
+			free(device->latency[stage][type]);
+
 	evdev_device_destroy((struct evdev_device *) device);
 }
 
@@ -1208,6 +1242,40 @@ libinput_dispatch(struct libinput *libinput)
 	return 0;
 }
 
+int
+libinput_enable_virtual_time(struct libinput *libinput)
+{
+	uint64_t now;
+
+	if (libinput->use_virtual_time)
+		return 0;
+
+	now = libinput_now(libinput);
+	if (now == 0)
+		return -EINVAL;
+
+	return libinput_timer_use_virtual_time(libinput, now);
+}
+
+int
+libinput_advance_virtual_time(struct libinput *libinput, uint64_t usec)
+{
+	if (!libinput->use_virtual_time) {
+		log_bug_client(libinput, "Virtual time is not enabled.\n");
+		return -EINVAL;
+	}
+
+	if (libinput->virtual_time_locked) {
+		log_bug_client(libinput,
+			       "Virtual time is driven by the replay.\n");
+		return -EINVAL;
+	}
+
+	libinput_timer_advance(libinput, libinput->virtual_time + usec);
+
+	return 0;
+}
+
 void
 libinput_device_add_event_listener(struct libinput_device *device,
 				   struct libinput_event_listener *listener,
@@ -1279,6 +1347,74 @@ init_event_base(struct libinput_event *event,
 	event->device = device;
 }
 
+static int
+latency_event_type_index(enum libinput_event_type type)
+{
+	switch (type) {
+	case LIBINPUT_EVENT_NONE:
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+	case LIBINPUT_EVENT_DEVICE_REMOVED:
+		break;
+	case LIBINPUT_EVENT_KEYBOARD_KEY:
+		return 0;
+	case LIBINPUT_EVENT_POINTER_MOTION:
+		return 1;
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+		return 2;
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+		return 3;
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		return 4;
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+		return 5;
+	case LIBINPUT_EVENT_TOUCH_UP:
+		return 6;
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+		return 7;
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+		return 8;
+	case LIBINPUT_EVENT_TOUCH_FRAME:
+		return 9;
+	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+		return 10;
+	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+		return 11;
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+		return 12;
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+		return 13;
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+		return 14;
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+		return 15;
+	}
+
+	return -1;
+}
+
+static void
+device_record_latency(struct libinput_device *device,
+		      enum latency_stage stage,
+		      enum libinput_event_type type,
+		      uint64_t latency)
+{
+	struct latency_histogram **h;
+	int idx;
+
+	idx = latency_event_type_index(type);
+	if (idx < 0)
+		return;
+
+	h = &device->latency[stage][idx];
+	if (*h == NULL) {
+		*h = zalloc(sizeof **h);
+		if (*h == NULL)
+			return;
+	}
+
+	latency_histogram_add(*h, latency);
+}
+
 static void
 post_base_event(struct libinput_device *device,
 		enum libinput_event_type type,
@@ -1296,9 +1432,17 @@ post_device_event(struct libinput_device *device,
 		  struct libinput_event *event)
 {
 	struct libinput_event_listener *listener, *tmp;
+	uint64_t now;
 
 	init_event_base(event, device, type);
 
+	now = libinput_now(device->seat->libinput);
+	device_record_latency(device,
+			      LATENCY_STAGE_KERNEL_TO_DISPATCH,
+			      type,
+			      now > time ? now - time : 0);
+	event->post_time = now;
+
 	list_for_each_safe(listener, tmp, &device->event_listeners, link)
 		listener->notify_func(time, event, listener->notify_func_data);
 
@@ -1696,13 +1840,24 @@ gesture_notify_pinch_end(struct libinput_device *device,
 		       finger_count, cancelled, &zero, &zero, scale, 0.0);
 }
 
-static void
-libinput_post_event(struct libinput *libinput,
-		    struct libinput_event *event)
+static bool
+event_ring_init(struct event_ring *ring)
+{
+	ring->len = 4;
+	ring->events = zalloc(ring->len * sizeof(*ring->events));
+	ring->count = 0;
+	ring->in = 0;
+	ring->out = 0;
+
+	return ring->events != NULL;
+}
+
+static bool
+event_ring_push(struct event_ring *ring, struct libinput_event *event)
 {
-	struct libinput_event **events = libinput->events;
-	size_t events_len = libinput->events_len;
-	size_t events_count = libinput->events_count;
+	struct libinput_event **events = ring->events;
+	size_t events_len = ring->len;
+	size_t events_count = ring->count;
 	size_t move_len;
 	size_t new_out;
 
@@ -1710,35 +1865,138 @@ libinput_post_event(struct libinput *libinput,
 	if (events_count > events_len) {
 		events_len *= 2;
 		events = realloc(events, events_len * sizeof *events);
-		if (!events) {
-			log_error(libinput,
-				  "Failed to reallocate event ring buffer. "
-				  "Events may be discarded\n");
-			return;
-		}
+		if (!events)
+			return false;
 
-		if (libinput->events_count > 0 && libinput->events_in == 0) {
-			libinput->events_in = libinput->events_len;
-		} else if (libinput->events_count > 0 &&
-			   libinput->events_out >= libinput->events_in) {
-			move_len = libinput->events_len - libinput->events_out;
+		if (ring->count > 0 && ring->in == 0) {
+			ring->in = ring->len;
+		} else if (ring->count > 0 && ring->out >= ring->in) {
+			move_len = ring->len - ring->out;
 			new_out = events_len - move_len;
 			memmove(events + new_out,
-				events + libinput->events_out,
+				events + ring->out,
 				move_len * sizeof *events);
-			libinput->events_out = new_out;
+			ring->out = new_out;
 		}
 
-		libinput->events = events;
-		libinput->events_len = events_len;
+		ring->events = events;
+		ring->len = events_len;
+	}
+
+	ring->count = events_count;
+	events[ring->in] = event;
+	ring->in = (ring->in + 1) % ring->len;
+
+	return true;
+}
+
+static struct libinput_event *
+event_ring_pop(struct event_ring *ring)
+{
+	struct libinput_event *event;
+
+	if (ring->count == 0)
+		return NULL;
+
+	event = ring->events[ring->out];
+	ring->out = (ring->out + 1) % ring->len;
+	ring->count--;
+
+	return event;
+}
+
+static inline enum libinput_event_type
+event_ring_next_type(struct event_ring *ring)
+{
+	if (ring->count == 0)
+		return LIBINPUT_EVENT_NONE;
+
+	return ring->events[ring->out]->type;
+}
+
+/* A device group's queue takes precedence over the seat's queue */
+static inline struct libinput_event_queue *
+libinput_device_get_event_queue(struct libinput_device *device)
+{
+	if (device->group && device->group->event_queue)
+		return device->group->event_queue;
+
+	return device->seat->event_queue;
+}
+
+static void
+libinput_event_queue_signal(struct libinput_event_queue *queue)
+{
+	uint64_t one = 1;
+
+	if (write(queue->fd, &one, sizeof(one)) != sizeof(one))
+		log_bug_libinput(queue->libinput,
+				 "failed to signal event queue: %s\n",
+				 strerror(errno));
+}
+
+static void
+libinput_event_queue_clear_signal(struct libinput_event_queue *queue)
+{
+	uint64_t value;
+
+	if (read(queue->fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+		log_bug_libinput(queue->libinput,
+				 "failed to clear event queue: %s\n",
+				 strerror(errno));
+}
+
+static void
+libinput_post_event(struct libinput *libinput,
+		    struct libinput_event *event)
+{
+	struct libinput_event_queue *queue = NULL;
+	struct event_ring *ring = &libinput->events;
+
+	if (event->device) {
+		queue = libinput_device_get_event_queue(event->device);
+		if (queue)
+			ring = &queue->events;
+	}
+
+	if (!event_ring_push(ring, event)) {
+		log_error(libinput,
+			  "Failed to reallocate event ring buffer. "
+			  "Events may be discarded\n");
+		return;
 	}
 
 	if (event->device)
 		libinput_device_ref(event->device);
 
-	libinput->events_count = events_count;
-	events[libinput->events_in] = event;
-	libinput->events_in = (libinput->events_in + 1) % libinput->events_len;
+	/* The eventfd stays readable until the queue is drained */
+	if (queue && ring->count == 1)
+		libinput_event_queue_signal(queue);
+
+	libinput->stats[LIBINPUT_STAT_EVENTS_POSTED]++;
+	if (event->device)
+		event->device->stats[LIBINPUT_STAT_EVENTS_POSTED]++;
+	if (ring->count > libinput->stats[LIBINPUT_STAT_QUEUE_HIGH_WATER_MARK])
+		libinput->stats[LIBINPUT_STAT_QUEUE_HIGH_WATER_MARK] = ring->count;
+
+	LIBINPUT_PROBE2(post_event, event->type, ring->count);
+}
+
+static void
+libinput_event_record_dequeue(struct libinput *libinput,
+			      struct libinput_event *event)
+{
+	uint64_t now;
+
+	if (event->post_time == 0)
+		return;
+
+	now = libinput_now(libinput);
+	device_record_latency(event->device,
+			      LATENCY_STAGE_DISPATCH_TO_DEQUEUE,
+			      event->type,
+			      now > event->post_time ?
+				      now - event->post_time : 0);
 }
 
 LIBINPUT_EXPORT struct libinput_event *
@@ -1746,27 +2004,201 @@ libinput_get_event(struct libinput *libinput)
 {
 	struct libinput_event *event;
 
-	if (libinput->events_count == 0)
-		return NULL;
-
-	event = libinput->events[libinput->events_out];
-	libinput->events_out =
-		(libinput->events_out + 1) % libinput->events_len;
-	libinput->events_count--;
+	event = event_ring_pop(&libinput->events);
+	if (event)
+		libinput_event_record_dequeue(libinput, event);
 
 	return event;
 }
 
 LIBINPUT_EXPORT enum libinput_event_type
 libinput_next_event_type(struct libinput *libinput)
+{
+	return event_ring_next_type(&libinput->events);
+}
+
+LIBINPUT_EXPORT struct libinput_event_queue *
+libinput_event_queue_create(struct libinput *libinput)
+{
+	struct libinput_event_queue *queue;
+
+	queue = zalloc(sizeof *queue);
+	if (!queue)
+		return NULL;
+
+	if (!event_ring_init(&queue->events)) {
+		free(queue);
+		return NULL;
+	}
+
+	queue->fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (queue->fd < 0) {
+		free(queue->events.events);
+		free(queue);
+		return NULL;
+	}
+
+	queue->libinput = libinput;
+	queue->refcount = 1;
+	list_insert(&libinput->event_queues, &queue->link);
+
+	return queue;
+}
+
+LIBINPUT_EXPORT struct libinput_event_queue *
+libinput_event_queue_ref(struct libinput_event_queue *queue)
+{
+	queue->refcount++;
+	return queue;
+}
+
+/* Destroy the queued events and detach the queue from its context,
+ * the struct itself stays around until the last reference is gone */
+static void
+libinput_event_queue_release(struct libinput_event_queue *queue)
 {
 	struct libinput_event *event;
 
-	if (libinput->events_count == 0)
-		return LIBINPUT_EVENT_NONE;
+	if (!queue->libinput)
+		return;
 
-	event = libinput->events[libinput->events_out];
-	return event->type;
+	while ((event = event_ring_pop(&queue->events)))
+		libinput_event_destroy(event);
+	free(queue->events.events);
+	queue->events.events = NULL;
+
+	close(queue->fd);
+	queue->fd = -1;
+
+	list_remove(&queue->link);
+	queue->libinput = NULL;
+}
+
+LIBINPUT_EXPORT struct libinput_event_queue *
+libinput_event_queue_unref(struct libinput_event_queue *queue)
+{
+	if (queue == NULL)
+		return NULL;
+
+	assert(queue->refcount > 0);
+	queue->refcount--;
+	if (queue->refcount > 0)
+		return queue;
+
+	libinput_event_queue_release(queue);
+	free(queue);
+
+	return NULL;
+}
+
+LIBINPUT_EXPORT int
+libinput_event_queue_get_fd(struct libinput_event_queue *queue)
+{
+	return queue->fd;
+}
+
+LIBINPUT_EXPORT struct libinput_event *
+libinput_event_queue_get_event(struct libinput_event_queue *queue)
+{
+	struct libinput_event *event;
+
+	event = event_ring_pop(&queue->events);
+	if (!event)
+		return NULL;
+
+	if (queue->events.count == 0)
+		libinput_event_queue_clear_signal(queue);
+
+	libinput_event_record_dequeue(queue->libinput, event);
+
+	return event;
+}
+
+LIBINPUT_EXPORT enum libinput_event_type
+libinput_event_queue_next_event_type(struct libinput_event_queue *queue)
+{
+	return event_ring_next_type(&queue->events);
+}
+
+static void
+libinput_event_queue_replace(struct libinput *libinput,
+			     struct libinput_event_queue **current,
+			     struct libinput_event_queue *queue)
+{
+	if (queue && queue->libinput != libinput) {
+		log_bug_client(libinput,
+			       "Event queue of a different context.\n");
+		return;
+	}
+
+	if (queue)
+		libinput_event_queue_ref(queue);
+	libinput_event_queue_unref(*current);
+	*current = queue;
+}
+
+LIBINPUT_EXPORT void
+libinput_seat_set_event_queue(struct libinput_seat *seat,
+			      struct libinput_event_queue *queue)
+{
+	libinput_event_queue_replace(seat->libinput,
+				     &seat->event_queue,
+				     queue);
+}
+
+LIBINPUT_EXPORT void
+libinput_device_group_set_event_queue(struct libinput_device_group *group,
+				      struct libinput_event_queue *queue)
+{
+	libinput_event_queue_replace(group->libinput,
+				     &group->event_queue,
+				     queue);
+}
+
+struct libinput_stats {
+	uint64_t stats[LIBINPUT_STAT_COUNT];
+};
+
+static struct libinput_stats *
+stats_snapshot(const uint64_t *counters)
+{
+	struct libinput_stats *stats;
+
+	stats = zalloc(sizeof *stats);
+	if (!stats)
+		return NULL;
+
+	memcpy(stats->stats, counters, sizeof(stats->stats));
+
+	return stats;
+}
+
+LIBINPUT_EXPORT struct libinput_stats *
+libinput_get_stats(struct libinput *libinput)
+{
+	return stats_snapshot(libinput->stats);
+}
+
+LIBINPUT_EXPORT struct libinput_stats *
+libinput_device_get_stats(struct libinput_device *device)
+{
+	return stats_snapshot(device->stats);
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_stats_get_value(struct libinput_stats *stats,
+			 enum libinput_stat stat)
+{
+	if (stat < LIBINPUT_STAT_EVDEV_EVENTS || stat >= LIBINPUT_STAT_COUNT)
+		return 0;
+
+	return stats->stats[stat];
+}
+
+LIBINPUT_EXPORT void
+libinput_stats_destroy(struct libinput_stats *stats)
+{
+	free(stats);
 }
 
 LIBINPUT_EXPORT void
@@ -1824,6 +2256,12 @@ libinput_device_get_sysname(struct libinput_device *device)
 	return evdev_device_get_sysname((struct evdev_device *) device);
 }
 
+LIBINPUT_EXPORT uint32_t
+libinput_device_get_export_id(struct libinput_device *device)
+{
+	return device->export_id;
+}
+
 LIBINPUT_EXPORT const char *
 libinput_device_get_name(struct libinput_device *device)
 {
@@ -1898,6 +2336,131 @@ libinput_device_get_size(struct libinput_device *device,
 				     height);
 }
 
+LIBINPUT_EXPORT int
+libinput_device_predict_pointer(struct libinput_device *device,
+				uint64_t time,
+				double *dx,
+				double *dy)
+{
+	return evdev_device_predict_pointer((struct evdev_device *)device,
+					    time,
+					    dx,
+					    dy);
+}
+
+struct libinput_latency_histogram {
+	struct latency_histogram histogram;
+};
+
+LIBINPUT_EXPORT struct libinput_latency_histogram *
+libinput_device_get_latency_histogram(struct libinput_device *device,
+				      enum libinput_event_type type,
+				      enum libinput_latency_stage stage)
+{
+	struct libinput_latency_histogram *snapshot;
+	struct latency_histogram *h;
+	enum latency_stage s;
+	int idx;
+
+	switch (stage) {
+	case LIBINPUT_LATENCY_STAGE_KERNEL_TO_DISPATCH:
+		s = LATENCY_STAGE_KERNEL_TO_DISPATCH;
+		break;
+	case LIBINPUT_LATENCY_STAGE_DISPATCH_TO_DEQUEUE:
+		s = LATENCY_STAGE_DISPATCH_TO_DEQUEUE;
+		break;
+	default:
+		return NULL;
+	}
+
+	idx = latency_event_type_index(type);
+	if (idx < 0)
+		return NULL;
+
+	snapshot = zalloc(sizeof *snapshot);
+	if (!snapshot)
+		return NULL;
+
+	h = device->latency[s][idx];
+	if (h)
+		snapshot->histogram = *h;
+
+	return snapshot;
+}
+
+LIBINPUT_EXPORT void
+libinput_device_reset_latency_histograms(struct libinput_device *device)
+{
+	unsigned int stage, type;
+
+	for (stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+		for (type = 0; type < LATENCY_EVENT_TYPE_COUNT; type++) {
+			struct latency_histogram *h;
+
+			h = device->latency[stage][type];
+			if (h)
+				memset(h, 0, sizeof(*h));
+		}
+	}
+}
+
+LIBINPUT_EXPORT void
+libinput_latency_histogram_destroy(struct libinput_latency_histogram *histogram)
+{
+	free(histogram);
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_latency_histogram_get_count(struct libinput_latency_histogram *histogram)
+{
+	return histogram->histogram.count;
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_latency_histogram_get_max(struct libinput_latency_histogram *histogram)
+{
+	return histogram->histogram.max;
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_latency_histogram_get_percentile(struct libinput_latency_histogram *histogram,
+					  double percentile)
+{
+	return latency_histogram_percentile(&histogram->histogram, percentile);
+}
+
+LIBINPUT_EXPORT unsigned int
+libinput_latency_histogram_get_bucket_count(struct libinput_latency_histogram *histogram)
+{
+	return LATENCY_HISTOGRAM_NBUCKETS;
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_latency_histogram_get_bucket_lower_bound(struct libinput_latency_histogram *histogram,
+						  unsigned int bucket)
+{
+	if (bucket >= LATENCY_HISTOGRAM_NBUCKETS)
+		return 0;
+
+	return latency_histogram_bucket_lower_bound(bucket);
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_latency_histogram_get_bucket_value(struct libinput_latency_histogram *histogram,
+					    unsigned int bucket)
+{
+	if (bucket >= LATENCY_HISTOGRAM_NBUCKETS)
+		return 0;
+
+	return histogram->histogram.buckets[bucket];
+}
+
+LIBINPUT_EXPORT int
+libinput_device_dump_trace(struct libinput_device *device, int fd)
+{
+	return evdev_device_dump_trace((struct evdev_device *)device, fd);
+}
+
 LIBINPUT_EXPORT int
 libinput_device_pointer_has_button(struct libinput_device *device, uint32_t code)
 {
@@ -1988,12 +2551,17 @@ libinput_device_group_create(struct libinput *libinput,
 	group->refcount = 1;
 	if (identifier) {
 		group->identifier = strdup(identifier);
-		if (!group->identifier) {
+		if (!group->identifier ||
+		    !hash_index_insert(&libinput->device_groups,
+				       &group->node,
+				       hash_string(identifier))) {
+			free(group->identifier);
 			free(group);
 			return NULL;
 		}
 	}
 
+	group->libinput = libinput;
 	list_init(&group->link);
 	list_insert(&libinput->device_group_list, &group->link);
 
@@ -2004,13 +2572,19 @@ struct libinput_device_group *
 libinput_device_group_find_group(struct libinput *libinput,
 				 const char *identifier)
 {
-	struct libinput_device_group *g = NULL;
+	struct libinput_device_group *g;
+	struct hash_node *node;
+
+	if (!identifier)
+		return NULL;
 
-	list_for_each(g, &libinput->device_group_list, link) {
-		if (identifier && g->identifier &&
-		    streq(g->identifier, identifier)) {
+	for (node = hash_index_first(&libinput->device_groups,
+				     hash_string(identifier));
+	     node;
+	     node = hash_index_next(node)) {
+		g = container_of(node, g, node);
+		if (streq(g->identifier, identifier))
 			return g;
-		}
 	}
 
 	return NULL;
@@ -2028,6 +2602,10 @@ static void
 libinput_device_group_destroy(struct libinput_device_group *group)
 {
 	list_remove(&group->link);
+	if (group->identifier)
+		hash_index_remove(&group->libinput->device_groups,
+				  &group->node);
+	libinput_event_queue_unref(group->event_queue);
 	free(group->identifier);
 	free(group);
 }
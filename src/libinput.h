@@ -215,6 +215,26 @@ struct libinput_device;
  */
 struct libinput_device_group;
 
+/**
+ * @ingroup base
+ * @struct libinput_event_queue
+ *
+ * A queue that receives the events of some seats or device groups
+ * instead of the context's queue, see libinput_seat_set_event_queue().
+ * This struct is refcounted, use libinput_event_queue_ref() and
+ * libinput_event_queue_unref().
+ */
+struct libinput_event_queue;
+
+/**
+ * @ingroup base
+ * @struct libinput_shm_ring
+ *
+ * A ring of events in shared memory for readers in other processes, see
+ * libinput_shm_ring_create().
+ */
+struct libinput_shm_ring;
+
 /**
  * @ingroup seat
  * @struct libinput_seat
@@ -1207,6 +1227,99 @@ struct libinput_interface {
 	void (*close_restricted)(int fd, void *user_data);
 };
 
+/**
+ * @ingroup base
+ * @struct libinput_open_request
+ *
+ * A pending request to open a device, see libinput_async_interface.
+ */
+struct libinput_open_request;
+
+/**
+ * @ingroup base
+ * @struct libinput_async_interface
+ *
+ * An alternative to @ref libinput_interface::open_restricted for callers
+ * that cannot open a device without blocking, e.g. because the device is
+ * opened through an IPC call. libinput requests the fd and continues
+ * once the caller completes the request with
+ * libinput_open_request_complete(). Many requests may be pending at the
+ * same time.
+ *
+ * File descriptors are still closed with @ref
+ * libinput_interface::close_restricted.
+ *
+ * @see libinput_set_async_interface
+ */
+struct libinput_async_interface {
+	/**
+	 * Start opening the device at the given path with the flags
+	 * provided. The caller must complete the request with
+	 * libinput_open_request_complete() exactly once, either from
+	 * within this function or later from the thread that uses the
+	 * context.
+	 *
+	 * @param request The request to complete
+	 * @param path The device path to open
+	 * @param flags Flags as defined by open(2)
+	 * @param user_data The user_data provided in
+	 * libinput_udev_create_context()
+	 */
+	void (*open_restricted_async)(struct libinput_open_request *request,
+				      const char *path,
+				      int flags,
+				      void *user_data);
+};
+
+/**
+ * @ingroup base
+ *
+ * Use the async interface to open devices. This must be called before
+ * libinput_udev_assign_seat(). Devices are added once the caller
+ * completed their open request and libinput_dispatch() was called,
+ * which happens automatically since a completed request makes the
+ * libinput fd readable.
+ *
+ * The async interface is used for devices added through the udev
+ * backend, including devices re-opened by libinput_resume(). Devices
+ * added with libinput_path_add_device() and devices re-enabled through
+ * libinput_device_config_send_events_set_mode() are opened with @ref
+ * libinput_interface::open_restricted.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param interface The async interface, must remain valid for the
+ * lifetime of the context
+ *
+ * @return 0 on success or -1 on failure
+ */
+int
+libinput_set_async_interface(struct libinput *libinput,
+			     const struct libinput_async_interface *interface);
+
+/**
+ * @ingroup base
+ *
+ * Complete a request started through @ref
+ * libinput_async_interface::open_restricted_async. libinput takes
+ * ownership of the fd. If libinput no longer needs the device, e.g.
+ * because it was unplugged or the context was suspended or destroyed
+ * in the meantime, the fd is closed with @ref
+ * libinput_interface::close_restricted.
+ *
+ * The request is freed by libinput and must not be used after this call.
+ *
+ * This function is not thread-safe, it modifies the context the request
+ * belongs to. It must be called from the thread that uses the context,
+ * e.g. from the caller's main loop once the fd is available, never from
+ * a helper thread that opened the device.
+ *
+ * @param request The request to complete
+ * @param fd The file descriptor, or a negative errno on failure
+ */
+void
+libinput_open_request_complete(struct libinput_open_request *request,
+			       int fd);
+
 /**
  * @ingroup base
  *
@@ -1238,18 +1351,80 @@ libinput_udev_create_context(const struct libinput_interface *interface,
  * device are ignored. Such devices and those that failed to open
  * ignored until the next call to libinput_resume().
  *
- * This function may only be called once per context.
+ * This function may only be called once per context, and not together
+ * with libinput_udev_assign_seats().
  *
  * @param libinput A libinput context initialized with
  * libinput_udev_create_context()
  * @param seat_id A seat identifier. This string must not be NULL.
  *
  * @return 0 on success or -1 on failure.
+ *
+ * @see libinput_udev_assign_seats
  */
 int
 libinput_udev_assign_seat(struct libinput *libinput,
 			  const char *seat_id);
 
+/**
+ * @ingroup base
+ *
+ * Assign several seats to this libinput context, see
+ * libinput_udev_assign_seat(). A single context then handles the
+ * devices of all these seats with one udev monitor and one set of
+ * timers, instead of one context per seat.
+ *
+ * Each device is added to a @ref libinput_seat with the device's seat
+ * as physical name, see libinput_seat_get_physical_name(). Devices with
+ * the same logical seat name on different physical seats are in
+ * different @ref libinput_seat objects.
+ *
+ * This function may only be called once per context, and not together
+ * with libinput_udev_assign_seat().
+ *
+ * @param libinput A libinput context initialized with
+ * libinput_udev_create_context()
+ * @param seat_ids A NULL-terminated list of seat identifiers, or NULL to
+ * handle the devices of all seats. The list must not be empty.
+ *
+ * @return 0 on success or -1 on failure.
+ */
+int
+libinput_udev_assign_seats(struct libinput *libinput,
+			   const char * const *seat_ids);
+
+/**
+ * @ingroup base
+ *
+ * Enable or disable soft suspend for this libinput context. By default,
+ * libinput_suspend() removes all devices and libinput_resume() adds all
+ * devices present at the time as new devices.
+ *
+ * With soft suspend enabled, libinput_suspend() only closes the file
+ * descriptors of the devices through @ref
+ * libinput_interface::close_restricted but keeps the devices, their
+ * configuration and their device groups. No @ref
+ * LIBINPUT_EVENT_DEVICE_REMOVED events are sent. libinput_resume()
+ * re-opens the devices that are still present, sends a @ref
+ * LIBINPUT_EVENT_DEVICE_REMOVED event for each device that disappeared or
+ * was replaced while suspended and a @ref LIBINPUT_EVENT_DEVICE_ADDED
+ * event for each new device.
+ *
+ * Keys and buttons held down while the context is suspended are released
+ * on suspend, as with the default behavior.
+ *
+ * @param libinput A libinput context initialized with
+ * libinput_udev_create_context()
+ * @param enable Non-zero to enable soft suspend, zero to disable it
+ *
+ * @return 0 on success or -1 on failure.
+ *
+ * @see libinput_suspend
+ * @see libinput_resume
+ */
+int
+libinput_udev_set_soft_suspend(struct libinput *libinput, int enable);
+
 /**
  * @ingroup base
  *
@@ -1297,6 +1472,60 @@ struct libinput_device *
 libinput_path_add_device(struct libinput *libinput,
 			 const char *path);
 
+/**
+ * @ingroup base
+ *
+ * The function called once a device added with
+ * libinput_path_add_device_async() was added, or failed to be added.
+ *
+ * @param libinput The libinput context
+ * @param path The path passed to libinput_path_add_device_async()
+ * @param device The new device or NULL on failure. The lifetime of the
+ * device pointer is limited as for libinput_path_add_device().
+ * @param user_data The user_data passed to
+ * libinput_path_add_device_async()
+ */
+typedef void (*libinput_path_device_added_func)(struct libinput *libinput,
+						const char *path,
+						struct libinput_device *device,
+						void *user_data);
+
+/**
+ * @ingroup base
+ *
+ * Add a device to a libinput context initialized with
+ * libinput_path_create_context() without waiting for udev.
+ *
+ * libinput_path_add_device() blocks until udev has finished processing
+ * the device, which may take a while for a device that was just
+ * created. This function returns immediately instead. The device is
+ * added during libinput_dispatch() once udev is done with it, or after
+ * a timeout of two seconds. Devices added this way behave exactly like
+ * devices added with libinput_path_add_device(), including the @ref
+ * LIBINPUT_EVENT_DEVICE_ADDED event.
+ *
+ * The notify function is called during libinput_dispatch() with the new
+ * device or with NULL if the device could not be added. It is not
+ * called if the context is destroyed first.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param path Path to an input device
+ * @param notify The function to call once the device was added, may be
+ * NULL
+ * @param user_data Caller-specific data passed to notify
+ *
+ * @return 0 on success or a negative errno if the path is not a device
+ * or the context cannot monitor udev.
+ *
+ * @note It is an application bug to call this function on a libinput
+ * context initialized with libinput_udev_create_context().
+ */
+int
+libinput_path_add_device_async(struct libinput *libinput,
+			       const char *path,
+			       libinput_path_device_added_func notify,
+			       void *user_data);
+
 /**
  * @ingroup base
  *
@@ -1318,6 +1547,118 @@ libinput_path_add_device(struct libinput *libinput,
 void
 libinput_path_remove_device(struct libinput_device *device);
 
+/**
+ * @ingroup base
+ *
+ * The speed at which a context created with
+ * libinput_replay_create_context() replays its recordings.
+ */
+enum libinput_replay_pace {
+	/**
+	 * Replay the recordings as fast as possible. Timers trigger in
+	 * recorded time, independent of the actual time.
+	 */
+	LIBINPUT_REPLAY_PACE_FAST = 1,
+	/**
+	 * Replay each frame at the time it was recorded, relative to the
+	 * start of the replay.
+	 */
+	LIBINPUT_REPLAY_PACE_RECORDED,
+};
+
+/**
+ * @ingroup base
+ *
+ * Create a new libinput context that replays recordings written by the
+ * libinput-record tool instead of reading from actual devices. Recordings
+ * are added with libinput_replay_add_recording(), each recording creates
+ * one device. No device nodes are opened, the replay does not require
+ * access to /dev/input or /dev/uinput.
+ *
+ * The context uses a virtual clock driven by the recorded timestamps,
+ * all event timestamps and timeouts are in recorded time. The recording
+ * is replayed as the caller calls libinput_dispatch(), with @ref
+ * LIBINPUT_REPLAY_PACE_FAST each call to libinput_dispatch() replays
+ * frames until a number of events is queued.
+ *
+ * The reference count of the context is initialized to 1. See @ref
+ * libinput_unref.
+ *
+ * @param interface The callback interface, may be NULL. The recordings
+ * are not opened through @ref libinput_interface::open_restricted.
+ * @param user_data Caller-specific data passed to the various callback
+ * interfaces.
+ * @param pace The speed of the replay
+ *
+ * @return An initialized, empty libinput context or NULL on failure.
+ *
+ * @see libinput_replay_is_finished
+ */
+struct libinput *
+libinput_replay_create_context(const struct libinput_interface *interface,
+			       void *user_data,
+			       enum libinput_replay_pace pace);
+
+/**
+ * @ingroup base
+ *
+ * Add a recording to a libinput context initialized with
+ * libinput_replay_create_context(). The recording's device is created
+ * from the recorded device description and udev properties and its first
+ * frame is replayed at the current time of the replay. Multiple
+ * recordings are replayed interleaved by their timestamps.
+ *
+ * The lifetime of the returned device pointer is limited until
+ * the next libinput_dispatch(), use libinput_device_ref() to keep a
+ * permanent reference.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param path Path to a recording
+ * @return The newly initiated device on success, or NULL on failure.
+ *
+ * @note It is an application bug to call this function on a libinput
+ * context not initialized with libinput_replay_create_context().
+ */
+struct libinput_device *
+libinput_replay_add_recording(struct libinput *libinput,
+			      const char *path);
+
+/**
+ * @ingroup base
+ *
+ * Check if a libinput context initialized with
+ * libinput_replay_create_context() has replayed all frames of all
+ * recordings and all timers resulting from the replay have expired.
+ * Events may still be pending, the caller should call
+ * libinput_get_event() until it returns NULL.
+ *
+ * @param libinput A previously initialized libinput context
+ * @return Non-zero if the replay has finished, zero otherwise
+ */
+int
+libinput_replay_is_finished(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Replay the next frame of a libinput context initialized with
+ * libinput_replay_create_context() immediately, independent of the
+ * pace of the context. Timers that expire before the frame trigger
+ * first. Once all frames are replayed, the remaining timers are
+ * triggered and the replay is finished.
+ *
+ * Events generated by the frame are available with
+ * libinput_get_event() when this function returns, libinput_dispatch()
+ * is not required.
+ *
+ * @param libinput A previously initialized libinput context
+ * @return 1 if a frame was replayed, 0 if no frame was left to replay
+ *
+ * @see libinput_replay_is_finished
+ */
+int
+libinput_replay_step(struct libinput *libinput);
+
 /**
  * @ingroup base
  *
@@ -1377,6 +1718,318 @@ libinput_get_event(struct libinput *libinput);
 enum libinput_event_type
 libinput_next_event_type(struct libinput *libinput);
 
+/**
+ * @ingroup base
+ *
+ * Create a new event queue. The queue is empty until it is assigned to a
+ * seat with libinput_seat_set_event_queue() or to a device group with
+ * libinput_device_group_set_event_queue(). The events of that seat or
+ * device group are then only available through
+ * libinput_event_queue_get_event(), not through libinput_get_event().
+ *
+ * Events are still only processed in libinput_dispatch() and all queues
+ * of a context must be used from the thread that dispatches the context.
+ * A router can dispatch the context and leave each queue to a different
+ * consumer that only waits on the fd of its queue.
+ *
+ * The queue is emptied and its fd is closed when the context is
+ * destroyed, the queue itself stays valid until its last reference is
+ * dropped.
+ *
+ * @param libinput A previously initialized libinput context
+ * @return A new event queue with a refcount of 1, or NULL on failure
+ */
+struct libinput_event_queue *
+libinput_event_queue_create(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Add a reference to the event queue.
+ *
+ * @param queue A previously created event queue
+ * @return The passed event queue
+ */
+struct libinput_event_queue *
+libinput_event_queue_ref(struct libinput_event_queue *queue);
+
+/**
+ * @ingroup base
+ *
+ * Drop a reference to the event queue. Seats and device groups keep a
+ * reference to their event queue, a queue is only destroyed once it is
+ * no longer assigned to any seat or device group.
+ *
+ * @param queue A previously created event queue, may be NULL
+ * @return NULL if the queue was destroyed, otherwise the passed queue
+ */
+struct libinput_event_queue *
+libinput_event_queue_unref(struct libinput_event_queue *queue);
+
+/**
+ * @ingroup base
+ *
+ * Return an eventfd that is readable while events are available in this
+ * queue. Unlike the fd from libinput_get_fd(), this fd only signals
+ * processed events and the caller must not call libinput_dispatch()
+ * when it becomes readable.
+ *
+ * @param queue A previously created event queue
+ * @return The file descriptor, or -1 after the context was destroyed
+ */
+int
+libinput_event_queue_get_fd(struct libinput_event_queue *queue);
+
+/**
+ * @ingroup base
+ *
+ * Retrieve the next event from this queue, see libinput_get_event().
+ *
+ * @param queue A previously created event queue
+ * @return The next available event, or NULL if no event is available.
+ */
+struct libinput_event *
+libinput_event_queue_get_event(struct libinput_event_queue *queue);
+
+/**
+ * @ingroup base
+ *
+ * Return the type of the next event in this queue, see
+ * libinput_next_event_type().
+ *
+ * @param queue A previously created event queue
+ * @return The event type of the next available event or @ref
+ * LIBINPUT_EVENT_NONE if no event is available.
+ */
+enum libinput_event_type
+libinput_event_queue_next_event_type(struct libinput_event_queue *queue);
+
+/**
+ * @ingroup base
+ *
+ * Create a ring buffer in shared memory that events are published to with
+ * libinput_shm_ring_publish(). Other processes map the ring from the fd
+ * returned by libinput_shm_ring_get_fd() and read the events as
+ * fixed-layout records without a copy and without syscalls, see
+ * libinput-shm-ring.h. Readers that fall behind by more than capacity
+ * records lose records, the writer never waits for readers.
+ *
+ * The ring must be destroyed before its context.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param capacity The number of records in the ring, rounded up to the
+ * next power of two, at most 2^20
+ * @return A new ring or NULL on failure
+ */
+struct libinput_shm_ring *
+libinput_shm_ring_create(struct libinput *libinput, unsigned int capacity);
+
+/**
+ * @ingroup base
+ *
+ * Destroy the ring. Readers that mapped the ring keep their mapping, no
+ * further records are published to it.
+ *
+ * @param ring A ring created with libinput_shm_ring_create(), may be NULL
+ */
+void
+libinput_shm_ring_destroy(struct libinput_shm_ring *ring);
+
+/**
+ * @ingroup base
+ *
+ * Return a read-only fd of the ring to pass to readers. The fd is owned
+ * by the ring, pass a duplicate to other processes. The ring is sealed
+ * against resizing and readers cannot map it writable.
+ *
+ * @param ring A ring created with libinput_shm_ring_create()
+ * @return The file descriptor of the ring
+ */
+int
+libinput_shm_ring_get_fd(struct libinput_shm_ring *ring);
+
+/**
+ * @ingroup base
+ *
+ * Publish the event as the next record of the ring. The caller still owns
+ * the event and must destroy it with libinput_event_destroy().
+ *
+ * @param ring A ring created with libinput_shm_ring_create()
+ * @param event The event to publish
+ * @return 0 on success or -EINVAL if the event type cannot be published
+ */
+int
+libinput_shm_ring_publish(struct libinput_shm_ring *ring,
+			  struct libinput_event *event);
+
+/**
+ * @ingroup base
+ *
+ * Statistics counters, see libinput_get_stats() and
+ * libinput_device_get_stats(). All counters are cumulative from the
+ * creation of the context or the device, respectively. The counters of a
+ * context include the counters of devices that have since been removed.
+ */
+enum libinput_stat {
+	/**
+	 * The number of evdev events read from the kernel.
+	 */
+	LIBINPUT_STAT_EVDEV_EVENTS = 1,
+	/**
+	 * The number of evdev frames (EV_SYN/SYN_REPORT) processed.
+	 */
+	LIBINPUT_STAT_FRAMES,
+	/**
+	 * The number of times the kernel buffer overflowed and events were
+	 * lost (EV_SYN/SYN_DROPPED).
+	 */
+	LIBINPUT_STAT_SYN_DROPPED,
+	/**
+	 * The number of libinput events added to the event queue.
+	 */
+	LIBINPUT_STAT_EVENTS_POSTED,
+	/**
+	 * The number of evdev events that were merged into an event already
+	 * pending, e.g. a REL_Y following a REL_X within the same frame.
+	 */
+	LIBINPUT_STAT_EVENTS_MERGED,
+	/**
+	 * The largest number of events in the event queue at any time.
+	 * This counter is always 0 for a device.
+	 */
+	LIBINPUT_STAT_QUEUE_HIGH_WATER_MARK,
+	/**
+	 * The number of times libinput woke up to handle internal timers.
+	 * This counter is always 0 for a device.
+	 */
+	LIBINPUT_STAT_TIMER_WAKEUPS,
+	/**
+	 * The number of internal timers that were handled more than 5ms
+	 * after their expiry time. Late timers usually indicate that the
+	 * caller does not call libinput_dispatch() in time.
+	 * This counter is always 0 for a device.
+	 */
+	LIBINPUT_STAT_TIMERS_LATE,
+	/**
+	 * The time in microseconds spent processing evdev events in the
+	 * device-specific event processing, e.g. the touchpad handling.
+	 * The time is taken per frame, from the first event of the frame
+	 * to its SYN_REPORT.
+	 */
+	LIBINPUT_STAT_DISPATCH_TIME,
+};
+
+/**
+ * @ingroup base
+ * @struct libinput_stats
+ *
+ * A snapshot of statistics counters, see libinput_get_stats() and
+ * libinput_device_get_stats().
+ */
+struct libinput_stats;
+
+/**
+ * @ingroup base
+ *
+ * Return a snapshot of the statistics counters of this context. The
+ * snapshot does not change when the counters are updated.
+ *
+ * The returned object must be freed by the caller with
+ * libinput_stats_destroy().
+ *
+ * @param libinput A previously initialized libinput context
+ * @return A snapshot of the context's counters, or NULL on failure
+ *
+ * @see libinput_device_get_stats
+ */
+struct libinput_stats *
+libinput_get_stats(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Return the value of the given counter.
+ *
+ * @param stats A statistics snapshot
+ * @param stat The counter to return
+ * @return The counter's value, or 0 if the counter is invalid
+ */
+uint64_t
+libinput_stats_get_value(struct libinput_stats *stats,
+			 enum libinput_stat stat);
+
+/**
+ * @ingroup base
+ *
+ * Destroy the statistics snapshot.
+ *
+ * @param stats A statistics snapshot, may be NULL
+ */
+void
+libinput_stats_destroy(struct libinput_stats *stats);
+
+/**
+ * @ingroup base
+ *
+ * Write the state of the devices of this context to fd so that a new
+ * context, usually in a new process, can take the devices over with
+ * libinput_handoff_load(). The state of each device holds the keys and
+ * buttons that are logically down, the seat slots of the current touches and
+ * the pointer acceleration history.
+ *
+ * The fds of the devices are not part of the state. The caller passes
+ * them to the new process, e.g. inherited or over a unix socket, and
+ * returns them from the new context's
+ * libinput_interface::open_restricted for the same device node. The
+ * fds must not be closed by this context's
+ * libinput_interface::close_restricted. Events that arrive after
+ * libinput_handoff_save() are not seen by this context and should not
+ * be read by the caller, the new context discards them when it adds
+ * the device.
+ *
+ * Devices without a device node, e.g. devices replayed from a
+ * recording, are not written.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param fd The fd to write to, e.g. a memfd, a pipe or a socket
+ * @return 0 on success or a negative errno on failure
+ *
+ * @see libinput_handoff_load
+ */
+int
+libinput_handoff_save(struct libinput *libinput, int fd);
+
+/**
+ * @ingroup base
+ *
+ * Read the device state written by libinput_handoff_save() from fd.
+ * This must be called before the devices are added, i.e. before
+ * libinput_udev_assign_seat() or libinput_path_add_device().
+ *
+ * A device added afterwards with a device node in the state takes the
+ * state over if it is still the same device, i.e. its identity, axis
+ * ranges and the udev properties libinput derives its configuration
+ * from did not change. Keys, buttons and touches that are still down
+ * continue in this context, their release events are sent and the
+ * seat-wide counts include them. Keys, buttons and touches that ended
+ * while no context was reading the device end with events sent right
+ * after the @ref LIBINPUT_EVENT_DEVICE_ADDED event of the device.
+ *
+ * Keys and buttons are only carried over for keyboards, mice and
+ * other devices without a touchpad or tablet-specific handling.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param fd The fd to read from
+ * @return 0 on success or a negative errno on failure. -EINVAL
+ * indicates that the data is not a valid state, e.g. because it was
+ * written by a different version of libinput. The context is unchanged
+ * on failure and devices are added as usual.
+ *
+ * @see libinput_handoff_save
+ */
+int
+libinput_handoff_load(struct libinput *libinput, int fd);
+
 /**
  * @ingroup base
  *
@@ -1410,6 +2063,9 @@ libinput_get_user_data(struct libinput *libinput);
  * Resume a suspended libinput context. This re-enables device
  * monitoring and adds existing devices.
  *
+ * For a context with soft suspend enabled, devices kept while suspended
+ * are re-opened instead, see libinput_udev_set_soft_suspend().
+ *
  * @param libinput A previously initialized libinput context
  * @see libinput_suspend
  *
@@ -1425,6 +2081,9 @@ libinput_resume(struct libinput *libinput);
  * This all but terminates libinput but does keep the context
  * valid to be resumed with libinput_resume().
  *
+ * For a context with soft suspend enabled, the devices are closed but
+ * not removed, see libinput_udev_set_soft_suspend().
+ *
  * @param libinput A previously initialized libinput context
  */
 void
@@ -1654,6 +2313,22 @@ libinput_seat_get_physical_name(struct libinput_seat *seat);
 const char *
 libinput_seat_get_logical_name(struct libinput_seat *seat);
 
+/**
+ * @ingroup seat
+ *
+ * Route the events of all devices in this seat to the given queue. Events
+ * already queued stay in their queue. A queue assigned to a device's
+ * group with libinput_device_group_set_event_queue() takes precedence
+ * over the seat's queue.
+ *
+ * @param seat A previously obtained seat
+ * @param queue An event queue of the seat's context, or NULL to route
+ * the events to the context's queue again
+ */
+void
+libinput_seat_set_event_queue(struct libinput_seat *seat,
+			      struct libinput_event_queue *queue);
+
 /**
  * @defgroup device Initialization and manipulation of input devices
  */
@@ -1800,6 +2475,18 @@ libinput_device_get_device_group(struct libinput_device *device);
 const char *
 libinput_device_get_sysname(struct libinput_device *device);
 
+/**
+ * @ingroup device
+ *
+ * Get the id of the device in the records of a @ref libinput_shm_ring.
+ * The id is unique within the context and not reused for another device.
+ *
+ * @param device A previously obtained device
+ * @return A non-zero id of the device
+ */
+uint32_t
+libinput_device_get_export_id(struct libinput_device *device);
+
 /**
  * @ingroup device
  *
@@ -1964,6 +2651,238 @@ libinput_device_get_size(struct libinput_device *device,
 			 double *width,
 			 double *height);
 
+/**
+ * @ingroup device
+ *
+ * Predict the relative pointer motion of a @ref
+ * LIBINPUT_DEVICE_CAP_POINTER device between the most recent @ref
+ * LIBINPUT_EVENT_POINTER_MOTION event and the given time. A caller may
+ * add the prediction to the cursor position to place the cursor where it
+ * is expected to be at the time the frame is displayed, rather than
+ * where it was at the time the last event was read.
+ *
+ * The prediction extrapolates the velocity of the current motion. A
+ * pause or a change in direction starts a new motion and no prediction
+ * is available until the new motion has enough events. The velocity is
+ * damped according to how steady the current motion is and the
+ * prediction is limited to a short time horizon, callers should not use
+ * this function to predict more than one or two frames ahead.
+ *
+ * The prediction is accelerated, i.e. it is in the same coordinate space
+ * as libinput_event_pointer_get_dx() and libinput_event_pointer_get_dy().
+ * The prediction is not part of the event stream and is never included
+ * in any future event.
+ *
+ * @param device A current input device
+ * @param time The time to predict the motion for in microseconds, in the
+ * same clock domain as libinput_event_pointer_get_time_usec()
+ * @param dx Set to the predicted relative motion in x direction
+ * @param dy Set to the predicted relative motion in y direction
+ *
+ * @return 0 on success, or nonzero if no prediction is available. If this
+ * function returns nonzero, dx and dy are set to 0.
+ */
+int
+libinput_device_predict_pointer(struct libinput_device *device,
+				uint64_t time,
+				double *dx,
+				double *dy);
+
+/**
+ * @ingroup device
+ *
+ * Write the recent internal state machine transitions of this device to
+ * the given file descriptor. libinput keeps a fixed number of the most
+ * recent transitions of the tapping, software button, edge scrolling,
+ * gesture and middle button emulation state machines. The trace is
+ * intended to be attached to bug reports, e.g. when a tap was not
+ * detected.
+ *
+ * The data is in a binary format internal to libinput and may change
+ * between versions. Use the decode-trace tool from the same version of
+ * libinput to convert it to human-readable form.
+ *
+ * @param device A current input device
+ * @param fd A file descriptor open for writing
+ * @return 0 on success, or a negative errno on failure
+ */
+int
+libinput_device_dump_trace(struct libinput_device *device, int fd);
+
+/**
+ * @ingroup device
+ *
+ * Return a snapshot of the statistics counters of this device. The
+ * snapshot does not change when the counters are updated.
+ *
+ * The returned object must be freed by the caller with
+ * libinput_stats_destroy().
+ *
+ * @param device A current input device
+ * @return A snapshot of the device's counters, or NULL on failure
+ *
+ * @see libinput_get_stats
+ */
+struct libinput_stats *
+libinput_device_get_stats(struct libinput_device *device);
+
+/**
+ * @ingroup device
+ *
+ * The stage of the event pipeline a latency histogram applies to, see
+ * libinput_device_get_latency_histogram().
+ */
+enum libinput_latency_stage {
+	/**
+	 * The time between the timestamp of an event and the time libinput
+	 * queues the event. For events generated from kernel events this is
+	 * the time between the kernel timestamp and the time the caller
+	 * calls libinput_dispatch(). For events generated by internal
+	 * timeouts, this is the time the timeout fired late.
+	 */
+	LIBINPUT_LATENCY_STAGE_KERNEL_TO_DISPATCH = 1,
+	/**
+	 * The time between libinput queuing the event and the caller
+	 * retrieving it with libinput_get_event().
+	 */
+	LIBINPUT_LATENCY_STAGE_DISPATCH_TO_DEQUEUE,
+};
+
+/**
+ * @ingroup device
+ * @struct libinput_latency_histogram
+ *
+ * A snapshot of the latencies of one event type on one device, see
+ * libinput_device_get_latency_histogram().
+ *
+ * Latencies are recorded in microseconds in log-linear buckets: the values
+ * 0 to 3 have a bucket each, each power of two above is split into four
+ * buckets of equal size. The error of any value obtained from the
+ * histogram is thus at most 25%.
+ */
+struct libinput_latency_histogram;
+
+/**
+ * @ingroup device
+ *
+ * Return a snapshot of the latencies recorded for the given event type on
+ * this device. libinput records the latencies of all events from the
+ * time the device is added, the histogram is a copy and does not change
+ * when further events are processed.
+ *
+ * The returned histogram must be freed by the caller with
+ * libinput_latency_histogram_destroy().
+ *
+ * @param device A current input device
+ * @param type The event type, one of the event types generated by
+ * devices, i.e. not @ref LIBINPUT_EVENT_DEVICE_ADDED or @ref
+ * LIBINPUT_EVENT_DEVICE_REMOVED
+ * @param stage The pipeline stage to return the latencies for
+ *
+ * @return A new histogram, or NULL if the event type or stage is invalid.
+ * If no events of this type were recorded, the histogram is empty.
+ *
+ * @see libinput_device_reset_latency_histograms
+ */
+struct libinput_latency_histogram *
+libinput_device_get_latency_histogram(struct libinput_device *device,
+				      enum libinput_event_type type,
+				      enum libinput_latency_stage stage);
+
+/**
+ * @ingroup device
+ *
+ * Discard all latencies recorded on this device so far. Snapshots
+ * previously obtained with libinput_device_get_latency_histogram() are
+ * not affected.
+ *
+ * @param device A current input device
+ */
+void
+libinput_device_reset_latency_histograms(struct libinput_device *device);
+
+/**
+ * @ingroup device
+ *
+ * Destroy the histogram.
+ *
+ * @param histogram A histogram returned by
+ * libinput_device_get_latency_histogram(), may be NULL
+ */
+void
+libinput_latency_histogram_destroy(struct libinput_latency_histogram *histogram);
+
+/**
+ * @ingroup device
+ *
+ * @param histogram A latency histogram
+ * @return The number of latencies recorded in this histogram
+ */
+uint64_t
+libinput_latency_histogram_get_count(struct libinput_latency_histogram *histogram);
+
+/**
+ * @ingroup device
+ *
+ * @param histogram A latency histogram
+ * @return The largest latency recorded in this histogram in microseconds,
+ * or 0 if the histogram is empty
+ */
+uint64_t
+libinput_latency_histogram_get_max(struct libinput_latency_histogram *histogram);
+
+/**
+ * @ingroup device
+ *
+ * Return the latency that the given percentage of recorded latencies is
+ * less than or equal to, e.g. a percentile of 99.0 returns the latency
+ * 99% of the events did not exceed.
+ *
+ * @param histogram A latency histogram
+ * @param percentile The percentile in the range [0, 100]
+ * @return The latency in microseconds, or 0 if the histogram is empty
+ */
+uint64_t
+libinput_latency_histogram_get_percentile(struct libinput_latency_histogram *histogram,
+					  double percentile);
+
+/**
+ * @ingroup device
+ *
+ * @param histogram A latency histogram
+ * @return The number of buckets in this histogram
+ */
+unsigned int
+libinput_latency_histogram_get_bucket_count(struct libinput_latency_histogram *histogram);
+
+/**
+ * @ingroup device
+ *
+ * Return the smallest latency in microseconds that is counted in the
+ * given bucket. A bucket covers all latencies up to the lower bound of
+ * the next bucket.
+ *
+ * @param histogram A latency histogram
+ * @param bucket The bucket index, less than
+ * libinput_latency_histogram_get_bucket_count()
+ * @return The lower bound of the bucket in microseconds
+ */
+uint64_t
+libinput_latency_histogram_get_bucket_lower_bound(struct libinput_latency_histogram *histogram,
+						  unsigned int bucket);
+
+/**
+ * @ingroup device
+ *
+ * @param histogram A latency histogram
+ * @param bucket The bucket index, less than
+ * libinput_latency_histogram_get_bucket_count()
+ * @return The number of latencies recorded in the given bucket
+ */
+uint64_t
+libinput_latency_histogram_get_bucket_value(struct libinput_latency_histogram *histogram,
+					    unsigned int bucket);
+
 /**
  * @ingroup device
  *
@@ -2054,6 +2973,21 @@ libinput_device_group_set_user_data(struct libinput_device_group *group,
 void *
 libinput_device_group_get_user_data(struct libinput_device_group *group);
 
+/**
+ * @ingroup device
+ *
+ * Route the events of all devices in this group to the given queue, see
+ * libinput_seat_set_event_queue(). The group's queue takes precedence
+ * over the queue of the device's seat.
+ *
+ * @param group A previously obtained device group
+ * @param queue An event queue of the group's context, or NULL to route
+ * the events to the seat's or the context's queue again
+ */
+void
+libinput_device_group_set_event_queue(struct libinput_device_group *group,
+				      struct libinput_event_queue *queue);
+
 /**
  * @defgroup config Device configuration
  *
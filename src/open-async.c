@@ -0,0 +1,219 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "libinput-private.h"
+#include "open-async.h"
+
+static void
+libinput_open_request_free(struct libinput_open_request *request)
+{
+	if (request->fd >= 0)
+		request->close_restricted(request->fd, request->user_data);
+
+	free(request);
+}
+
+static void
+libinput_open_handler(void *data)
+{
+	struct libinput *libinput = data;
+	struct libinput_open_request *request;
+	uint64_t count;
+	int fd;
+
+	if (read(libinput->open.fd, &count, sizeof(count)) < 0 &&
+	    errno != EAGAIN) {
+		log_error(libinput,
+			  "open: eventfd read error: %s\n",
+			  strerror(errno));
+		return;
+	}
+
+	/* done() may start new requests or cancel pending ones, so only
+	 * ever take the first completed request */
+	while (!list_empty(&libinput->open.completed)) {
+		request = container_of(libinput->open.completed.next,
+				       request,
+				       link);
+		list_remove(&request->link);
+
+		if (request->done) {
+			fd = request->fd;
+			request->fd = -1;
+			request->done(libinput, fd, request->data);
+		}
+
+		libinput_open_request_free(request);
+	}
+}
+
+bool
+libinput_has_async_open(struct libinput *libinput)
+{
+	return libinput->open.interface != NULL;
+}
+
+struct libinput_open_request *
+libinput_open_async(struct libinput *libinput,
+		    const char *path,
+		    int flags,
+		    libinput_open_done_func done,
+		    void *data)
+{
+	struct libinput_open_request *request;
+
+	assert(libinput_has_async_open(libinput));
+
+	request = zalloc(sizeof *request);
+	if (!request)
+		return NULL;
+
+	request->libinput = libinput;
+	request->done = done;
+	request->data = data;
+	request->fd = -1;
+	request->close_restricted = libinput->interface->close_restricted;
+	request->user_data = libinput->user_data;
+	list_insert(libinput->open.pending.prev, &request->link);
+
+	/* may complete the request immediately, done() is only called
+	 * from the next dispatch */
+	libinput->open.interface->open_restricted_async(request,
+							path,
+							flags,
+							libinput->user_data);
+
+	return request;
+}
+
+void
+libinput_open_request_cancel(struct libinput_open_request *request)
+{
+	request->done = NULL;
+	request->data = NULL;
+}
+
+LIBINPUT_EXPORT void
+libinput_open_request_complete(struct libinput_open_request *request,
+			       int fd)
+{
+	struct libinput *libinput = request->libinput;
+	uint64_t one = 1;
+
+	if (request->completed) {
+		if (libinput)
+			log_bug_client(libinput,
+				       "open request completed twice\n");
+		return;
+	}
+
+	request->completed = true;
+	request->fd = fd;
+
+	/* the context is gone, nobody is waiting for this fd */
+	if (!libinput) {
+		libinput_open_request_free(request);
+		return;
+	}
+
+	list_remove(&request->link);
+	list_insert(libinput->open.completed.prev, &request->link);
+
+	if (write(libinput->open.fd, &one, sizeof(one)) < 0)
+		log_error(libinput,
+			  "open: eventfd write error: %s\n",
+			  strerror(errno));
+}
+
+LIBINPUT_EXPORT int
+libinput_set_async_interface(struct libinput *libinput,
+			     const struct libinput_async_interface *interface)
+{
+	if (!interface || !interface->open_restricted_async) {
+		log_bug_client(libinput, "Invalid async interface.\n");
+		return -1;
+	}
+
+	if (!libinput->open.source) {
+		libinput->open.fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (libinput->open.fd < 0)
+			return -1;
+
+		libinput->open.source = libinput_add_fd(libinput,
+							libinput->open.fd,
+							libinput_open_handler,
+							libinput);
+		if (!libinput->open.source) {
+			close(libinput->open.fd);
+			libinput->open.fd = -1;
+			return -1;
+		}
+	}
+
+	libinput->open.interface = interface;
+
+	return 0;
+}
+
+void
+libinput_open_subsys_init(struct libinput *libinput)
+{
+	list_init(&libinput->open.pending);
+	list_init(&libinput->open.completed);
+	libinput->open.interface = NULL;
+	libinput->open.source = NULL;
+	libinput->open.fd = -1;
+}
+
+void
+libinput_open_subsys_destroy(struct libinput *libinput)
+{
+	struct libinput_open_request *request, *tmp;
+
+	list_for_each_safe(request, tmp, &libinput->open.completed, link) {
+		list_remove(&request->link);
+		libinput_open_request_free(request);
+	}
+
+	/* The caller still holds these, they are freed when completed */
+	list_for_each_safe(request, tmp, &libinput->open.pending, link) {
+		list_remove(&request->link);
+		request->libinput = NULL;
+		libinput_open_request_cancel(request);
+	}
+
+	if (libinput->open.source) {
+		libinput_remove_source(libinput, libinput->open.source);
+		close(libinput->open.fd);
+	}
+}
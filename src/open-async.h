@@ -0,0 +1,80 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef OPEN_ASYNC_H
+#define OPEN_ASYNC_H
+
+#include <stdbool.h>
+
+#include "libinput-util.h"
+
+struct libinput;
+
+/* Called from libinput_dispatch() with the fd or a negative errno once
+ * the caller completed the request. The fd belongs to the callee. */
+typedef void (*libinput_open_done_func)(struct libinput *libinput,
+					int fd,
+					void *data);
+
+struct libinput_open_request {
+	/* NULL once the context was destroyed */
+	struct libinput *libinput;
+	struct list link; /* libinput::open.pending or open.completed */
+	/* NULL once the request was cancelled */
+	libinput_open_done_func done;
+	void *data;
+	bool completed;
+	int fd;
+
+	/* to close an fd completed after the context was destroyed */
+	void (*close_restricted)(int fd, void *user_data);
+	void *user_data;
+};
+
+/* True if the caller set an async interface, see
+ * libinput_set_async_interface() */
+bool
+libinput_has_async_open(struct libinput *libinput);
+
+/* Ask the caller to open path. done is called from libinput_dispatch()
+ * once the caller completed the request, never from within this
+ * function. Returns NULL on allocation failure. */
+struct libinput_open_request *
+libinput_open_async(struct libinput *libinput,
+		    const char *path,
+		    int flags,
+		    libinput_open_done_func done,
+		    void *data);
+
+/* done will not be called for this request and an fd completed for
+ * it is closed. The request must not be used afterwards. */
+void
+libinput_open_request_cancel(struct libinput_open_request *request);
+
+void
+libinput_open_subsys_init(struct libinput *libinput);
+
+void
+libinput_open_subsys_destroy(struct libinput *libinput);
+
+#endif
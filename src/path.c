@@ -25,8 +25,11 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdint.h>
 #include <string.h>
+#include <sys/eventfd.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <libudev.h>
 
 #include "path.h"
@@ -35,6 +38,9 @@
 static const char default_seat[] = "seat0";
 static const char default_seat_name[] = "default";
 
+/* How long libinput_path_add_device_async() waits for udev */
+#define PATH_UDEV_INIT_TIMEOUT ms2us(2000)
+
 int path_input_process_event(struct libinput_event);
 static void path_seat_destroy(struct libinput_seat *seat);
 
@@ -194,11 +200,18 @@ path_input_enable(struct libinput *libinput)
 	return 0;
 }
 
+static void
+path_pending_device_destroy(struct path_pending_device *pending);
+
 static void
 path_input_destroy(struct libinput *input)
 {
 	struct path_input *path_input = (struct path_input*)input;
 	struct path_device *dev, *tmp;
+	struct path_pending_device *pending, *next;
+
+	list_for_each_safe(pending, next, &path_input->pending.list, link)
+		path_pending_device_destroy(pending);
 
 	udev_unref(path_input->udev);
 
@@ -206,9 +219,44 @@ path_input_destroy(struct libinput *input)
 		udev_device_unref(dev->udev_device);
 		free(dev);
 	}
+	hash_index_destroy(&path_input->devices);
 
 }
 
+static inline uint64_t
+path_device_hash(struct udev_device *udev_device)
+{
+	return hash_uint64(udev_device_get_devnum(udev_device));
+}
+
+static struct path_device *
+path_find_device(struct path_input *input,
+		 struct udev_device *udev_device)
+{
+	struct hash_node *node;
+	struct path_device *dev;
+
+	for (node = hash_index_first(&input->devices,
+				     path_device_hash(udev_device));
+	     node;
+	     node = hash_index_next(node)) {
+		dev = container_of(node, dev, node);
+		if (dev->udev_device == udev_device)
+			return dev;
+	}
+
+	return NULL;
+}
+
+static void
+path_device_destroy(struct path_input *input, struct path_device *dev)
+{
+	hash_index_remove(&input->devices, &dev->node);
+	list_remove(&dev->link);
+	udev_device_unref(dev->udev_device);
+	free(dev);
+}
+
 static struct libinput_device *
 path_create_device(struct libinput *libinput,
 		   struct udev_device *udev_device,
@@ -222,17 +270,21 @@ path_create_device(struct libinput *libinput,
 	if (!dev)
 		return NULL;
 
+	if (!hash_index_insert(&input->devices,
+			       &dev->node,
+			       path_device_hash(udev_device))) {
+		free(dev);
+		return NULL;
+	}
+
 	dev->udev_device = udev_device_ref(udev_device);
 
 	list_insert(&input->path_list, &dev->link);
 
 	device = path_device_enable(input, udev_device, seat_name);
 
-	if (!device) {
-		udev_device_unref(dev->udev_device);
-		list_remove(&dev->link);
-		free(dev);
-	}
+	if (!device)
+		path_device_destroy(input, dev);
 
 	return device;
 }
@@ -288,6 +340,9 @@ libinput_path_create_context(const struct libinput_interface *interface,
 
 	input->udev = udev;
 	list_init(&input->path_list);
+	hash_index_init(&input->devices);
+	list_init(&input->pending.list);
+	input->pending.fd = -1;
 
 	return &input->base;
 }
@@ -353,6 +408,277 @@ libinput_path_add_device(struct libinput *libinput,
 	return device;
 }
 
+static void
+path_pending_unwatch(struct path_input *input)
+{
+	if (input->pending.monitor_source) {
+		libinput_remove_source(&input->base,
+				       input->pending.monitor_source);
+		input->pending.monitor_source = NULL;
+	}
+
+	if (input->pending.monitor) {
+		udev_monitor_unref(input->pending.monitor);
+		input->pending.monitor = NULL;
+	}
+
+	if (input->pending.source) {
+		libinput_remove_source(&input->base, input->pending.source);
+		input->pending.source = NULL;
+	}
+
+	if (input->pending.fd != -1) {
+		close(input->pending.fd);
+		input->pending.fd = -1;
+	}
+}
+
+static void
+path_pending_device_destroy(struct path_pending_device *pending)
+{
+	struct path_input *input = pending->input;
+
+	libinput_timer_cancel(&pending->timeout);
+	list_remove(&pending->link);
+	if (pending->udev_device)
+		udev_device_unref(pending->udev_device);
+	free(pending->path);
+	free(pending);
+
+	if (list_empty(&input->pending.list))
+		path_pending_unwatch(input);
+}
+
+static void
+path_pending_device_add(struct path_pending_device *pending)
+{
+	struct libinput *libinput = &pending->input->base;
+	struct libinput_device *device = NULL;
+
+	if (pending->udev_device &&
+	    !ignore_litest_test_suite_device(pending->udev_device))
+		device = path_create_device(libinput,
+					    pending->udev_device,
+					    NULL);
+
+	if (pending->notify)
+		pending->notify(libinput,
+				pending->path,
+				device,
+				pending->user_data);
+
+	path_pending_device_destroy(pending);
+}
+
+/* Add all devices that udev finished with */
+static void
+path_pending_flush(struct path_input *input)
+{
+	struct path_pending_device *pending;
+	bool found = true;
+
+	/* notify may add or remove pending devices */
+	while (found) {
+		found = false;
+		list_for_each(pending, &input->pending.list, link) {
+			if (pending->udev_device) {
+				path_pending_device_add(pending);
+				found = true;
+				break;
+			}
+		}
+	}
+}
+
+static void
+path_pending_timeout(uint64_t now, void *data)
+{
+	struct path_pending_device *pending = data;
+	struct path_input *input = pending->input;
+
+	/* Like libinput_path_add_device(), use the device even if udev
+	 * never finished with it */
+	log_bug_libinput(&input->base,
+			 "udev device never initialized (%s)\n",
+			 pending->path);
+	pending->udev_device = udev_device_new_from_devnum(input->udev,
+							   'c',
+							   pending->devnum);
+	if (!pending->udev_device)
+		log_info(&input->base,
+			 "failed to find udev device for '%s'.\n",
+			 pending->path);
+
+	path_pending_device_add(pending);
+}
+
+static void
+path_pending_dispatch(void *data)
+{
+	struct path_input *input = data;
+	uint64_t count;
+
+	if (read(input->pending.fd, &count, sizeof(count)) < 0 &&
+	    errno != EAGAIN)
+		log_error(&input->base,
+			  "path: eventfd read error: %s\n",
+			  strerror(errno));
+
+	path_pending_flush(input);
+}
+
+static void
+path_pending_udev_handler(void *data)
+{
+	struct path_input *input = data;
+	struct udev_device *udev_device;
+	struct path_pending_device *pending;
+	dev_t devnum;
+
+	udev_device = udev_monitor_receive_device(input->pending.monitor);
+	if (!udev_device)
+		return;
+
+	devnum = udev_device_get_devnum(udev_device);
+	list_for_each(pending, &input->pending.list, link) {
+		if (pending->udev_device || pending->devnum != devnum)
+			continue;
+
+		if (!udev_device_get_is_initialized(udev_device))
+			continue;
+
+		pending->udev_device = udev_device_ref(udev_device);
+		libinput_timer_cancel(&pending->timeout);
+	}
+
+	udev_device_unref(udev_device);
+
+	path_pending_flush(input);
+}
+
+static int
+path_pending_watch(struct path_input *input)
+{
+	int fd;
+
+	if (input->pending.monitor)
+		return 0;
+
+	input->pending.monitor = udev_monitor_new_from_netlink(input->udev,
+							       "udev");
+	if (!input->pending.monitor)
+		goto err;
+
+	udev_monitor_filter_add_match_subsystem_devtype(input->pending.monitor,
+							"input",
+							NULL);
+	if (udev_monitor_enable_receiving(input->pending.monitor))
+		goto err;
+
+	fd = udev_monitor_get_fd(input->pending.monitor);
+	input->pending.monitor_source =
+		libinput_add_fd(&input->base,
+				fd,
+				path_pending_udev_handler,
+				input);
+	if (!input->pending.monitor_source)
+		goto err;
+
+	input->pending.fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (input->pending.fd < 0)
+		goto err;
+
+	input->pending.source = libinput_add_fd(&input->base,
+						input->pending.fd,
+						path_pending_dispatch,
+						input);
+	if (!input->pending.source)
+		goto err;
+
+	return 0;
+
+err:
+	log_error(&input->base, "path: failed to monitor udev\n");
+	path_pending_unwatch(input);
+	return -ENOMEM;
+}
+
+LIBINPUT_EXPORT int
+libinput_path_add_device_async(struct libinput *libinput,
+			       const char *path,
+			       libinput_path_device_added_func notify,
+			       void *user_data)
+{
+	struct path_input *input = (struct path_input *)libinput;
+	struct path_pending_device *pending;
+	struct udev_device *udev_device;
+	struct stat st;
+	uint64_t one = 1;
+	int rc;
+
+	if (libinput->interface_backend != &interface_backend) {
+		log_bug_client(libinput, "Mismatching backends.\n");
+		return -EINVAL;
+	}
+
+	if (stat(path, &st) < 0)
+		rc = -errno;
+	else if (!S_ISCHR(st.st_mode))
+		rc = -ENODEV;
+	else
+		rc = 0;
+
+	if (rc != 0) {
+		log_bug_client(libinput, "Invalid path %s\n", path);
+		return rc;
+	}
+
+	/* Watch first so we cannot miss udev finishing with the device
+	 * between the check below and the monitor being set up */
+	rc = path_pending_watch(input);
+	if (rc != 0)
+		return rc;
+
+	pending = zalloc(sizeof *pending);
+	if (pending)
+		pending->path = strdup(path);
+	if (!pending || !pending->path) {
+		free(pending);
+		if (list_empty(&input->pending.list))
+			path_pending_unwatch(input);
+		return -ENOMEM;
+	}
+
+	pending->input = input;
+	pending->devnum = st.st_rdev;
+	pending->notify = notify;
+	pending->user_data = user_data;
+	libinput_timer_init(&pending->timeout,
+			    libinput,
+			    path_pending_timeout,
+			    pending);
+	list_insert(input->pending.list.prev, &pending->link);
+
+	udev_device = udev_device_new_from_devnum(input->udev,
+						  'c',
+						  st.st_rdev);
+	if (udev_device && udev_device_get_is_initialized(udev_device)) {
+		pending->udev_device = udev_device;
+		if (write(input->pending.fd, &one, sizeof(one)) < 0)
+			log_error(libinput,
+				  "path: eventfd write error: %s\n",
+				  strerror(errno));
+	} else {
+		if (udev_device)
+			udev_device_unref(udev_device);
+		libinput_timer_set(&pending->timeout,
+				   libinput_now(libinput) +
+				   PATH_UDEV_INIT_TIMEOUT);
+	}
+
+	return 0;
+}
+
 LIBINPUT_EXPORT void
 libinput_path_remove_device(struct libinput_device *device)
 {
@@ -367,14 +693,9 @@ libinput_path_remove_device(struct libinput_device *device)
 		return;
 	}
 
-	list_for_each(dev, &input->path_list, link) {
-		if (dev->udev_device == evdev->udev_device) {
-			list_remove(&dev->link);
-			udev_device_unref(dev->udev_device);
-			free(dev);
-			break;
-		}
-	}
+	dev = path_find_device(input, evdev->udev_device);
+	if (dev)
+		path_device_destroy(input, dev);
 
 	seat = device->seat;
 	libinput_seat_ref(seat);
@@ -25,16 +25,44 @@
 #define _PATH_H_
 
 #include "config.h"
+
+#include <sys/types.h>
+
 #include "libinput-private.h"
+#include "timer.h"
 
 struct path_input {
 	struct libinput base;
 	struct udev *udev;
 	struct list path_list;
+	struct hash_index devices; /* struct path_device by devnum */
+
+	/* Devices added with libinput_path_add_device_async(), the
+	 * monitor and the eventfd only exist while the list is not
+	 * empty */
+	struct {
+		struct list list; /* struct path_pending_device */
+		struct udev_monitor *monitor;
+		struct libinput_source *monitor_source;
+		int fd; /* eventfd, signalled when a device is ready */
+		struct libinput_source *source;
+	} pending;
+};
+
+struct path_pending_device {
+	struct list link;
+	struct path_input *input;
+	char *path;
+	dev_t devnum;
+	struct udev_device *udev_device; /* set once udev initialized it */
+	struct libinput_timer timeout;
+	libinput_path_device_added_func notify;
+	void *user_data;
 };
 
 struct path_device {
 	struct list link;
+	struct hash_node node;
 	struct udev_device *udev_device;
 };
 
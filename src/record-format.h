@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RECORD_FORMAT_H
+#define RECORD_FORMAT_H
+
+#include <stdint.h>
+#include "linux/input.h"
+
+/*
+ * Binary recording of an evdev device as written by libinput-record.
+ *
+ * All structs are fixed-size and naturally aligned so a recording can be
+ * mmapped and used in-place. All values are in host byte order, a
+ * recording from a machine with a different byte order fails the version
+ * check.
+ *
+ * Layout:
+ * struct record_header			at offset 0
+ * struct record_device			at header.device_offset
+ * udev properties			at header.properties_offset, a
+ * 					sequence of "KEY=value\0" strings,
+ * 					header.properties_size bytes in total
+ * struct record_event[nevents]		at header.events_offset
+ * struct record_frame[nframes]		at header.frames_offset
+ *
+ * Events are grouped into frames, each frame ends with a SYN_REPORT (a
+ * SYN_DROPPED is recorded as a frame of its own). The frame index holds
+ * the absolute time of each frame and the index of its first event, the
+ * time of each event is a delta to the time of its frame. The kernel
+ * timestamps all events of a frame identically, so the delta is almost
+ * always zero.
+ *
+ * A recording that was not finalized (e.g. the recorder was killed) has
+ * nevents and nframes of zero and cannot be replayed.
+ */
+
+#define RECORD_MAGIC "LIBINREC"
+#define RECORD_VERSION 1
+
+struct record_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags; /* unused, 0 */
+	uint64_t device_offset;
+	uint64_t properties_offset;
+	uint64_t properties_size;
+	uint64_t events_offset;
+	uint64_t nevents;
+	uint64_t frames_offset;
+	uint64_t nframes;
+};
+
+#define RECORD_CODE_BYTES ((KEY_CNT + 7) / 8)
+
+struct record_device {
+	char name[256];
+	uint16_t bustype;
+	uint16_t vendor;
+	uint16_t product;
+	uint16_t version;
+	uint32_t properties; /* bitmask of INPUT_PROP_* */
+	uint32_t types; /* bitmask of EV_* */
+	uint8_t codes[EV_CNT][RECORD_CODE_BYTES]; /* bitmask of codes per type */
+	struct input_absinfo absinfo[ABS_CNT];
+	int32_t rep[2]; /* REP_DELAY, REP_PERIOD */
+};
+
+struct record_event {
+	uint32_t time_delta; /* in us, relative to the frame */
+	uint16_t type;
+	uint16_t code;
+	int32_t value;
+};
+
+struct record_frame {
+	uint64_t time; /* in us, CLOCK_MONOTONIC */
+	uint64_t first_event;
+};
+
+static inline int
+record_bit_is_set(const uint8_t *bits, unsigned int bit)
+{
+	return !!(bits[bit / 8] & (1U << (bit % 8)));
+}
+
+static inline void
+record_set_bit(uint8_t *bits, unsigned int bit)
+{
+	bits[bit / 8] |= (1U << (bit % 8));
+}
+
+#endif /* RECORD_FORMAT_H */
@@ -0,0 +1,217 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libinput-util.h"
+#include "record-writer.h"
+
+void
+record_describe_device(struct libevdev *evdev, struct record_device *d)
+{
+	const struct input_absinfo *abs;
+	unsigned int type, code;
+	int max;
+
+	memset(d, 0, sizeof(*d));
+
+	snprintf(d->name, sizeof(d->name), "%s", libevdev_get_name(evdev));
+	d->bustype = libevdev_get_id_bustype(evdev);
+	d->vendor = libevdev_get_id_vendor(evdev);
+	d->product = libevdev_get_id_product(evdev);
+	d->version = libevdev_get_id_version(evdev);
+
+	for (code = 0; code < INPUT_PROP_CNT; code++) {
+		if (libevdev_has_property(evdev, code))
+			d->properties |= 1U << code;
+	}
+
+	for (type = 0; type < EV_CNT; type++) {
+		if (!libevdev_has_event_type(evdev, type))
+			continue;
+
+		d->types |= 1U << type;
+
+		max = libevdev_event_type_get_max(type);
+		for (code = 0; (int)code <= max; code++) {
+			if (libevdev_has_event_code(evdev, type, code))
+				record_set_bit(d->codes[type], code);
+		}
+	}
+
+	for (code = 0; code < ABS_CNT; code++) {
+		abs = libevdev_get_abs_info(evdev, code);
+		if (abs)
+			d->absinfo[code] = *abs;
+	}
+
+	if (libevdev_has_event_type(evdev, EV_REP)) {
+		d->rep[0] = libevdev_get_event_value(evdev, EV_REP, REP_DELAY);
+		d->rep[1] = libevdev_get_event_value(evdev, EV_REP, REP_PERIOD);
+	}
+}
+
+static int
+record_write(struct record_writer *w, const void *data, size_t len)
+{
+	if (len > 0 && fwrite(data, len, 1, w->out) != 1)
+		return -1;
+
+	w->offset += len;
+
+	return 0;
+}
+
+static int
+record_write_padding(struct record_writer *w)
+{
+	static const char zero[8];
+	size_t pad = (8 - w->offset % 8) % 8;
+
+	return record_write(w, zero, pad);
+}
+
+int
+record_writer_init(struct record_writer *w,
+		   FILE *out,
+		   const struct record_device *device,
+		   const char *properties,
+		   size_t properties_size)
+{
+	memset(w, 0, sizeof(*w));
+	w->out = out;
+	memcpy(w->header.magic, RECORD_MAGIC, sizeof(w->header.magic));
+	w->header.version = RECORD_VERSION;
+
+	/* the header is rewritten with the final counts */
+	if (record_write(w, &w->header, sizeof(w->header)) != 0)
+		return -1;
+
+	w->header.device_offset = w->offset;
+	if (record_write(w, device, sizeof(*device)) != 0)
+		return -1;
+
+	w->header.properties_offset = w->offset;
+	w->header.properties_size = properties_size;
+	if (record_write(w, properties, properties_size) != 0 ||
+	    record_write_padding(w) != 0)
+		return -1;
+
+	w->header.events_offset = w->offset;
+
+	return 0;
+}
+
+int
+record_writer_add_event(struct record_writer *w,
+			const struct input_event *ev)
+{
+	struct record_event e;
+	struct record_frame *frame;
+	uint64_t time = s2us(ev->time.tv_sec) + ev->time.tv_usec;
+
+	if (!w->in_frame) {
+		if (w->header.nframes == w->frames_len) {
+			size_t len = max(w->frames_len * 2, 1024);
+			struct record_frame *frames;
+
+			frames = realloc(w->frames, len * sizeof(*frames));
+			if (!frames)
+				return -1;
+
+			w->frames = frames;
+			w->frames_len = len;
+		}
+
+		frame = &w->frames[w->header.nframes++];
+		frame->time = time;
+		frame->first_event = w->header.nevents;
+		w->in_frame = true;
+	}
+
+	frame = &w->frames[w->header.nframes - 1];
+
+	e.time_delta = time > frame->time ?
+		       min(time - frame->time, UINT32_MAX) : 0;
+	e.type = ev->type;
+	e.code = ev->code;
+	e.value = ev->value;
+
+	if (record_write(w, &e, sizeof(e)) != 0)
+		return -1;
+
+	w->header.nevents++;
+
+	if (ev->type == EV_SYN &&
+	    (ev->code == SYN_REPORT || ev->code == SYN_DROPPED))
+		w->in_frame = false;
+
+	return 0;
+}
+
+int
+record_writer_finish(struct record_writer *w)
+{
+	struct record_header *h = &w->header;
+
+	if (w->in_frame) {
+		h->nevents = w->frames[--h->nframes].first_event;
+		w->in_frame = false;
+	}
+
+	h->frames_offset = h->events_offset +
+			   h->nevents * sizeof(struct record_event);
+	h->frames_offset += (8 - h->frames_offset % 8) % 8;
+
+	/* the frame index overwrites the events of a dropped frame */
+	if (fflush(w->out) != 0 ||
+	    fseek(w->out, h->frames_offset, SEEK_SET) != 0 ||
+	    (h->nframes > 0 &&
+	     fwrite(w->frames, sizeof(*w->frames), h->nframes, w->out) != h->nframes))
+		return -1;
+
+	if (fflush(w->out) != 0 ||
+	    ftruncate(fileno(w->out),
+		      h->frames_offset +
+		      h->nframes * sizeof(struct record_frame)) != 0)
+		return -1;
+
+	if (fseek(w->out, 0, SEEK_SET) != 0 ||
+	    fwrite(h, sizeof(*h), 1, w->out) != 1 ||
+	    fflush(w->out) != 0)
+		return -1;
+
+	return 0;
+}
+
+void
+record_writer_fini(struct record_writer *w)
+{
+	free(w->frames);
+	w->frames = NULL;
+	w->frames_len = 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RECORD_WRITER_H
+#define RECORD_WRITER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <libevdev/libevdev.h>
+
+#include "record-format.h"
+
+/* Writes a recording as described in record-format.h. The events are
+ * written as they are added, the header and the frame index once the
+ * recording is finished, so the stream must be seekable. */
+struct record_writer {
+	FILE *out;
+	uint64_t offset; /* current write offset */
+	struct record_header header;
+
+	struct record_frame *frames;
+	size_t frames_len;
+	bool in_frame;
+};
+
+/* Fill d with the description of the libevdev device */
+void
+record_describe_device(struct libevdev *evdev, struct record_device *d);
+
+/* Write the device description and the udev properties, a sequence of
+ * "KEY=value\0" strings. Returns 0 or -1 on error. */
+int
+record_writer_init(struct record_writer *w,
+		   FILE *out,
+		   const struct record_device *device,
+		   const char *properties,
+		   size_t properties_size);
+
+int
+record_writer_add_event(struct record_writer *w,
+			const struct input_event *ev);
+
+/* Drop an incomplete trailing frame and write the frame index and the
+ * final header. Returns 0 or -1 on error. */
+int
+record_writer_finish(struct record_writer *w);
+
+void
+record_writer_fini(struct record_writer *w);
+
+#endif /* RECORD_WRITER_H */
@@ -0,0 +1,797 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <libevdev/libevdev.h>
+
+#include "libinput-test.h"
+#include "replay.h"
+#include "evdev.h"
+#include "timer.h"
+
+static const char default_seat[] = "seat0";
+static const char default_seat_name[] = "default";
+
+/* In fast mode, stop replaying frames once this many events are queued
+ * so the caller gets to process them */
+#define REPLAY_MAX_QUEUED_EVENTS 32
+#define REPLAY_MAX_FRAMES_PER_DISPATCH 256
+
+/* After the last frame, pending timers are triggered up to this long
+ * after the current time */
+#define REPLAY_TIMER_TIMEOUT s2us(10)
+
+static void replay_seat_destroy(struct libinput_seat *seat);
+
+static inline uint64_t
+replay_clock_now(void)
+{
+	struct timespec ts = { 0, 0 };
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return s2us(ts.tv_sec) + ns2us(ts.tv_nsec);
+}
+
+static inline bool
+replay_range_is_valid(uint64_t offset, uint64_t len, size_t size)
+{
+	return offset <= size && len <= size - offset;
+}
+
+static inline bool
+replay_event_code_is_valid(unsigned int type, unsigned int code)
+{
+	int max;
+
+	if (type > EV_MAX)
+		return false;
+
+	max = libevdev_event_type_get_max(type);
+
+	return max != -1 && code <= (unsigned int)max;
+}
+
+static int
+replay_recording_validate(struct replay_recording *r)
+{
+	const struct record_header *h = r->map;
+	size_t size = r->map_size;
+	uint64_t i;
+
+	if (size < sizeof(*h) ||
+	    memcmp(h->magic, RECORD_MAGIC, sizeof(h->magic)) != 0 ||
+	    h->version != RECORD_VERSION)
+		return -1;
+
+	if (h->device_offset % 8 != 0 ||
+	    h->events_offset % 8 != 0 ||
+	    h->frames_offset % 8 != 0)
+		return -1;
+
+	if (!replay_range_is_valid(h->device_offset,
+				   sizeof(struct record_device),
+				   size) ||
+	    !replay_range_is_valid(h->properties_offset,
+				   h->properties_size,
+				   size) ||
+	    !replay_range_is_valid(h->events_offset, 0, size) ||
+	    !replay_range_is_valid(h->frames_offset, 0, size))
+		return -1;
+
+	if (h->nevents > (size - h->events_offset)/sizeof(struct record_event) ||
+	    h->nframes > (size - h->frames_offset)/sizeof(struct record_frame))
+		return -1;
+
+	r->header = h;
+	r->description = (const void*)((const char*)r->map + h->device_offset);
+	r->properties = (const char*)r->map + h->properties_offset;
+	r->events = (const void*)((const char*)r->map + h->events_offset);
+	r->frames = (const void*)((const char*)r->map + h->frames_offset);
+
+	if (h->properties_size > 0 &&
+	    r->properties[h->properties_size - 1] != '\0')
+		return -1;
+
+	for (i = 0; i < h->nevents; i++) {
+		if (!replay_event_code_is_valid(r->events[i].type,
+						r->events[i].code))
+			return -1;
+	}
+
+	for (i = 0; i < h->nframes; i++) {
+		if (r->frames[i].first_event >= h->nevents)
+			return -1;
+
+		if (i > 0 &&
+		    (r->frames[i].first_event <= r->frames[i - 1].first_event ||
+		     r->frames[i].time < r->frames[i - 1].time))
+			return -1;
+	}
+
+	return 0;
+}
+
+static const char *
+replay_recording_get_property(struct replay_recording *r,
+			      const char *key)
+{
+	const char *p = r->properties;
+	const char *end = p + r->header->properties_size;
+	size_t len = strlen(key);
+
+	while (p < end) {
+		if (strncmp(p, key, len) == 0 && p[len] == '=')
+			return &p[len + 1];
+		p += strlen(p) + 1;
+	}
+
+	return NULL;
+}
+
+static struct libevdev *
+replay_create_evdev(const struct record_device *d)
+{
+	struct libevdev *evdev;
+	char name[sizeof(d->name)];
+	unsigned int type, code;
+	int max;
+
+	evdev = libevdev_new();
+	if (!evdev)
+		return NULL;
+
+	memcpy(name, d->name, sizeof(name));
+	name[sizeof(name) - 1] = '\0';
+
+	libevdev_set_name(evdev, name);
+	libevdev_set_id_bustype(evdev, d->bustype);
+	libevdev_set_id_vendor(evdev, d->vendor);
+	libevdev_set_id_product(evdev, d->product);
+	libevdev_set_id_version(evdev, d->version);
+
+	for (code = 0; code < INPUT_PROP_CNT; code++) {
+		if (d->properties & (1U << code))
+			libevdev_enable_property(evdev, code);
+	}
+
+	for (type = 0; type < EV_CNT; type++) {
+		if (!(d->types & (1U << type)))
+			continue;
+
+		libevdev_enable_event_type(evdev, type);
+
+		max = libevdev_event_type_get_max(type);
+		for (code = 0; (int)code <= max; code++) {
+			const void *data = NULL;
+
+			if (!record_bit_is_set(d->codes[type], code))
+				continue;
+
+			if (type == EV_ABS)
+				data = &d->absinfo[code];
+			else if (type == EV_REP)
+				data = &d->rep[code];
+
+			libevdev_enable_event_code(evdev, type, code, data);
+		}
+	}
+
+	return evdev;
+}
+
+static void
+replay_seat_destroy(struct libinput_seat *seat)
+{
+	struct replay_seat *rseat = (struct replay_seat*)seat;
+	free(rseat);
+}
+
+static struct replay_seat *
+replay_seat_get(struct replay_input *input,
+		const char *seat_name,
+		const char *seat_logical_name)
+{
+	struct replay_seat *seat;
+
+	list_for_each(seat, &input->base.seat_list, base.link) {
+		if (streq(seat->base.physical_name, seat_name) &&
+		    streq(seat->base.logical_name, seat_logical_name)) {
+			libinput_seat_ref(&seat->base);
+			return seat;
+		}
+	}
+
+	seat = zalloc(sizeof(*seat));
+	if (!seat)
+		return NULL;
+
+	libinput_seat_init(&seat->base, &input->base, seat_name,
+			   seat_logical_name, replay_seat_destroy);
+
+	return seat;
+}
+
+static struct evdev_device *
+replay_device_enable(struct replay_input *input,
+		     struct replay_recording *r,
+		     const char *seat_logical_name_override)
+{
+	struct replay_seat *seat;
+	struct evdev_device *device;
+	struct libevdev *evdev;
+	const char *seat_name, *seat_logical_name;
+
+	seat_name = replay_recording_get_property(r, "ID_SEAT");
+	if (!seat_name)
+		seat_name = default_seat;
+
+	seat_logical_name = seat_logical_name_override;
+	if (!seat_logical_name)
+		seat_logical_name = replay_recording_get_property(r, "WL_SEAT");
+	if (!seat_logical_name)
+		seat_logical_name = default_seat_name;
+
+	evdev = replay_create_evdev(r->description);
+	if (!evdev)
+		return NULL;
+
+	seat = replay_seat_get(input, seat_name, seat_logical_name);
+	if (!seat) {
+		libevdev_free(evdev);
+		return NULL;
+	}
+
+	device = evdev_device_create_from_recording(&seat->base,
+						    evdev,
+						    r->sysname,
+						    r->properties,
+						    r->header->properties_size);
+	libinput_seat_unref(&seat->base);
+
+	if (device == EVDEV_UNHANDLED_DEVICE) {
+		log_info(&input->base,
+			 "not using recorded device '%s'.\n",
+			 r->sysname);
+		return NULL;
+	} else if (device == NULL) {
+		log_info(&input->base,
+			 "failed to create recorded device '%s'.\n",
+			 r->sysname);
+		return NULL;
+	}
+
+	return device;
+}
+
+static inline uint64_t
+replay_next_frame_time(struct replay_recording *r)
+{
+	return r->frames[r->next_frame].time + r->time_offset;
+}
+
+/* The recording with the earliest pending frame, if any */
+static struct replay_recording *
+replay_next_recording(struct replay_input *input)
+{
+	struct replay_recording *r, *next = NULL;
+
+	list_for_each(r, &input->recording_list, link) {
+		if (!r->device || r->next_frame >= r->header->nframes)
+			continue;
+
+		if (!next ||
+		    replay_next_frame_time(r) < replay_next_frame_time(next))
+			next = r;
+	}
+
+	return next;
+}
+
+/* Like the kernel, discard events with a code the device doesn't
+ * have, the event processing relies on that */
+static void
+replay_dispatch_event(struct replay_recording *r,
+		      const struct input_event *ev)
+{
+	if (!libevdev_has_event_code(r->device->evdev, ev->type, ev->code))
+		return;
+
+	evdev_device_dispatch_event(r->device, ev);
+}
+
+static void
+replay_frame(struct replay_input *input, struct replay_recording *r)
+{
+	const struct record_frame *frame = &r->frames[r->next_frame];
+	uint64_t time = replay_next_frame_time(r);
+	uint64_t last, i;
+
+	if (r->next_frame + 1 < r->header->nframes)
+		last = frame[1].first_event;
+	else
+		last = r->header->nevents;
+
+	/* timers expiring before this frame trigger first */
+	libinput_timer_advance(&input->base, time);
+
+	for (i = frame->first_event; i < last; i++) {
+		const struct record_event *e = &r->events[i];
+		struct input_event ev;
+		uint64_t t = time + e->time_delta;
+
+		ev.time.tv_sec = t / s2us(1);
+		ev.time.tv_usec = t % s2us(1);
+		ev.type = e->type;
+		ev.code = e->code;
+		ev.value = e->value;
+
+		replay_dispatch_event(r, &ev);
+	}
+
+	r->next_frame++;
+}
+
+static void
+replay_arm(struct replay_input *input, uint64_t clock)
+{
+	struct itimerspec its = { { 0, 0 }, { 0, 0 } };
+
+	its.it_value.tv_sec = clock / s2us(1);
+	its.it_value.tv_nsec = (clock % s2us(1)) * 1000;
+
+	if (timerfd_settime(input->fd, TFD_TIMER_ABSTIME, &its, NULL) != 0)
+		log_error(&input->base,
+			  "timerfd_settime error: %s\n",
+			  strerror(errno));
+}
+
+static void
+replay_schedule(struct replay_input *input)
+{
+	struct replay_recording *r;
+	uint64_t next = 0;
+
+	if (input->suspended || input->finished) {
+		replay_arm(input, 0);
+		return;
+	}
+
+	if (input->manual) {
+		replay_arm(input, 0);
+		return;
+	}
+
+	if (input->pace == LIBINPUT_REPLAY_PACE_FAST) {
+		/* any time in the past triggers immediately */
+		replay_arm(input, 1);
+		return;
+	}
+
+	r = replay_next_recording(input);
+	if (r)
+		next = replay_next_frame_time(r);
+
+	if (libinput_timer_next_expire(&input->base) != 0 &&
+	    (next == 0 || libinput_timer_next_expire(&input->base) < next))
+		next = libinput_timer_next_expire(&input->base);
+
+	if (next == 0) {
+		input->finished = true;
+		replay_arm(input, 0);
+		return;
+	}
+
+	if (next < input->start_time)
+		next = input->start_time;
+	replay_arm(input, input->start_clock + (next - input->start_time));
+}
+
+/* Trigger the timers left after the last frame */
+static void
+replay_finish(struct replay_input *input)
+{
+	struct libinput *libinput = &input->base;
+
+	libinput_timer_advance(libinput,
+			       libinput->virtual_time + REPLAY_TIMER_TIMEOUT);
+	input->finished = true;
+}
+
+/* The events queued in the context and in all its event queues */
+static size_t
+replay_queued_events(struct libinput *libinput)
+{
+	struct libinput_event_queue *queue;
+	size_t count = libinput->events.count;
+
+	list_for_each(queue, &libinput->event_queues, link)
+		count += queue->events.count;
+
+	return count;
+}
+
+static void
+replay_dispatch(void *data)
+{
+	struct replay_input *input = data;
+	struct libinput *libinput = &input->base;
+	struct replay_recording *r;
+	uint64_t discard;
+	uint64_t now;
+	int nframes = 0;
+
+	if (read(input->fd, &discard, sizeof(discard)) == -1 &&
+	    errno != EAGAIN)
+		log_bug_libinput(libinput,
+				 "Error %d reading from timerfd (%s)",
+				 errno,
+				 strerror(errno));
+
+	if (input->suspended || input->finished || input->manual)
+		return;
+
+	if (input->pace == LIBINPUT_REPLAY_PACE_FAST) {
+		while ((r = replay_next_recording(input)) &&
+		       nframes++ < REPLAY_MAX_FRAMES_PER_DISPATCH &&
+		       replay_queued_events(libinput) < REPLAY_MAX_QUEUED_EVENTS)
+			replay_frame(input, r);
+
+		if (!r)
+			replay_finish(input);
+	} else {
+		now = input->start_time +
+		      (replay_clock_now() - input->start_clock);
+
+		while ((r = replay_next_recording(input)) &&
+		       replay_next_frame_time(r) <= now)
+			replay_frame(input, r);
+
+		libinput_timer_advance(libinput, now);
+	}
+
+	replay_schedule(input);
+}
+
+static void
+replay_restart_clock(struct replay_input *input)
+{
+	input->start_time = input->base.virtual_time;
+	input->start_clock = replay_clock_now();
+}
+
+static void
+replay_input_disable(struct libinput *libinput)
+{
+	struct replay_input *input = (struct replay_input*)libinput;
+	struct replay_recording *r;
+
+	list_for_each(r, &input->recording_list, link) {
+		if (!r->device)
+			continue;
+
+		evdev_device_remove(r->device);
+		r->device = NULL;
+	}
+
+	input->suspended = true;
+	replay_schedule(input);
+}
+
+static int
+replay_input_enable(struct libinput *libinput)
+{
+	struct replay_input *input = (struct replay_input*)libinput;
+	struct replay_recording *r;
+
+	if (!input->suspended)
+		return 0;
+
+	list_for_each(r, &input->recording_list, link) {
+		r->device = replay_device_enable(input, r, NULL);
+		if (!r->device) {
+			replay_input_disable(libinput);
+			return -1;
+		}
+	}
+
+	input->suspended = false;
+	replay_restart_clock(input);
+	replay_schedule(input);
+
+	return 0;
+}
+
+static void
+replay_recording_destroy(struct replay_recording *r)
+{
+	if (r->map)
+		munmap(r->map, r->map_size);
+	free(r->sysname);
+	free(r);
+}
+
+static void
+replay_input_destroy(struct libinput *libinput)
+{
+	struct replay_input *input = (struct replay_input*)libinput;
+	struct replay_recording *r, *tmp;
+
+	list_for_each_safe(r, tmp, &input->recording_list, link)
+		replay_recording_destroy(r);
+
+	if (input->source)
+		libinput_remove_source(libinput, input->source);
+	close(input->fd);
+}
+
+static int
+replay_device_change_seat(struct libinput_device *device,
+			  const char *seat_name)
+{
+	struct replay_input *input = (struct replay_input*)device->seat->libinput;
+	struct replay_recording *r;
+
+	list_for_each(r, &input->recording_list, link) {
+		if (!r->device || &r->device->base != device)
+			continue;
+
+		evdev_device_remove(r->device);
+		r->device = replay_device_enable(input, r, seat_name);
+
+		return r->device ? 0 : -1;
+	}
+
+	return -1;
+}
+
+static const struct libinput_interface_backend interface_backend = {
+	.resume = replay_input_enable,
+	.suspend = replay_input_disable,
+	.destroy = replay_input_destroy,
+	.device_change_seat = replay_device_change_seat,
+};
+
+static struct libinput *
+replay_create_context(const struct libinput_interface *interface,
+		      void *user_data,
+		      enum libinput_replay_pace pace,
+		      bool manual)
+{
+	struct replay_input *input;
+	int fd;
+
+	fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (fd < 0)
+		return NULL;
+
+	input = zalloc(sizeof *input);
+	if (!input ||
+	    libinput_init(&input->base, interface,
+			  &interface_backend, user_data) != 0) {
+		close(fd);
+		free(input);
+		return NULL;
+	}
+
+	input->base.use_virtual_time = true;
+	input->base.virtual_time_locked = !manual;
+	input->pace = pace;
+	input->manual = manual;
+	input->fd = fd;
+	list_init(&input->recording_list);
+
+	input->source = libinput_add_fd(&input->base,
+					fd,
+					replay_dispatch,
+					input);
+	if (!input->source) {
+		libinput_unref(&input->base);
+		return NULL;
+	}
+
+	return &input->base;
+}
+
+LIBINPUT_EXPORT struct libinput *
+libinput_replay_create_context(const struct libinput_interface *interface,
+			       void *user_data,
+			       enum libinput_replay_pace pace)
+{
+	if (pace != LIBINPUT_REPLAY_PACE_FAST &&
+	    pace != LIBINPUT_REPLAY_PACE_RECORDED)
+		return NULL;
+
+	return replay_create_context(interface, user_data, pace, false);
+}
+
+struct libinput *
+libinput_replay_create_manual_context(const struct libinput_interface *interface,
+				      void *user_data)
+{
+	return replay_create_context(interface,
+				     user_data,
+				     LIBINPUT_REPLAY_PACE_FAST,
+				     true);
+}
+
+LIBINPUT_EXPORT struct libinput_device *
+libinput_replay_add_recording(struct libinput *libinput,
+			      const char *path)
+{
+	struct replay_input *input = (struct replay_input*)libinput;
+	struct replay_recording *r;
+	struct stat st;
+	int fd;
+
+	if (libinput->interface_backend != &interface_backend) {
+		log_bug_client(libinput, "Mismatching backends.\n");
+		return NULL;
+	}
+
+	r = zalloc(sizeof *r);
+	if (!r)
+		return NULL;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		log_bug_client(libinput, "Invalid path %s\n", path);
+		free(r);
+		return NULL;
+	}
+
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		r->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (r->map == MAP_FAILED)
+			r->map = NULL;
+		else
+			r->map_size = st.st_size;
+	}
+	close(fd);
+
+	if (!r->map || replay_recording_validate(r) != 0) {
+		log_error(libinput, "Invalid recording %s\n", path);
+		goto err;
+	}
+
+	if (xasprintf(&r->sysname, "replay%u", input->nrecordings) == -1)
+		goto err;
+
+	/* The first frame of a recording is replayed at the current
+	 * virtual time. Before the first recording, the virtual time
+	 * starts at that recording's first frame */
+	if (libinput->virtual_time == 0) {
+		if (r->header->nframes > 0)
+			libinput->virtual_time = r->frames[0].time;
+		else
+			libinput->virtual_time = replay_clock_now();
+		replay_restart_clock(input);
+	}
+
+	if (r->header->nframes > 0)
+		r->time_offset = libinput->virtual_time - r->frames[0].time;
+
+	r->device = replay_device_enable(input, r, NULL);
+	if (!r->device)
+		goto err;
+
+	list_insert(input->recording_list.prev, &r->link);
+	input->nrecordings++;
+
+	/* Wait for a new timestamp if we had already finished */
+	if (input->finished) {
+		input->finished = false;
+		replay_restart_clock(input);
+	}
+	replay_schedule(input);
+
+	return &r->device->base;
+
+err:
+	replay_recording_destroy(r);
+	return NULL;
+}
+
+LIBINPUT_EXPORT int
+libinput_replay_is_finished(struct libinput *libinput)
+{
+	struct replay_input *input = (struct replay_input*)libinput;
+
+	if (libinput->interface_backend != &interface_backend) {
+		log_bug_client(libinput, "Mismatching backends.\n");
+		return 0;
+	}
+
+	return input->finished;
+}
+
+LIBINPUT_EXPORT int
+libinput_replay_step(struct libinput *libinput)
+{
+	struct replay_input *input = (struct replay_input*)libinput;
+	struct replay_recording *r;
+
+	if (libinput->interface_backend != &interface_backend) {
+		log_bug_client(libinput, "Mismatching backends.\n");
+		return 0;
+	}
+
+	if (input->suspended || input->finished)
+		return 0;
+
+	r = replay_next_recording(input);
+	if (!r) {
+		replay_finish(input);
+		replay_schedule(input);
+		return 0;
+	}
+
+	replay_frame(input, r);
+
+	return 1;
+}
+
+int
+libinput_replay_device_inject_event(struct libinput_device *device,
+				    unsigned int type,
+				    unsigned int code,
+				    int value)
+{
+	struct libinput *libinput = device->seat->libinput;
+	struct replay_input *input = (struct replay_input*)libinput;
+	struct replay_recording *r;
+	struct input_event ev;
+
+	if (libinput->interface_backend != &interface_backend) {
+		log_bug_client(libinput, "Mismatching backends.\n");
+		return -EINVAL;
+	}
+
+	if (!replay_event_code_is_valid(type, code))
+		return -EINVAL;
+
+	list_for_each(r, &input->recording_list, link) {
+		if (!r->device || &r->device->base != device)
+			continue;
+
+		ev.time.tv_sec = libinput->virtual_time / s2us(1);
+		ev.time.tv_usec = libinput->virtual_time % s2us(1);
+		ev.type = type;
+		ev.code = code;
+		ev.value = value;
+
+		replay_dispatch_event(r, &ev);
+
+		return 0;
+	}
+
+	return -ENODEV;
+}
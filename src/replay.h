@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include "config.h"
+#include "libinput-private.h"
+#include "record-format.h"
+
+struct replay_recording {
+	struct list link;
+	struct evdev_device *device;
+	char *sysname;
+
+	void *map;
+	size_t map_size;
+	const struct record_header *header;
+	const struct record_device *description;
+	const char *properties;
+	const struct record_event *events;
+	const struct record_frame *frames;
+
+	uint64_t next_frame;
+	int64_t time_offset; /* recorded time to virtual time */
+};
+
+struct replay_input {
+	struct libinput base;
+	struct list recording_list;
+	unsigned int nrecordings;
+
+	enum libinput_replay_pace pace;
+	bool manual; /* frames and time only move on request */
+	bool suspended;
+	bool finished;
+
+	int fd; /* timerfd driving the replay */
+	struct libinput_source *source;
+
+	/* for LIBINPUT_REPLAY_PACE_RECORDED, virtual time start_time
+	 * corresponds to CLOCK_MONOTONIC start_clock */
+	uint64_t start_time;
+	uint64_t start_clock;
+};
+
+struct replay_seat {
+	struct libinput_seat base;
+};
+
+#endif
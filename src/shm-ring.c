@@ -0,0 +1,367 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "libinput-private.h"
+#include "libinput-shm-ring.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+#define SHM_RING_MAX_CAPACITY (1 << 20)
+
+struct libinput_shm_ring {
+	struct libinput *libinput;
+	int fd; /* read-only, handed to readers */
+	struct libinput_shm_ring_header *header;
+	struct libinput_shm_record *records;
+	size_t size;
+	uint32_t capacity;
+	/* Our own copy of the head, the mapping is shared with readers */
+	uint64_t head;
+};
+
+static int
+shm_ring_create_memfd(void)
+{
+#ifdef __NR_memfd_create
+	return syscall(__NR_memfd_create,
+		       "libinput-shm-ring",
+		       MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/* Readers get an fd opened read-only so they cannot map the ring
+ * writable, the memfd itself is sealed against resizing */
+static int
+shm_ring_reopen_read_only(int fd)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+
+	return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+LIBINPUT_EXPORT struct libinput_shm_ring *
+libinput_shm_ring_create(struct libinput *libinput, unsigned int capacity)
+{
+	struct libinput_shm_ring *ring;
+	uint32_t nrecords = 1;
+	int fd = -1;
+	void *map;
+
+	if (capacity == 0 || capacity > SHM_RING_MAX_CAPACITY) {
+		log_bug_client(libinput,
+			       "invalid shm ring capacity %u\n",
+			       capacity);
+		return NULL;
+	}
+
+	while (nrecords < capacity)
+		nrecords <<= 1;
+
+	ring = zalloc(sizeof *ring);
+	if (!ring)
+		return NULL;
+
+	ring->libinput = libinput;
+	ring->fd = -1;
+	ring->capacity = nrecords;
+	ring->size = sizeof(*ring->header) +
+		     nrecords * sizeof(struct libinput_shm_record);
+
+	fd = shm_ring_create_memfd();
+	if (fd < 0 || ftruncate(fd, ring->size) < 0)
+		goto err;
+
+	if (fcntl(fd, F_ADD_SEALS,
+		  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0)
+		goto err;
+
+	map = mmap(NULL, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		goto err;
+
+	ring->header = map;
+	ring->records = (struct libinput_shm_record *)(ring->header + 1);
+
+	ring->fd = shm_ring_reopen_read_only(fd);
+	if (ring->fd < 0)
+		goto err;
+	close(fd);
+
+	ring->header->magic = LIBINPUT_SHM_RING_MAGIC;
+	ring->header->version = LIBINPUT_SHM_RING_VERSION;
+	ring->header->record_size = sizeof(struct libinput_shm_record);
+	ring->header->capacity = nrecords;
+	ring->header->head = 0;
+
+	return ring;
+
+err:
+	log_error(libinput,
+		  "failed to create the shm ring: %s\n",
+		  strerror(errno));
+	if (ring->header)
+		munmap(ring->header, ring->size);
+	if (fd >= 0)
+		close(fd);
+	free(ring);
+
+	return NULL;
+}
+
+LIBINPUT_EXPORT void
+libinput_shm_ring_destroy(struct libinput_shm_ring *ring)
+{
+	if (!ring)
+		return;
+
+	munmap(ring->header, ring->size);
+	close(ring->fd);
+	free(ring);
+}
+
+LIBINPUT_EXPORT int
+libinput_shm_ring_get_fd(struct libinput_shm_ring *ring)
+{
+	return ring->fd;
+}
+
+static void
+shm_record_fill_pointer(struct libinput_shm_record *record,
+			struct libinput_event_pointer *p)
+{
+	enum libinput_pointer_axis axis;
+
+	record->time_usec = libinput_event_pointer_get_time_usec(p);
+
+	switch (record->type) {
+	case LIBINPUT_EVENT_POINTER_MOTION:
+		record->u.motion.dx = libinput_event_pointer_get_dx(p);
+		record->u.motion.dy = libinput_event_pointer_get_dy(p);
+		record->u.motion.dx_unaccelerated =
+			libinput_event_pointer_get_dx_unaccelerated(p);
+		record->u.motion.dy_unaccelerated =
+			libinput_event_pointer_get_dy_unaccelerated(p);
+		break;
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+		record->u.motion_absolute.x =
+			libinput_event_pointer_get_absolute_x(p);
+		record->u.motion_absolute.y =
+			libinput_event_pointer_get_absolute_y(p);
+		break;
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+		record->u.button.button = libinput_event_pointer_get_button(p);
+		record->u.button.state =
+			libinput_event_pointer_get_button_state(p);
+		record->u.button.seat_button_count =
+			libinput_event_pointer_get_seat_button_count(p);
+		break;
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		record->u.axis.source = libinput_event_pointer_get_axis_source(p);
+		for (axis = LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL;
+		     axis <= LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL;
+		     axis++) {
+			if (!libinput_event_pointer_has_axis(p, axis))
+				continue;
+
+			record->u.axis.axes |= 1 << axis;
+			record->u.axis.value[axis] =
+				libinput_event_pointer_get_axis_value(p, axis);
+			record->u.axis.discrete[axis] =
+				libinput_event_pointer_get_axis_value_discrete(p, axis);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+shm_record_fill_touch(struct libinput_shm_record *record,
+		      struct libinput_event_touch *t)
+{
+	record->time_usec = libinput_event_touch_get_time_usec(t);
+
+	if (record->type == LIBINPUT_EVENT_TOUCH_FRAME)
+		return;
+
+	record->u.touch.slot = libinput_event_touch_get_slot(t);
+	record->u.touch.seat_slot = libinput_event_touch_get_seat_slot(t);
+
+	if (record->type == LIBINPUT_EVENT_TOUCH_DOWN ||
+	    record->type == LIBINPUT_EVENT_TOUCH_MOTION) {
+		record->u.touch.x = libinput_event_touch_get_x(t);
+		record->u.touch.y = libinput_event_touch_get_y(t);
+	}
+}
+
+static void
+shm_record_fill_gesture(struct libinput_shm_record *record,
+			struct libinput_event_gesture *g)
+{
+	record->time_usec = libinput_event_gesture_get_time_usec(g);
+	record->u.gesture.finger_count =
+		libinput_event_gesture_get_finger_count(g);
+	record->u.gesture.dx = libinput_event_gesture_get_dx(g);
+	record->u.gesture.dy = libinput_event_gesture_get_dy(g);
+	record->u.gesture.dx_unaccelerated =
+		libinput_event_gesture_get_dx_unaccelerated(g);
+	record->u.gesture.dy_unaccelerated =
+		libinput_event_gesture_get_dy_unaccelerated(g);
+
+	switch (record->type) {
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+		record->u.gesture.cancelled =
+			libinput_event_gesture_get_cancelled(g);
+		break;
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+		record->u.gesture.cancelled =
+			libinput_event_gesture_get_cancelled(g);
+		/* fallthrough */
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+		record->u.gesture.scale = libinput_event_gesture_get_scale(g);
+		record->u.gesture.angle_delta =
+			libinput_event_gesture_get_angle_delta(g);
+		break;
+	default:
+		break;
+	}
+}
+
+static bool
+shm_record_fill(struct libinput_shm_record *record,
+		struct libinput_event *event)
+{
+	struct libinput_event_keyboard *k;
+
+	record->type = libinput_event_get_type(event);
+	record->device_id =
+		libinput_device_get_export_id(libinput_event_get_device(event));
+	record->time_usec = 0;
+	memset(&record->u, 0, sizeof(record->u));
+
+	switch (record->type) {
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+	case LIBINPUT_EVENT_DEVICE_REMOVED:
+		break;
+	case LIBINPUT_EVENT_KEYBOARD_KEY:
+		k = libinput_event_get_keyboard_event(event);
+		record->time_usec = libinput_event_keyboard_get_time_usec(k);
+		record->u.keyboard.key = libinput_event_keyboard_get_key(k);
+		record->u.keyboard.state =
+			libinput_event_keyboard_get_key_state(k);
+		record->u.keyboard.seat_key_count =
+			libinput_event_keyboard_get_seat_key_count(k);
+		break;
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		shm_record_fill_pointer(record,
+					libinput_event_get_pointer_event(event));
+		break;
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+	case LIBINPUT_EVENT_TOUCH_FRAME:
+		shm_record_fill_touch(record,
+				      libinput_event_get_touch_event(event));
+		break;
+	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+		shm_record_fill_gesture(record,
+					libinput_event_get_gesture_event(event));
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+LIBINPUT_EXPORT int
+libinput_shm_ring_publish(struct libinput_shm_ring *ring,
+			  struct libinput_event *event)
+{
+	struct libinput_shm_record *record;
+	struct libinput_shm_record filled;
+	uint64_t seq = ring->head;
+
+	if (!shm_record_fill(&filled, event)) {
+		log_bug_client(ring->libinput,
+			       "cannot publish event type %d\n",
+			       libinput_event_get_type(event));
+		return -EINVAL;
+	}
+
+	record = &ring->records[seq & (ring->capacity - 1)];
+
+	/* Readers still reading the previous record in this slot see
+	 * the seq change and discard what they read */
+	__atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	record->time_usec = filled.time_usec;
+	record->type = filled.type;
+	record->device_id = filled.device_id;
+	record->u = filled.u;
+
+	__atomic_store_n(&record->seq, seq + 1, __ATOMIC_RELEASE);
+	ring->head = seq + 1;
+	__atomic_store_n(&ring->header->head, ring->head, __ATOMIC_RELEASE);
+
+	return 0;
+}
@@ -32,6 +32,10 @@
 
 #include "libinput-private.h"
 #include "timer.h"
+#include "libinput-probes.h"
+
+/* A timer handled later than this counts as late in the stats */
+#define TIMER_LATE_THRESHOLD ms2us(5)
 
 void
 libinput_timer_init(struct libinput_timer *timer, struct libinput *libinput,
@@ -43,20 +47,54 @@ libinput_timer_init(struct libinput_timer *timer, struct libinput *libinput,
 	timer->timer_func_data = timer_func_data;
 }
 
+/* The timer list is sorted by expire time, the earliest timer first */
+static inline struct libinput_timer *
+libinput_timer_first(struct libinput *libinput)
+{
+	struct libinput_timer *timer;
+
+	if (list_empty(&libinput->timer.list))
+		return NULL;
+
+	return container_of(libinput->timer.list.next, timer, link);
+}
+
+static void
+libinput_timer_insert(struct libinput *libinput,
+		      struct libinput_timer *timer)
+{
+	struct libinput_timer *t;
+	struct list *pos = libinput->timer.list.prev;
+
+	/* A new timer usually expires after all others, so search from
+	 * the tail. Timers with the same expire time trigger in the order
+	 * they were set. */
+	while (pos != &libinput->timer.list) {
+		t = container_of(pos, t, link);
+		if (t->expire <= timer->expire)
+			break;
+		pos = pos->prev;
+	}
+
+	list_insert(pos, &timer->link);
+}
+
 static void
 libinput_timer_arm_timer_fd(struct libinput *libinput)
 {
 	int r;
-	struct libinput_timer *timer;
 	struct itimerspec its = { { 0, 0 }, { 0, 0 } };
-	uint64_t earliest_expire = UINT64_MAX;
+	uint64_t earliest_expire;
 
-	list_for_each(timer, &libinput->timer.list, link) {
-		if (timer->expire < earliest_expire)
-			earliest_expire = timer->expire;
-	}
+	/* virtual time is advanced by the caller, not by the timerfd */
+	if (libinput->use_virtual_time)
+		return;
+
+	earliest_expire = libinput_timer_next_expire(libinput);
+	if (earliest_expire == libinput->timer.armed)
+		return;
 
-	if (earliest_expire != UINT64_MAX) {
+	if (earliest_expire != 0) {
 		its.it_value.tv_sec = earliest_expire / ms2us(1000);
 		its.it_value.tv_nsec = (earliest_expire % ms2us(1000)) * 1000;
 	}
@@ -64,6 +102,8 @@ libinput_timer_arm_timer_fd(struct libinput *libinput)
 	r = timerfd_settime(libinput->timer.fd, TFD_TIMER_ABSTIME, &its, NULL);
 	if (r)
 		log_error(libinput, "timerfd_settime error: %s\n", strerror(errno));
+	else
+		libinput->timer.armed = earliest_expire;
 }
 
 void
@@ -83,10 +123,11 @@ libinput_timer_set(struct libinput_timer *timer, uint64_t expire)
 
 	assert(expire);
 
-	if (!timer->expire)
-		list_insert(&timer->libinput->timer.list, &timer->link);
+	if (timer->expire)
+		list_remove(&timer->link);
 
 	timer->expire = expire;
+	libinput_timer_insert(timer->libinput, timer);
 	libinput_timer_arm_timer_fd(timer->libinput);
 }
 
@@ -101,11 +142,80 @@ libinput_timer_cancel(struct libinput_timer *timer)
 	libinput_timer_arm_timer_fd(timer->libinput);
 }
 
+static void
+libinput_timer_expired(struct libinput *libinput,
+		       struct libinput_timer *timer,
+		       uint64_t now)
+{
+	LIBINPUT_PROBE1(timer_expired, now - timer->expire);
+
+	if (now - timer->expire > TIMER_LATE_THRESHOLD)
+		libinput->stats[LIBINPUT_STAT_TIMERS_LATE]++;
+
+	/* Clear the timer before calling timer_func,
+	   as timer_func may re-arm it */
+	libinput_timer_cancel(timer);
+	timer->timer_func(now, timer->timer_func_data);
+}
+
+int
+libinput_timer_use_virtual_time(struct libinput *libinput, uint64_t now)
+{
+	struct itimerspec its = { { 0, 0 }, { 0, 0 } };
+	int r;
+
+	libinput->use_virtual_time = true;
+	libinput->virtual_time = now;
+	libinput->timer.armed = 0;
+
+	r = timerfd_settime(libinput->timer.fd, TFD_TIMER_ABSTIME, &its, NULL);
+	if (r) {
+		r = -errno;
+		log_error(libinput, "timerfd_settime error: %s\n", strerror(-r));
+	}
+
+	return r;
+}
+
+uint64_t
+libinput_timer_next_expire(struct libinput *libinput)
+{
+	struct libinput_timer *timer;
+
+	timer = libinput_timer_first(libinput);
+
+	return timer ? timer->expire : 0;
+}
+
+void
+libinput_timer_advance(struct libinput *libinput, uint64_t now)
+{
+	struct libinput_timer *timer;
+
+	assert(libinput->use_virtual_time);
+
+	/* timer_func may set new timers, so take the earliest timer
+	 * from the list every time */
+	while ((timer = libinput_timer_first(libinput)) &&
+	       timer->expire <= now) {
+		if (timer->expire > libinput->virtual_time)
+			libinput->virtual_time = timer->expire;
+
+		libinput->stats[LIBINPUT_STAT_TIMER_WAKEUPS]++;
+		libinput_timer_expired(libinput,
+				       timer,
+				       libinput->virtual_time);
+	}
+
+	if (now > libinput->virtual_time)
+		libinput->virtual_time = now;
+}
+
 static void
 libinput_timer_handler(void *data)
 {
 	struct libinput *libinput = data;
-	struct libinput_timer *timer, *tmp;
+	struct libinput_timer *timer;
 	uint64_t now;
 	uint64_t discard;
 	int r;
@@ -117,18 +227,20 @@ libinput_timer_handler(void *data)
 				 errno,
 				 strerror(errno));
 
+	/* the timerfd is disarmed once it expired */
+	libinput->timer.armed = 0;
+
 	now = libinput_now(libinput);
 	if (now == 0)
 		return;
 
-	list_for_each_safe(timer, tmp, &libinput->timer.list, link) {
-		if (timer->expire <= now) {
-			/* Clear the timer before calling timer_func,
-			   as timer_func may re-arm it */
-			libinput_timer_cancel(timer);
-			timer->timer_func(now, timer->timer_func_data);
-		}
-	}
+	libinput->stats[LIBINPUT_STAT_TIMER_WAKEUPS]++;
+
+	while ((timer = libinput_timer_first(libinput)) &&
+	       timer->expire <= now)
+		libinput_timer_expired(libinput, timer, now);
+
+	libinput_timer_arm_timer_fd(libinput);
 }
 
 int
@@ -140,6 +252,7 @@ libinput_timer_subsys_init(struct libinput *libinput)
 		return -1;
 
 	list_init(&libinput->timer.list);
+	libinput->timer.armed = 0;
 
 	libinput->timer.source = libinput_add_fd(libinput,
 						 libinput->timer.fd,
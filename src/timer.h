@@ -50,6 +50,20 @@ libinput_timer_set(struct libinput_timer *timer, uint64_t expire);
 void
 libinput_timer_cancel(struct libinput_timer *timer);
 
+/* Switch the context to virtual time starting at now and disarm the
+ * timerfd. Returns 0 or a negative errno */
+int
+libinput_timer_use_virtual_time(struct libinput *libinput, uint64_t now);
+
+/* Advance the virtual clock to now, triggering all timers that expire
+ * up to now in order. Only valid if the context uses virtual time */
+void
+libinput_timer_advance(struct libinput *libinput, uint64_t now);
+
+/* Earliest expire time of all timers or 0 if no timer is set */
+uint64_t
+libinput_timer_next_expire(struct libinput *libinput);
+
 int
 libinput_timer_subsys_init(struct libinput *libinput);
 
@@ -24,6 +24,7 @@
 
 #include "config.h"
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,22 +32,165 @@
 #include <fcntl.h>
 
 #include "evdev.h"
+#include "open-async.h"
 #include "udev-seat.h"
 
 static const char default_seat[] = "seat0";
 static const char default_seat_name[] = "default";
 
+/* Upper limit of threads probing devices at startup */
+#define UDEV_PROBE_MAX_THREADS 8
+
+/* uevents received per wakeup at most */
+#define UDEV_HOTPLUG_BATCH_MAX 256
+
+/* How long a burst of uevents is held back to coalesce devices that
+ * are removed and added again */
+#define UDEV_HOTPLUG_COALESCE_TIMEOUT ms2us(10)
+
+/* A device opened at startup, probed by one of the probe threads */
+struct udev_probe {
+	struct udev_device *udev_device;
+	int fd;
+	struct libevdev *evdev;
+	int rc;
+};
+
+struct udev_probe_queue {
+	struct udev_probe *probes;
+	size_t nprobes;
+	size_t next;
+};
+
+/* A device opened through the async interface. Opens are handled in
+ * the order they were requested, an open is only handled once all
+ * opens requested before it completed */
+struct udev_open {
+	struct list link; /* udev_input::opens */
+	struct libinput_open_request *request; /* NULL once completed */
+	struct udev_device *udev_device;
+	char *seat_name;
+	/* A device kept across a soft suspend, NULL for new devices */
+	struct evdev_device *device;
+	int fd;
+};
+
+/* The coalesced uevents of one syspath */
+struct udev_hotplug {
+	struct list link; /* udev_input::hotplug.list */
+	struct hash_node node; /* udev_input::hotplug.index */
+	struct udev_device *udev_device; /* of the most recent uevent */
+	bool added; /* the most recent uevent was an add */
+	bool removed; /* any of the uevents was a remove */
+};
+
 static struct udev_seat *
 udev_seat_create(struct udev_input *input,
 		 const char *device_seat,
 		 const char *seat_name);
 static struct udev_seat *
-udev_seat_get_named(struct udev_input *input, const char *seat_name);
+udev_seat_get_named(struct udev_input *input,
+		    const char *device_seat,
+		    const char *seat_name);
+static void
+udev_input_cancel_opens(struct udev_input *input, const char *syspath);
+
+static void
+udev_probe_release(struct udev_input *input, struct udev_probe *probe)
+{
+	libevdev_free(probe->evdev);
+	probe->evdev = NULL;
+	close_restricted(&input->base, probe->fd);
+	probe->fd = -1;
+}
+
+static void
+udev_input_free_seat_ids(struct udev_input *input)
+{
+	char **seat_id;
+
+	if (!input->seat_ids)
+		return;
+
+	for (seat_id = input->seat_ids; *seat_id; seat_id++)
+		free(*seat_id);
+	free(input->seat_ids);
+	input->seat_ids = NULL;
+}
+
+static bool
+udev_input_wants_seat(struct udev_input *input, const char *device_seat)
+{
+	char **seat_id;
+
+	if (!input->seat_ids)
+		return true;
+
+	for (seat_id = input->seat_ids; *seat_id; seat_id++) {
+		if (streq(*seat_id, device_seat))
+			return true;
+	}
+
+	return false;
+}
+
+static bool
+udev_input_wants_device(struct udev_input *input,
+			struct udev_device *udev_device)
+{
+	const char *device_seat;
+
+	device_seat = udev_device_get_property_value(udev_device, "ID_SEAT");
+	if (!device_seat)
+		device_seat = default_seat;
+
+	if (!udev_input_wants_seat(input, device_seat))
+		return false;
+
+	if (ignore_litest_test_suite_device(udev_device))
+		return false;
+
+	return true;
+}
 
+static struct evdev_device *
+udev_input_find_device(struct udev_input *input,
+		       struct udev_device *udev_device)
+{
+	struct evdev_device *device;
+	struct hash_node *node;
+	dev_t devnum = udev_device_get_devnum(udev_device);
+	const char *syspath = udev_device_get_syspath(udev_device);
+
+	for (node = hash_index_first(&input->devices, hash_uint64(devnum));
+	     node;
+	     node = hash_index_next(node)) {
+		device = container_of(node, device, devnum_node);
+		if (udev_device_get_devnum(device->udev_device) == devnum &&
+		    streq(syspath,
+			  udev_device_get_syspath(device->udev_device)))
+			return device;
+	}
+
+	return NULL;
+}
+
+static void
+udev_input_remove_device(struct udev_input *input,
+			 struct evdev_device *device)
+{
+	hash_index_remove(&input->devices, &device->devnum_node);
+	evdev_device_remove(device);
+}
+
+/* Add the device, probe is NULL unless the device was already opened
+ * and successfully probed by udev_input_add_devices(). The fd and
+ * libevdev context of the probe are always consumed. */
 static int
 device_added(struct udev_device *udev_device,
 	     struct udev_input *input,
-	     const char *seat_name)
+	     const char *seat_name,
+	     struct udev_probe *probe)
 {
 	struct evdev_device *device;
 	const char *devnode;
@@ -55,16 +199,16 @@ device_added(struct udev_device *udev_device,
 	float calibration[6];
 	struct udev_seat *seat;
 
+	if (!udev_input_wants_device(input, udev_device)) {
+		if (probe)
+			udev_probe_release(input, probe);
+		return 0;
+	}
+
 	device_seat = udev_device_get_property_value(udev_device, "ID_SEAT");
 	if (!device_seat)
 		device_seat = default_seat;
 
-	if (!streq(device_seat, input->seat_id))
-		return 0;
-
-	if (ignore_litest_test_suite_device(udev_device))
-		return 0;
-
 	devnode = udev_device_get_devnode(udev_device);
 
 	/* Search for matching logical seat */
@@ -73,17 +217,26 @@ device_added(struct udev_device *udev_device,
 	if (!seat_name)
 		seat_name = default_seat_name;
 
-	seat = udev_seat_get_named(input, seat_name);
+	seat = udev_seat_get_named(input, device_seat, seat_name);
 
 	if (seat)
 		libinput_seat_ref(&seat->base);
 	else {
 		seat = udev_seat_create(input, device_seat, seat_name);
-		if (!seat)
+		if (!seat) {
+			if (probe)
+				udev_probe_release(input, probe);
 			return -1;
+		}
 	}
 
-	device = evdev_device_create(&seat->base, udev_device);
+	if (probe)
+		device = evdev_device_create_probed(&seat->base,
+						    udev_device,
+						    probe->fd,
+						    probe->evdev);
+	else
+		device = evdev_device_create(&seat->base, udev_device);
 	libinput_seat_unref(&seat->base);
 
 	if (device == EVDEV_UNHANDLED_DEVICE) {
@@ -122,31 +275,298 @@ device_added(struct udev_device *udev_device,
 	if (output_name)
 		device->output_name = strdup(output_name);
 
+	if (!hash_index_insert(&input->devices,
+			       &device->devnum_node,
+			       hash_uint64(udev_device_get_devnum(udev_device)))) {
+		log_error(&input->base,
+			  "failed to index input device '%s'.\n",
+			  devnode);
+		evdev_device_remove(device);
+		return -1;
+	}
+
 	return 0;
 }
 
 static void
 device_removed(struct udev_device *udev_device, struct udev_input *input)
 {
-	struct evdev_device *device, *next;
-	struct udev_seat *seat;
+	struct evdev_device *device;
+
+	udev_input_cancel_opens(input, udev_device_get_syspath(udev_device));
+
+	device = udev_input_find_device(input, udev_device);
+	if (!device)
+		return;
+
+	log_info(&input->base,
+		 "input device %s, %s removed\n",
+		 device->devname,
+		 udev_device_get_devnode(device->udev_device));
+	udev_input_remove_device(input, device);
+}
+
+
+static void *
+udev_input_probe_thread(void *data)
+{
+	struct udev_probe_queue *queue = data;
+	struct udev_probe *probe;
+	size_t i;
+
+	while ((i = __sync_fetch_and_add(&queue->next, 1)) < queue->nprobes) {
+		probe = &queue->probes[i];
+		probe->rc = evdev_device_probe(probe->fd, &probe->evdev);
+	}
+
+	return NULL;
+}
+
+/* Probe all opened devices, spread across up to UDEV_PROBE_MAX_THREADS
+ * threads. The calling thread probes too, so a thread that fails to
+ * start only makes probing slower. */
+static void
+udev_input_probe_devices(struct udev_probe_queue *queue)
+{
+	pthread_t threads[UDEV_PROBE_MAX_THREADS - 1];
+	long ncpus;
+	size_t nthreads, started = 0, i;
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	nthreads = min(queue->nprobes, UDEV_PROBE_MAX_THREADS);
+	if (ncpus > 0)
+		nthreads = min(nthreads, (size_t)ncpus);
+
+	for (i = 1; i < nthreads; i++) {
+		if (pthread_create(&threads[started],
+				   NULL,
+				   udev_input_probe_thread,
+				   queue) != 0)
+			break;
+		started++;
+	}
+
+	udev_input_probe_thread(queue);
+
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+}
+
+static void
+udev_open_destroy(struct udev_input *input, struct udev_open *op)
+{
+	if (op->request)
+		libinput_open_request_cancel(op->request);
+	else if (op->fd >= 0)
+		close_restricted(&input->base, op->fd);
+
+	list_remove(&op->link);
+	udev_device_unref(op->udev_device);
+	free(op->seat_name);
+	free(op);
+}
+
+static void
+udev_input_flush_opens(struct udev_input *input);
+
+static void
+udev_open_done(struct libinput *libinput, int fd, void *data)
+{
+	struct udev_input *input = (struct udev_input*)libinput;
+	struct udev_open *op = data;
+
+	op->request = NULL;
+	op->fd = fd;
+
+	if (fd < 0)
+		log_info(libinput,
+			 "opening input device '%s' failed (%s).\n",
+			 udev_device_get_devnode(op->udev_device),
+			 strerror(-fd));
+	else if (!op->device)
+		op->fd = evdev_device_verify_fd(libinput,
+						op->udev_device,
+						fd);
+
+	udev_input_flush_opens(input);
+}
+
+/* Request the device node of udev_device from the async interface.
+ * device is the kept device to resume, or NULL to add a new device */
+static int
+udev_input_open_async(struct udev_input *input,
+		      struct udev_device *udev_device,
+		      const char *seat_name,
+		      struct evdev_device *device)
+{
+	struct udev_open *op;
+
+	op = zalloc(sizeof *op);
+	if (!op)
+		return -1;
+
+	op->udev_device = udev_device_ref(udev_device);
+	op->seat_name = seat_name ? strdup(seat_name) : NULL;
+	op->device = device;
+	op->fd = -1;
+	list_insert(input->opens.prev, &op->link);
+
+	op->request = libinput_open_async(&input->base,
+					  udev_device_get_devnode(udev_device),
+					  O_RDWR | O_NONBLOCK | O_CLOEXEC,
+					  udev_open_done,
+					  op);
+	if (!op->request) {
+		udev_open_destroy(input, op);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Cancel all opens for syspath, or all opens if syspath is NULL */
+static void
+udev_input_cancel_opens(struct udev_input *input, const char *syspath)
+{
+	struct udev_open *op, *tmp;
+	bool cancelled = false;
+
+	list_for_each_safe(op, tmp, &input->opens, link) {
+		if (syspath &&
+		    !streq(syspath, udev_device_get_syspath(op->udev_device)))
+			continue;
+
+		udev_open_destroy(input, op);
+		cancelled = true;
+	}
+
+	/* opens behind a cancelled one may be ready now */
+	if (cancelled)
+		udev_input_flush_opens(input);
+}
+
+static void
+udev_input_resume_opened(struct udev_input *input, struct udev_open *op)
+{
+	struct evdev_device *device = op->device;
+	struct udev_device *udev_device;
 	const char *syspath;
+	int fd = op->fd;
 
-	syspath = udev_device_get_syspath(udev_device);
-	list_for_each(seat, &input->base.seat_list, base.link) {
-		list_for_each_safe(device, next,
-				   &seat->base.devices_list, base.link) {
-			if (streq(syspath,
-				  udev_device_get_syspath(device->udev_device))) {
+	op->fd = -1;
+	if (fd >= 0 && evdev_device_session_resume_fd(device, fd) == 0)
+		return;
+
+	log_info(&input->base,
+		 "input device %s, %s removed while suspended\n",
+		 device->devname,
+		 udev_device_get_devnode(device->udev_device));
+
+	/* The device node may now belong to a different device, add
+	 * that one instead */
+	syspath = udev_device_get_syspath(device->udev_device);
+	udev_device = udev_device_new_from_syspath(input->udev, syspath);
+	udev_input_remove_device(input, device);
+
+	if (udev_device) {
+		if (udev_input_wants_device(input, udev_device))
+			udev_input_open_async(input, udev_device, NULL, NULL);
+		udev_device_unref(udev_device);
+	}
+}
+
+/* Add or resume the devices of all completed opens up to the first
+ * pending open */
+static void
+udev_input_flush_opens(struct udev_input *input)
+{
+	struct udev_probe_queue queue = { NULL, 0, 0 };
+	struct udev_probe *probe;
+	struct udev_open *op, *tmp;
+	size_t nopens = 0, i = 0;
+
+	list_for_each(op, &input->opens, link) {
+		if (op->request)
+			break;
+		nopens++;
+	}
+
+	if (nopens == 0)
+		return;
+
+	queue.probes = zalloc(nopens * sizeof(*queue.probes));
+	if (!queue.probes)
+		return;
+
+	list_for_each(op, &input->opens, link) {
+		if (i++ == nopens)
+			break;
+
+		if (op->device || op->fd < 0)
+			continue;
+
+		probe = &queue.probes[queue.nprobes++];
+		probe->udev_device = op->udev_device;
+		probe->fd = op->fd;
+		probe->evdev = NULL;
+		probe->rc = 0;
+
+		/* now owned by the probe */
+		op->fd = -1;
+	}
+
+	udev_input_probe_devices(&queue);
+
+	/* Opens requested while handling these are appended to the
+	 * list and handled once they completed */
+	i = 0;
+	probe = queue.probes;
+	list_for_each_safe(op, tmp, &input->opens, link) {
+		if (i++ == nopens)
+			break;
+
+		if (op->device) {
+			udev_input_resume_opened(input, op);
+		} else if (probe < queue.probes + queue.nprobes &&
+			   probe->udev_device == op->udev_device) {
+			if (probe->rc == 0) {
+				/* the device now owns fd and evdev */
+				device_added(op->udev_device,
+					     input,
+					     op->seat_name,
+					     probe);
+			} else {
+				udev_probe_release(input, probe);
 				log_info(&input->base,
-					 "input device %s, %s removed\n",
-					 device->devname,
-					 udev_device_get_devnode(device->udev_device));
-				evdev_device_remove(device);
-				break;
+					 "failed to create input device '%s'.\n",
+					 udev_device_get_devnode(op->udev_device));
 			}
+			probe++;
+		} else {
+			log_info(&input->base,
+				 "failed to create input device '%s'.\n",
+				 udev_device_get_devnode(op->udev_device));
 		}
+
+		udev_open_destroy(input, op);
 	}
+
+	free(queue.probes);
+}
+
+/* Add a device, through the async interface if the caller set one */
+static int
+udev_input_add_device(struct udev_input *input,
+		      struct udev_device *udev_device,
+		      const char *seat_name)
+{
+	if (!libinput_has_async_open(&input->base))
+		return device_added(udev_device, input, seat_name, NULL);
+
+	if (!udev_input_wants_device(input, udev_device))
+		return 0;
+
+	return udev_input_open_async(input, udev_device, seat_name, NULL);
 }
 
 static int
@@ -155,8 +575,17 @@ udev_input_add_devices(struct udev_input *input, struct udev *udev)
 	struct udev_enumerate *e;
 	struct udev_list_entry *entry;
 	struct udev_device *device;
+	struct udev_probe_queue queue = { NULL, 0, 0 };
+	struct udev_probe *probes;
+	size_t size = 0, i;
 	const char *path, *sysname;
+	int fd;
+	int rc = 0;
 
+	/* The device nodes are opened here and the devices are added in
+	 * enumeration order below, only the probing of the opened fds
+	 * runs in parallel. Neither libudev nor the open_restricted
+	 * callback are thread-safe. */
 	e = udev_enumerate_new(udev);
 	udev_enumerate_add_match_subsystem(e, "input");
 	udev_enumerate_scan_devices(e);
@@ -166,23 +595,187 @@ udev_input_add_devices(struct udev_input *input, struct udev *udev)
 		if (!device)
 			continue;
 
+		/* Devices kept across a soft suspend are already
+		 * resumed, see udev_input_resume_devices() */
 		sysname = udev_device_get_sysname(device);
-		if (strncmp("event", sysname, 5) != 0) {
+		if (strncmp("event", sysname, 5) != 0 ||
+		    !udev_input_wants_device(input, device) ||
+		    udev_input_find_device(input, device)) {
 			udev_device_unref(device);
 			continue;
 		}
 
-		if (device_added(device, input, NULL) < 0) {
+		/* Devices are added once the caller completed the
+		 * opens, see udev_input_flush_opens() */
+		if (libinput_has_async_open(&input->base)) {
+			rc = udev_input_open_async(input, device, NULL, NULL);
 			udev_device_unref(device);
-			udev_enumerate_unref(e);
-			return -1;
+			if (rc != 0)
+				break;
+			continue;
 		}
 
-		udev_device_unref(device);
+		fd = evdev_device_open(&input->base, device);
+		if (fd < 0) {
+			log_info(&input->base,
+				 "failed to create input device '%s'.\n",
+				 udev_device_get_devnode(device));
+			udev_device_unref(device);
+			continue;
+		}
+
+		if (queue.nprobes == size) {
+			size = max(size * 2, 16U);
+			probes = realloc(queue.probes,
+					 size * sizeof(*probes));
+			if (!probes) {
+				close_restricted(&input->base, fd);
+				udev_device_unref(device);
+				rc = -1;
+				break;
+			}
+			queue.probes = probes;
+		}
+
+		queue.probes[queue.nprobes].udev_device = device;
+		queue.probes[queue.nprobes].fd = fd;
+		queue.probes[queue.nprobes].evdev = NULL;
+		queue.probes[queue.nprobes].rc = 0;
+		queue.nprobes++;
 	}
 	udev_enumerate_unref(e);
 
-	return 0;
+	if (rc == 0)
+		udev_input_probe_devices(&queue);
+
+	for (i = 0; i < queue.nprobes; i++) {
+		struct udev_probe *probe = &queue.probes[i];
+
+		if (rc == 0 && probe->rc == 0) {
+			/* the device now owns fd and evdev */
+			rc = device_added(probe->udev_device,
+					  input,
+					  NULL,
+					  probe);
+		} else {
+			udev_probe_release(input, probe);
+			if (rc == 0)
+				log_info(&input->base,
+					 "failed to create input device '%s'.\n",
+					 udev_device_get_devnode(probe->udev_device));
+		}
+
+		udev_device_unref(probe->udev_device);
+	}
+	free(queue.probes);
+
+	return rc;
+}
+
+static void
+udev_hotplug_destroy(struct udev_input *input, struct udev_hotplug *hotplug)
+{
+	list_remove(&hotplug->link);
+	hash_index_remove(&input->hotplug.index, &hotplug->node);
+	udev_device_unref(hotplug->udev_device);
+	free(hotplug);
+}
+
+/* Merge the uevent into the pending uevents of the same syspath. The
+ * udev_device reference is consumed. */
+static void
+udev_input_queue_hotplug(struct udev_input *input,
+			 struct udev_device *udev_device,
+			 bool added)
+{
+	struct udev_hotplug *hotplug;
+	struct hash_node *node;
+	const char *syspath = udev_device_get_syspath(udev_device);
+	uint64_t hash = hash_string(syspath);
+
+	for (node = hash_index_first(&input->hotplug.index, hash);
+	     node;
+	     node = hash_index_next(node)) {
+		hotplug = container_of(node, hotplug, node);
+		if (!streq(syspath,
+			   udev_device_get_syspath(hotplug->udev_device)))
+			continue;
+
+		udev_device_unref(hotplug->udev_device);
+		hotplug->udev_device = udev_device;
+		hotplug->added = added;
+		hotplug->removed |= !added;
+		return;
+	}
+
+	hotplug = zalloc(sizeof *hotplug);
+	if (!hotplug) {
+		udev_device_unref(udev_device);
+		return;
+	}
+
+	if (!hash_index_insert(&input->hotplug.index, &hotplug->node, hash)) {
+		log_error(&input->base,
+			  "udev: failed to queue uevent for %s\n",
+			  syspath);
+		udev_device_unref(udev_device);
+		free(hotplug);
+		return;
+	}
+
+	hotplug->udev_device = udev_device;
+	hotplug->added = added;
+	hotplug->removed = !added;
+	list_insert(input->hotplug.list.prev, &hotplug->link);
+}
+
+static void
+udev_input_flush_hotplug(struct udev_input *input)
+{
+	struct udev_hotplug *hotplug;
+
+	libinput_timer_cancel(&input->hotplug.timer);
+
+	/* Removing or adding a device may drop the pending uevents */
+	while (!list_empty(&input->hotplug.list)) {
+		hotplug = container_of(input->hotplug.list.next,
+				       hotplug,
+				       link);
+
+		/* A device that was removed and added again is a new
+		 * device, a device added and removed again is never
+		 * opened */
+		if (hotplug->removed)
+			device_removed(hotplug->udev_device, input);
+
+		if (hotplug->added &&
+		    (hotplug->removed ||
+		     !udev_input_find_device(input, hotplug->udev_device)))
+			udev_input_add_device(input,
+					      hotplug->udev_device,
+					      NULL);
+
+		udev_hotplug_destroy(input, hotplug);
+	}
+}
+
+static void
+udev_input_drop_hotplug(struct udev_input *input)
+{
+	struct udev_hotplug *hotplug, *tmp;
+
+	libinput_timer_cancel(&input->hotplug.timer);
+
+	list_for_each_safe(hotplug, tmp, &input->hotplug.list, link)
+		udev_hotplug_destroy(input, hotplug);
+}
+
+static void
+udev_input_hotplug_timeout(uint64_t now, void *data)
+{
+	struct udev_input *input = data;
+
+	udev_input_flush_hotplug(input);
 }
 
 static void
@@ -191,38 +784,126 @@ evdev_udev_handler(void *data)
 	struct udev_input *input = data;
 	struct udev_device *udev_device;
 	const char *action;
+	size_t nevents = 0, nqueued = 0;
+
+	/* The monitor socket filters on the input subsystem only, libudev
+	 * cannot filter on the sysname in the kernel */
+	while (nevents < UDEV_HOTPLUG_BATCH_MAX &&
+	       (udev_device = udev_monitor_receive_device(input->udev_monitor))) {
+		nevents++;
+
+		action = udev_device_get_action(udev_device);
+		if (!action ||
+		    strncmp("event", udev_device_get_sysname(udev_device), 5) != 0) {
+			udev_device_unref(udev_device);
+			continue;
+		}
+
+		if (streq(action, "add")) {
+			udev_input_queue_hotplug(input, udev_device, true);
+			nqueued++;
+		} else if (streq(action, "remove")) {
+			udev_input_queue_hotplug(input, udev_device, false);
+			nqueued++;
+		} else {
+			udev_device_unref(udev_device);
+		}
+	}
 
-	udev_device = udev_monitor_receive_device(input->udev_monitor);
-	if (!udev_device)
+	if (nqueued == 0)
 		return;
 
-	action = udev_device_get_action(udev_device);
-	if (!action)
-		goto out;
+	/* A single uevent is handled right away, a burst is held back
+	 * for a moment to coalesce flapping devices */
+	if (input->hotplug.timer.expire != 0)
+		return;
 
-	if (strncmp("event", udev_device_get_sysname(udev_device), 5) != 0)
-		goto out;
+	if (nqueued == 1)
+		udev_input_flush_hotplug(input);
+	else
+		libinput_timer_set(&input->hotplug.timer,
+				   libinput_now(&input->base) +
+				   UDEV_HOTPLUG_COALESCE_TIMEOUT);
+}
 
-	if (streq(action, "add"))
-		device_added(udev_device, input, NULL);
-	else if (streq(action, "remove"))
-		device_removed(udev_device, input);
+static void
+udev_input_remove_devices(struct udev_input *input)
+{
+	struct evdev_device *device, *next;
+	struct udev_seat *seat, *tmp;
 
-out:
-	udev_device_unref(udev_device);
+	list_for_each_safe(seat, tmp, &input->base.seat_list, base.link) {
+		libinput_seat_ref(&seat->base);
+		list_for_each_safe(device, next,
+				   &seat->base.devices_list, base.link) {
+			udev_input_remove_device(input, device);
+		}
+		libinput_seat_unref(&seat->base);
+	}
 }
 
+/* Close the fds of all devices but keep the devices, see
+ * libinput_udev_set_soft_suspend() */
 static void
-udev_input_remove_devices(struct udev_input *input)
+udev_input_suspend_devices(struct udev_input *input)
+{
+	struct evdev_device *device;
+	struct udev_seat *seat;
+
+	list_for_each(seat, &input->base.seat_list, base.link) {
+		list_for_each(device, &seat->base.devices_list, base.link)
+			evdev_device_session_suspend(device);
+	}
+
+	input->base.session_suspended = true;
+}
+
+static int
+udev_input_resume_device(struct udev_input *input,
+			 struct evdev_device *device)
+{
+	if (!libinput_has_async_open(&input->base))
+		return evdev_device_session_resume(device);
+
+	if (!device->session_suspended)
+		return 0;
+
+	return udev_input_open_async(input, device->udev_device, NULL, device);
+}
+
+/* Re-open the devices kept by udev_input_suspend_devices(), devices
+ * that disappeared or changed in the meantime are removed */
+static void
+udev_input_resume_devices(struct udev_input *input)
 {
 	struct evdev_device *device, *next;
+	struct udev_device *udev_device;
 	struct udev_seat *seat, *tmp;
+	const char *syspath;
+
+	input->base.session_suspended = false;
 
 	list_for_each_safe(seat, tmp, &input->base.seat_list, base.link) {
 		libinput_seat_ref(&seat->base);
 		list_for_each_safe(device, next,
 				   &seat->base.devices_list, base.link) {
-			evdev_device_remove(device);
+			syspath = udev_device_get_syspath(device->udev_device);
+			udev_device = udev_device_new_from_syspath(input->udev,
+								   syspath);
+			if (udev_device &&
+			    udev_input_wants_device(input, udev_device) &&
+			    udev_input_resume_device(input, device) == 0) {
+				udev_device_unref(udev_device);
+				continue;
+			}
+
+			log_info(&input->base,
+				 "input device %s, %s removed while suspended\n",
+				 device->devname,
+				 udev_device_get_devnode(device->udev_device));
+			udev_input_remove_device(input, device);
+			if (udev_device)
+				udev_device_unref(udev_device);
 		}
 		libinput_seat_unref(&seat->base);
 	}
@@ -241,7 +922,13 @@ udev_input_disable(struct libinput *libinput)
 	libinput_remove_source(&input->base, input->udev_monitor_source);
 	input->udev_monitor_source = NULL;
 
-	udev_input_remove_devices(input);
+	udev_input_drop_hotplug(input);
+	udev_input_cancel_opens(input, NULL);
+
+	if (input->soft_suspend)
+		udev_input_suspend_devices(input);
+	else
+		udev_input_remove_devices(input);
 }
 
 static int
@@ -251,7 +938,7 @@ udev_input_enable(struct libinput *libinput)
 	struct udev *udev = input->udev;
 	int fd;
 
-	if (input->udev_monitor)
+	if (input->udev_monitor || !input->seats_assigned)
 		return 0;
 
 	input->udev_monitor = udev_monitor_new_from_netlink(udev, "udev");
@@ -282,6 +969,9 @@ udev_input_enable(struct libinput *libinput)
 		return -1;
 	}
 
+	if (libinput->session_suspended)
+		udev_input_resume_devices(input);
+
 	if (udev_input_add_devices(input, udev) < 0) {
 		udev_input_disable(libinput);
 		return -1;
@@ -298,8 +988,13 @@ udev_input_destroy(struct libinput *input)
 	if (input == NULL)
 		return;
 
+	/* devices kept by a soft suspend */
+	udev_input_remove_devices(udev_input);
+	hash_index_destroy(&udev_input->devices);
+	hash_index_destroy(&udev_input->hotplug.index);
+
 	udev_unref(udev_input->udev);
-	free(udev_input->seat_id);
+	udev_input_free_seat_ids(udev_input);
 }
 
 static void
@@ -327,13 +1022,18 @@ udev_seat_create(struct udev_input *input,
 	return seat;
 }
 
+/* Logical seat names are only unique within a physical seat once a
+ * context handles several physical seats */
 static struct udev_seat *
-udev_seat_get_named(struct udev_input *input, const char *seat_name)
+udev_seat_get_named(struct udev_input *input,
+		    const char *device_seat,
+		    const char *seat_name)
 {
 	struct udev_seat *seat;
 
 	list_for_each(seat, &input->base.seat_list, base.link) {
-		if (streq(seat->base.logical_name, seat_name))
+		if (streq(seat->base.physical_name, device_seat) &&
+		    streq(seat->base.logical_name, seat_name))
 			return seat;
 	}
 
@@ -352,7 +1052,7 @@ udev_device_change_seat(struct libinput_device *device,
 
 	udev_device_ref(udev_device);
 	device_removed(udev_device, input);
-	rc = device_added(udev_device, input, seat_name);
+	rc = udev_input_add_device(input, udev_device, seat_name);
 	udev_device_unref(udev_device);
 
 	return rc;
@@ -387,6 +1087,14 @@ libinput_udev_create_context(const struct libinput_interface *interface,
 	}
 
 	input->udev = udev_ref(udev);
+	list_init(&input->opens);
+	hash_index_init(&input->devices);
+	list_init(&input->hotplug.list);
+	hash_index_init(&input->hotplug.index);
+	libinput_timer_init(&input->hotplug.timer,
+			    &input->base,
+			    udev_input_hotplug_timeout,
+			    input);
 
 	return &input->base;
 }
@@ -395,22 +1103,70 @@ LIBINPUT_EXPORT int
 libinput_udev_assign_seat(struct libinput *libinput,
 			  const char *seat_id)
 {
-	struct udev_input *input = (struct udev_input*)libinput;
+	const char *seat_ids[] = { seat_id, NULL };
 
 	if (!seat_id)
 		return -1;
-	if (input->seat_id != NULL)
-		return -1;
+
+	return libinput_udev_assign_seats(libinput, seat_ids);
+}
+
+LIBINPUT_EXPORT int
+libinput_udev_assign_seats(struct libinput *libinput,
+			   const char * const *seat_ids)
+{
+	struct udev_input *input = (struct udev_input*)libinput;
+	size_t nseats = 0;
+	size_t i;
+
+	if (seat_ids) {
+		while (seat_ids[nseats])
+			nseats++;
+		if (nseats == 0)
+			return -1;
+	}
 
 	if (libinput->interface_backend != &interface_backend) {
 		log_bug_client(libinput, "Mismatching backends.\n");
 		return -1;
 	}
 
-	input->seat_id = strdup(seat_id);
+	if (input->seats_assigned)
+		return -1;
+
+	if (seat_ids) {
+		input->seat_ids = zalloc((nseats + 1) * sizeof(char*));
+		if (!input->seat_ids)
+			return -1;
+
+		for (i = 0; i < nseats; i++) {
+			input->seat_ids[i] = strdup(seat_ids[i]);
+			if (!input->seat_ids[i]) {
+				udev_input_free_seat_ids(input);
+				return -1;
+			}
+		}
+	}
+
+	input->seats_assigned = true;
 
 	if (udev_input_enable(&input->base) < 0)
 		return -1;
 
 	return 0;
 }
+
+LIBINPUT_EXPORT int
+libinput_udev_set_soft_suspend(struct libinput *libinput, int enable)
+{
+	struct udev_input *input = (struct udev_input*)libinput;
+
+	if (libinput->interface_backend != &interface_backend) {
+		log_bug_client(libinput, "Mismatching backends.\n");
+		return -1;
+	}
+
+	input->soft_suspend = !!enable;
+
+	return 0;
+}
@@ -28,6 +28,7 @@
 
 #include <libudev.h>
 #include "libinput-private.h"
+#include "timer.h"
 
 struct udev_seat {
 	struct libinput_seat base;
@@ -38,7 +39,20 @@ struct udev_input {
 	struct udev *udev;
 	struct udev_monitor *udev_monitor;
 	struct libinput_source *udev_monitor_source;
-	char *seat_id;
+	/* The ID_SEAT values of the devices this context handles,
+	 * NULL-terminated, or NULL for all seats once seats_assigned */
+	char **seat_ids;
+	bool seats_assigned;
+	bool soft_suspend;
+	struct list opens; /* struct udev_open, in request order */
+	struct hash_index devices; /* struct evdev_device by devnum */
+
+	/* uevents held back to coalesce a burst of hotplug events */
+	struct {
+		struct list list; /* struct udev_hotplug, in arrival order */
+		struct hash_index index; /* struct udev_hotplug by syspath */
+		struct libinput_timer timer;
+	} hotplug;
 };
 
 #endif
@@ -0,0 +1,244 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <config.h>
+
+#include <check.h>
+#include <libinput.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "libinput-util.h"
+#include "litest.h"
+#include "litest-alloc.h"
+#include "litest-int.h"
+
+/* Allocation budget for the steady state: the only heap allocation
+ * allowed per frame is the struct of each event handed to the caller.
+ * This applies to every device class, everything else must be
+ * allocated when the device is added. */
+#define ALLOCS_PER_EVENT 1
+
+/* Number of frames recorded so far, each replay step replays one */
+static uint64_t
+count_frames(struct litest_device *d)
+{
+	uint64_t nframes = 0;
+	size_t i;
+
+	for (i = 0; i < d->recording.nevents; i++) {
+		const struct input_event *ev = &d->recording.events[i];
+
+		if (ev->type == EV_SYN &&
+		    (ev->code == SYN_REPORT || ev->code == SYN_DROPPED))
+			nframes++;
+	}
+
+	return nframes;
+}
+
+static void
+generate_pointer(struct litest_device *d)
+{
+	struct libevdev *evdev = d->evdev;
+	int i;
+
+	if (libevdev_has_event_code(evdev, EV_REL, REL_X)) {
+		for (i = 0; i < 20; i++) {
+			litest_event(d, EV_REL, REL_X, i % 2 ? 1 : 3);
+			litest_event(d, EV_REL, REL_Y, i % 3 ? -2 : 1);
+			litest_event(d, EV_SYN, SYN_REPORT, 0);
+		}
+
+		if (libevdev_has_event_code(evdev, EV_KEY, BTN_LEFT)) {
+			litest_button_click(d, BTN_LEFT, true);
+			litest_button_click(d, BTN_LEFT, false);
+		}
+	}
+
+	if (libevdev_has_event_code(evdev, EV_REL, REL_WHEEL)) {
+		for (i = 0; i < 5; i++) {
+			litest_event(d, EV_REL, REL_WHEEL, -1);
+			litest_event(d, EV_SYN, SYN_REPORT, 0);
+		}
+	}
+
+	if (libevdev_has_event_code(evdev, EV_REL, REL_HWHEEL)) {
+		for (i = 0; i < 5; i++) {
+			litest_event(d, EV_REL, REL_HWHEEL, 1);
+			litest_event(d, EV_SYN, SYN_REPORT, 0);
+		}
+	}
+}
+
+static void
+generate_keys(struct litest_device *d)
+{
+	unsigned int key;
+
+	for (key = KEY_Q; key <= KEY_P; key++) {
+		if (!libevdev_has_event_code(d->evdev, EV_KEY, key))
+			continue;
+
+		litest_keyboard_key(d, key, true);
+		litest_keyboard_key(d, key, false);
+	}
+}
+
+static void
+generate_touch(struct litest_device *d)
+{
+	int i;
+
+	if (!d->interface ||
+	    (!d->interface->touch_down && !d->interface->touch_down_events) ||
+	    !libevdev_has_event_code(d->evdev, EV_ABS, ABS_X))
+		return;
+
+	/* single finger motion */
+	litest_touch_down(d, 0, 30, 30);
+	for (i = 1; i <= 20; i++)
+		litest_touch_move(d, 0, 30 + i, 30 + i);
+	litest_touch_up(d, 0);
+
+	/* tap, followed by enough idle time for the tap timeouts */
+	litest_touch_down(d, 0, 50, 50);
+	litest_touch_up(d, 0);
+	d->recording.time += ms2us(500);
+
+	if (libevdev_get_num_slots(d->evdev) < 2)
+		return;
+
+	/* two-finger scroll */
+	litest_touch_down(d, 0, 40, 30);
+	litest_touch_down(d, 1, 60, 30);
+	for (i = 1; i <= 20; i++) {
+		litest_touch_move(d, 0, 40, 30 + i);
+		litest_touch_move(d, 1, 60, 30 + i);
+	}
+	litest_touch_up(d, 1);
+	litest_touch_up(d, 0);
+
+	/* pinch */
+	litest_touch_down(d, 0, 45, 45);
+	litest_touch_down(d, 1, 55, 55);
+	for (i = 1; i <= 20; i++) {
+		litest_touch_move(d, 0, 45 - i, 45 - i);
+		litest_touch_move(d, 1, 55 + i, 55 + i);
+	}
+	litest_touch_up(d, 1);
+	litest_touch_up(d, 0);
+	d->recording.time += ms2us(500);
+}
+
+static void
+generate_events(struct litest_device *d)
+{
+	generate_pointer(d);
+	generate_keys(d);
+	generate_touch(d);
+}
+
+START_TEST(alloc_steady_state)
+{
+	enum litest_device_type which = _i; /* ranged test */
+	struct litest_device *dev;
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	struct litest_alloc_stats before, after;
+	char path[] = "/tmp/litest-alloc-XXXXXX";
+	uint64_t warmup_frames, frame = 0;
+	uint64_t allocs = 0, frees = 0, nevents = 0;
+	int fd;
+
+	if (!litest_alloc_stats_supported())
+		return;
+
+	dev = litest_create_recorded_device(which);
+	if (!dev)
+		return;
+
+	fd = mkstemp(path);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+
+	/* The first pass warms up whatever gets allocated lazily, only
+	 * the second pass is counted */
+	generate_events(dev);
+	warmup_frames = count_frames(dev);
+	generate_events(dev);
+	litest_recorded_device_write(dev, path);
+	litest_delete_device(dev);
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	ck_assert_notnull(li);
+	device = libinput_replay_add_recording(li, path);
+	ck_assert_notnull(device);
+	unlink(path);
+
+	if (libinput_device_config_tap_get_finger_count(device) > 0)
+		libinput_device_config_tap_set_enabled(device,
+						       LIBINPUT_CONFIG_TAP_ENABLED);
+
+	while ((event = libinput_get_event(li)))
+		libinput_event_destroy(event);
+
+	while (true) {
+		int rc;
+		uint64_t n = 0;
+
+		litest_alloc_stats_get(&before);
+		rc = libinput_replay_step(li);
+		while ((event = libinput_get_event(li))) {
+			n++;
+			libinput_event_destroy(event);
+		}
+		litest_alloc_stats_get(&after);
+
+		if (frame++ >= warmup_frames) {
+			allocs += after.allocs - before.allocs;
+			frees += after.frees - before.frees;
+			nevents += n;
+		}
+
+		if (rc == 0)
+			break;
+	}
+
+	ck_assert_int_le(allocs, nevents * ALLOCS_PER_EVENT);
+	ck_assert_int_eq(allocs, frees);
+
+	libinput_unref(li);
+}
+END_TEST
+
+void
+litest_setup_tests(void)
+{
+	struct range devices;
+
+	litest_device_type_range(&devices);
+	litest_add_ranged_no_device("alloc:steady-state", alloc_steady_state, &devices);
+}
@@ -633,6 +633,48 @@ START_TEST(device_disable_topsoftbutton)
 }
 END_TEST
 
+START_TEST(device_disable_touchpad_on_external_mice)
+{
+	struct litest_device *dev = litest_current_device();
+	struct litest_device *mouse1, *mouse2;
+	struct libinput *li = dev->libinput;
+	struct libinput_device *device;
+	enum libinput_config_status status;
+
+	device = dev->libinput_device;
+
+	status = libinput_device_config_send_events_set_mode(device,
+			LIBINPUT_CONFIG_SEND_EVENTS_DISABLED_ON_EXTERNAL_MOUSE);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+
+	mouse1 = litest_add_device(li, LITEST_MOUSE);
+	mouse2 = litest_add_device(li, LITEST_MOUSE);
+	litest_drain_events(li);
+
+	litest_touch_down(dev, 0, 50, 50);
+	litest_touch_move_to(dev, 0, 50, 50, 90, 90, 10, 0);
+	litest_touch_up(dev, 0);
+	litest_assert_empty_queue(li);
+
+	/* one mouse is left, the touchpad stays disabled */
+	litest_delete_device(mouse1);
+	litest_drain_events(li);
+
+	litest_touch_down(dev, 0, 50, 50);
+	litest_touch_move_to(dev, 0, 50, 50, 90, 90, 10, 0);
+	litest_touch_up(dev, 0);
+	litest_assert_empty_queue(li);
+
+	litest_delete_device(mouse2);
+	litest_drain_events(li);
+
+	litest_touch_down(dev, 0, 50, 50);
+	litest_touch_move_to(dev, 0, 50, 50, 90, 90, 10, 0);
+	litest_touch_up(dev, 0);
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_POINTER_MOTION);
+}
+END_TEST
+
 START_TEST(device_ids)
 {
 	struct litest_device *dev = litest_current_device();
@@ -1283,6 +1325,158 @@ START_TEST(device_quirks_no_abs_mt_y)
 }
 END_TEST
 
+START_TEST(device_latency_histogram)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput_latency_histogram *h;
+	uint64_t total;
+	unsigned int i;
+	int nevents = 0;
+
+	litest_drain_events(li);
+	libinput_device_reset_latency_histograms(device);
+
+	for (i = 0; i < 5; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_REL, REL_Y, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	libinput_dispatch(li);
+
+	/* only dequeued events count for the second stage */
+	h = libinput_device_get_latency_histogram(device,
+						  LIBINPUT_EVENT_POINTER_MOTION,
+						  LIBINPUT_LATENCY_STAGE_DISPATCH_TO_DEQUEUE);
+	ck_assert_notnull(h);
+	ck_assert_int_eq(libinput_latency_histogram_get_count(h), 0);
+	libinput_latency_histogram_destroy(h);
+
+	while (libinput_next_event_type(li) != LIBINPUT_EVENT_NONE) {
+		struct libinput_event *event = libinput_get_event(li);
+
+		ck_assert_int_eq(libinput_event_get_type(event),
+				 LIBINPUT_EVENT_POINTER_MOTION);
+		libinput_event_destroy(event);
+		nevents++;
+	}
+	ck_assert_int_gt(nevents, 0);
+
+	h = libinput_device_get_latency_histogram(device,
+						  LIBINPUT_EVENT_POINTER_MOTION,
+						  LIBINPUT_LATENCY_STAGE_KERNEL_TO_DISPATCH);
+	ck_assert_notnull(h);
+	ck_assert_int_eq(libinput_latency_histogram_get_count(h), nevents);
+	total = 0;
+	for (i = 0; i < libinput_latency_histogram_get_bucket_count(h); i++)
+		total += libinput_latency_histogram_get_bucket_value(h, i);
+	ck_assert_int_eq(total, nevents);
+	ck_assert_int_le(libinput_latency_histogram_get_percentile(h, 50.0),
+			 libinput_latency_histogram_get_max(h));
+	libinput_latency_histogram_destroy(h);
+
+	h = libinput_device_get_latency_histogram(device,
+						  LIBINPUT_EVENT_POINTER_MOTION,
+						  LIBINPUT_LATENCY_STAGE_DISPATCH_TO_DEQUEUE);
+	ck_assert_int_eq(libinput_latency_histogram_get_count(h), nevents);
+	libinput_latency_histogram_destroy(h);
+
+	/* nothing recorded for other event types */
+	h = libinput_device_get_latency_histogram(device,
+						  LIBINPUT_EVENT_POINTER_BUTTON,
+						  LIBINPUT_LATENCY_STAGE_KERNEL_TO_DISPATCH);
+	ck_assert_int_eq(libinput_latency_histogram_get_count(h), 0);
+	ck_assert_int_eq(libinput_latency_histogram_get_max(h), 0);
+	libinput_latency_histogram_destroy(h);
+
+	libinput_device_reset_latency_histograms(device);
+	h = libinput_device_get_latency_histogram(device,
+						  LIBINPUT_EVENT_POINTER_MOTION,
+						  LIBINPUT_LATENCY_STAGE_KERNEL_TO_DISPATCH);
+	ck_assert_int_eq(libinput_latency_histogram_get_count(h), 0);
+	libinput_latency_histogram_destroy(h);
+}
+END_TEST
+
+START_TEST(device_latency_histogram_invalid)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+
+	ck_assert(libinput_device_get_latency_histogram(device,
+							LIBINPUT_EVENT_DEVICE_ADDED,
+							LIBINPUT_LATENCY_STAGE_KERNEL_TO_DISPATCH) == NULL);
+	ck_assert(libinput_device_get_latency_histogram(device,
+							LIBINPUT_EVENT_NONE,
+							LIBINPUT_LATENCY_STAGE_KERNEL_TO_DISPATCH) == NULL);
+	ck_assert(libinput_device_get_latency_histogram(device,
+							LIBINPUT_EVENT_POINTER_MOTION,
+							0) == NULL);
+	ck_assert(libinput_device_get_latency_histogram(device,
+							LIBINPUT_EVENT_POINTER_MOTION,
+							LIBINPUT_LATENCY_STAGE_DISPATCH_TO_DEQUEUE + 1) == NULL);
+}
+END_TEST
+
+START_TEST(device_stats)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_stats *before, *after, *ctx;
+	uint64_t v;
+
+	litest_drain_events(li);
+
+	before = libinput_device_get_stats(dev->libinput_device);
+	ck_assert_notnull(before);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_REL, REL_Y, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	after = libinput_device_get_stats(dev->libinput_device);
+	ck_assert_notnull(after);
+
+#define delta(stat_) \
+	(libinput_stats_get_value(after, stat_) - \
+	 libinput_stats_get_value(before, stat_))
+
+	ck_assert_int_eq(delta(LIBINPUT_STAT_EVDEV_EVENTS), 5);
+	ck_assert_int_eq(delta(LIBINPUT_STAT_FRAMES), 2);
+	ck_assert_int_eq(delta(LIBINPUT_STAT_EVENTS_POSTED), 2);
+	ck_assert_int_eq(delta(LIBINPUT_STAT_EVENTS_MERGED), 1);
+	ck_assert_int_eq(delta(LIBINPUT_STAT_SYN_DROPPED), 0);
+#undef delta
+
+	/* context-only counters */
+	ck_assert_int_eq(libinput_stats_get_value(after,
+						  LIBINPUT_STAT_QUEUE_HIGH_WATER_MARK),
+			 0);
+	ck_assert_int_eq(libinput_stats_get_value(after, 0), 0);
+	ck_assert_int_eq(libinput_stats_get_value(after,
+						  LIBINPUT_STAT_DISPATCH_TIME + 1),
+			 0);
+
+	ctx = libinput_get_stats(li);
+	ck_assert_notnull(ctx);
+	v = libinput_stats_get_value(ctx, LIBINPUT_STAT_EVDEV_EVENTS);
+	ck_assert_int_ge(v, libinput_stats_get_value(after,
+						     LIBINPUT_STAT_EVDEV_EVENTS));
+	v = libinput_stats_get_value(ctx, LIBINPUT_STAT_QUEUE_HIGH_WATER_MARK);
+	ck_assert_int_ge(v, 2);
+
+	libinput_stats_destroy(before);
+	libinput_stats_destroy(after);
+	libinput_stats_destroy(ctx);
+
+	litest_drain_events(li);
+}
+END_TEST
+
 void
 litest_setup_tests(void)
 {
@@ -1307,6 +1501,7 @@ litest_setup_tests(void)
 	litest_add("device:sendevents", device_disable_release_tap_n_drag, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add("device:sendevents", device_disable_release_softbutton, LITEST_CLICKPAD, LITEST_APPLE_CLICKPAD);
 	litest_add("device:sendevents", device_disable_topsoftbutton, LITEST_TOPBUTTONPAD, LITEST_ANY);
+	litest_add_for_device("device:sendevents", device_disable_touchpad_on_external_mice, LITEST_SYNAPTICS_CLICKPAD);
 	litest_add("device:id", device_ids, LITEST_ANY, LITEST_ANY);
 	litest_add_for_device("device:context", device_context, LITEST_SYNAPTICS_CLICKPAD);
 
@@ -1328,6 +1523,11 @@ litest_setup_tests(void)
 	litest_add("device:wheel", device_wheel_only, LITEST_WHEEL, LITEST_RELATIVE|LITEST_ABSOLUTE);
 	litest_add_no_device("device:accelerometer", device_accelerometer);
 
+	litest_add_for_device("device:latency", device_latency_histogram, LITEST_MOUSE);
+	litest_add("device:latency", device_latency_histogram_invalid, LITEST_ANY, LITEST_ANY);
+
+	litest_add_for_device("device:stats", device_stats, LITEST_MOUSE);
+
 	litest_add("device:udev tags", device_udev_tag_alps, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add("device:udev tags", device_udev_tag_wacom, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add("device:udev tags", device_udev_tag_apple, LITEST_TOUCHPAD, LITEST_ANY);
@@ -0,0 +1,356 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Throughput benchmark for the event processing. The event streams are
+ * generated with the litest device descriptions into in-memory recorded
+ * devices and replayed with libinput_replay_step(), no uinput device,
+ * root or udev is required.
+ *
+ * Results are printed as JSON to stdout.
+ */
+
+#include <config.h>
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libinput-util.h"
+#include "litest.h"
+#include "litest-alloc.h"
+#include "litest-int.h"
+
+struct bench {
+	const char *name;
+	enum litest_device_type device;
+	uint64_t interval; /* us between frames */
+	void (*generate)(struct litest_device *d, int iterations);
+	int iterations;
+};
+
+static void
+generate_1fg_motion(struct litest_device *d, int iterations)
+{
+	int i, j;
+
+	for (i = 0; i < iterations; i++) {
+		litest_touch_down(d, 0, 20, 20);
+		for (j = 1; j <= 60; j++)
+			litest_touch_move(d, 0, 20 + j, 20 + j/2.0);
+		litest_touch_up(d, 0);
+	}
+}
+
+static void
+generate_2fg_scroll(struct litest_device *d, int iterations)
+{
+	int i, j;
+
+	for (i = 0; i < iterations; i++) {
+		litest_touch_down(d, 0, 40, 20);
+		litest_touch_down(d, 1, 60, 20);
+		for (j = 1; j <= 60; j++) {
+			litest_touch_move(d, 0, 40, 20 + j);
+			litest_touch_move(d, 1, 60, 20 + j);
+		}
+		litest_touch_up(d, 1);
+		litest_touch_up(d, 0);
+	}
+}
+
+static void
+generate_pinch(struct litest_device *d, int iterations)
+{
+	int i, j;
+
+	for (i = 0; i < iterations; i++) {
+		litest_touch_down(d, 0, 45, 45);
+		litest_touch_down(d, 1, 55, 55);
+		for (j = 1; j <= 30; j++) {
+			litest_touch_move(d, 0, 45 - j, 45 - j);
+			litest_touch_move(d, 1, 55 + j, 55 + j);
+		}
+		litest_touch_up(d, 1);
+		litest_touch_up(d, 0);
+	}
+}
+
+static void
+generate_10fg_touch(struct litest_device *d, int iterations)
+{
+	int i, j, slot;
+	int nslots = min(libevdev_get_num_slots(d->evdev), 10);
+
+	for (i = 0; i < iterations; i++) {
+		for (slot = 0; slot < nslots; slot++)
+			litest_touch_down(d, slot, 5 + slot * 9, 20);
+		for (j = 1; j <= 30; j++) {
+			for (slot = 0; slot < nslots; slot++)
+				litest_touch_move(d, slot, 5 + slot * 9, 20 + j * 2);
+		}
+		for (slot = 0; slot < nslots; slot++)
+			litest_touch_up(d, slot);
+	}
+}
+
+static void
+generate_rel_motion(struct litest_device *d, int iterations)
+{
+	int i, j;
+
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < 100; j++) {
+			litest_event(d, EV_REL, REL_X, j % 2 ? 1 : 2);
+			litest_event(d, EV_REL, REL_Y, j % 3 ? -1 : 1);
+			litest_event(d, EV_SYN, SYN_REPORT, 0);
+		}
+		litest_button_click(d, BTN_LEFT, true);
+		litest_button_click(d, BTN_LEFT, false);
+	}
+}
+
+static void
+generate_key_storm(struct litest_device *d, int iterations)
+{
+	int i;
+	unsigned int key;
+
+	for (i = 0; i < iterations; i++) {
+		for (key = KEY_Q; key <= KEY_P; key++)
+			litest_keyboard_key(d, key, true);
+		for (key = KEY_Q; key <= KEY_P; key++)
+			litest_keyboard_key(d, key, false);
+	}
+}
+
+static const struct bench benchmarks[] = {
+	{ "touchpad-1fg-motion", LITEST_SYNAPTICS_TOPBUTTONPAD,
+	  12000, generate_1fg_motion, 500 },
+	{ "touchpad-2fg-scroll", LITEST_MAGIC_TRACKPAD,
+	  6000, generate_2fg_scroll, 250 },
+	{ "touchpad-pinch", LITEST_MAGIC_TRACKPAD,
+	  6000, generate_pinch, 250 },
+	{ "touchscreen-10fg", LITEST_NEXUS4_TOUCH_SCREEN,
+	  1000, generate_10fg_touch, 50 },
+	{ "mouse-8khz", LITEST_MOUSE_ROCCAT,
+	  125, generate_rel_motion, 300 },
+	{ "keyboard-storm", LITEST_KEYBOARD_BLACKWIDOW,
+	  1000, generate_key_storm, 1000 },
+};
+
+static inline uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t
+stat_value(struct libinput *li, enum libinput_stat stat)
+{
+	struct libinput_stats *stats;
+	uint64_t value;
+
+	stats = libinput_get_stats(li);
+	value = libinput_stats_get_value(stats, stat);
+	libinput_stats_destroy(stats);
+
+	return value;
+}
+
+static void
+run_benchmark(const struct bench *b, double scale, bool first)
+{
+	struct litest_device *d;
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	struct latency_histogram histogram;
+	char path[] = "/tmp/libinput-bench-XXXXXX";
+	uint64_t start, end, frame_start, frame_end;
+	uint64_t frames = 0, events = 0;
+	struct litest_alloc_stats allocs_start, allocs_end;
+	int fd;
+
+	fd = mkstemp(path);
+	litest_assert_int_ge(fd, 0);
+	close(fd);
+
+	d = litest_create_recorded_device(b->device);
+	d->recording.interval = b->interval;
+	b->generate(d, max(1, (int)(b->iterations * scale)));
+	litest_recorded_device_write(d, path);
+	litest_delete_device(d);
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	litest_assert_notnull(li);
+	device = libinput_replay_add_recording(li, path);
+	litest_assert_notnull(device);
+	unlink(path);
+
+	while ((event = libinput_get_event(li)))
+		libinput_event_destroy(event);
+
+	memset(&histogram, 0, sizeof(histogram));
+
+	litest_alloc_stats_get(&allocs_start);
+	start = now_ns();
+	while (true) {
+		int rc;
+
+		frame_start = now_ns();
+		rc = libinput_replay_step(li);
+		frame_end = now_ns();
+
+		if (rc == 0)
+			break;
+
+		frames++;
+		latency_histogram_add(&histogram, frame_end - frame_start);
+
+		while ((event = libinput_get_event(li))) {
+			events++;
+			libinput_event_destroy(event);
+		}
+	}
+	end = now_ns();
+	litest_alloc_stats_get(&allocs_end);
+
+	while ((event = libinput_get_event(li)))
+		libinput_event_destroy(event);
+
+	printf("%s\n"
+	       "    {\n"
+	       "      \"name\": \"%s\",\n"
+	       "      \"device\": \"%s\",\n"
+	       "      \"frames\": %" PRIu64 ",\n"
+	       "      \"evdev_events\": %" PRIu64 ",\n"
+	       "      \"libinput_events\": %" PRIu64 ",\n"
+	       "      \"events_per_sec\": %.0f,\n"
+	       "      \"ns_per_frame\": %.1f,\n",
+	       first ? "" : ",",
+	       b->name,
+	       libinput_device_get_name(device),
+	       frames,
+	       stat_value(li, LIBINPUT_STAT_EVDEV_EVENTS),
+	       events,
+	       stat_value(li, LIBINPUT_STAT_EVDEV_EVENTS) * 1e9 / max(end - start, 1),
+	       (double)(end - start) / max(frames, 1));
+	if (litest_alloc_stats_supported())
+		printf("      \"allocs_per_frame\": %.2f,\n",
+		       (double)(allocs_end.allocs - allocs_start.allocs) /
+				max(frames, 1));
+	else
+		printf("      \"allocs_per_frame\": null,\n");
+	printf("      \"p50_ns\": %" PRIu64 ",\n"
+	       "      \"p99_ns\": %" PRIu64 ",\n"
+	       "      \"max_ns\": %" PRIu64 "\n"
+	       "    }",
+	       latency_histogram_percentile(&histogram, 50),
+	       latency_histogram_percentile(&histogram, 99),
+	       histogram.max);
+
+	libinput_unref(li);
+}
+
+static void
+usage(void)
+{
+	printf("Usage: libinput-bench [--help] [--filter=<name>] [--scale=<factor>]\n"
+	       "\n"
+	       "Replays synthesized event streams through libinput and prints\n"
+	       "the results as JSON.\n"
+	       "\n"
+	       "Options:\n"
+	       "--filter=<name> ... only run benchmarks matching name\n"
+	       "--scale=<factor> .. scale the number of iterations, default 1.0\n"
+	       "--help ............ print this help\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *filter = NULL;
+	double scale = 1.0;
+	bool first = true;
+	size_t i;
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		static struct option opts[] = {
+			{ "filter", 1, 0, 'f' },
+			{ "scale", 1, 0, 's' },
+			{ "help", 0, 0, 'h' },
+			{ 0, 0, 0, 0 },
+		};
+
+		c = getopt_long(argc, argv, "f:s:h", opts, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'f':
+			filter = optarg;
+			break;
+		case 's':
+			scale = atof(optarg);
+			if (scale <= 0) {
+				usage();
+				return 1;
+			}
+			break;
+		case 'h':
+			usage();
+			return 0;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	printf("{\n"
+	       "  \"benchmarks\": [");
+
+	for (i = 0; i < ARRAY_LENGTH(benchmarks); i++) {
+		if (filter && !strstr(benchmarks[i].name, filter))
+			continue;
+
+		run_benchmark(&benchmarks[i], scale, first);
+		first = false;
+	}
+
+	printf("\n  ]\n"
+	       "}\n");
+
+	return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LITEST_ALLOC_H
+#define LITEST_ALLOC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Counters of the malloc interposer in litest-alloc.c. Only programs
+ * linking litest-alloc.c get the interposer, the counters are per
+ * process and not thread-safe. */
+struct litest_alloc_stats {
+	uint64_t allocs; /* malloc, calloc and realloc calls */
+	uint64_t frees; /* free calls with a non-NULL pointer */
+};
+
+bool litest_alloc_stats_supported(void);
+void litest_alloc_stats_get(struct litest_alloc_stats *stats);
+
+#endif
@@ -55,7 +55,7 @@ static const char udev_rule[] =
 "KERNEL!=\"event*\", GOTO=\"touchpad_end\"\n"
 "ENV{ID_INPUT_TOUCHPAD}==\"\", GOTO=\"touchpad_end\"\n"
 "\n"
-"ATTRS{name}==\"litest Low DPI Mouse*\",\\\n"
+"ATTRS{name}==\"litest *Low DPI Mouse*\",\\\n"
 "    ENV{MOUSE_DPI}=\"400@125\"\n"
 "\n"
 "LABEL=\"touchpad_end\"";
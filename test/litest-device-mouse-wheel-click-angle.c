@@ -54,7 +54,7 @@ static const char udev_rule[] =
 "ACTION==\"remove\", GOTO=\"wheel_click_angle_end\"\n"
 "KERNEL!=\"event*\", GOTO=\"wheel_click_angle_end\"\n"
 "\n"
-"ATTRS{name}==\"litest Wheel Click Angle Mouse*\",\\\n"
+"ATTRS{name}==\"litest *Wheel Click Angle Mouse*\",\\\n"
 "    ENV{MOUSE_WHEEL_CLICK_ANGLE}=\"-7\"\n"
 "\n"
 "LABEL=\"wheel_click_angle_end\"";
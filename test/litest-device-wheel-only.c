@@ -49,7 +49,7 @@ static const char udev_rule[] =
 "ACTION==\"remove\", GOTO=\"wheel_only_end\"\n"
 "KERNEL!=\"event*\", GOTO=\"wheel_only_end\"\n"
 "\n"
-"ATTRS{name}==\"litest wheel only device*\",\\\n"
+"ATTRS{name}==\"litest *wheel only device*\",\\\n"
 "    ENV{ID_INPUT_KEY}=\"1\"\n"
 "\n"
 "LABEL=\"wheel_only_end\"";
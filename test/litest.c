@@ -40,6 +40,7 @@
 #include <time.h>
 #include <unistd.h>
 #include "linux/input.h"
+#include <sys/mman.h>
 #include <sys/ptrace.h>
 #include <sys/sendfile.h>
 #include <sys/timerfd.h>
@@ -51,6 +52,7 @@
 #include "litest.h"
 #include "litest-int.h"
 #include "libinput-util.h"
+#include "record-writer.h"
 
 #define UDEV_RULES_D "/run/udev/rules.d"
 #define UDEV_RULE_PREFIX "99-litest-"
@@ -64,6 +66,9 @@
 
 static int in_debugger = -1;
 static int verbose = 0;
+static bool use_fake_devices = false;
+static int jobs = 1;
+static int worker_id = -1; /* only set in the workers for --jobs */
 const char *filter_test = NULL;
 const char *filter_device = NULL;
 const char *filter_group = NULL;
@@ -437,12 +442,30 @@ litest_reload_udev_rules(void)
 	litest_system("udevadm hwdb --update");
 }
 
+/* With --jobs, each worker's devices and udev rules carry the worker's
+ * tag so the workers don't remove each other's rules. The device tag
+ * goes after the "litest " prefix that the udev rules match on. */
+static const char *
+litest_worker_tag(char *buf, size_t len, char separator)
+{
+	if (worker_id < 0)
+		return "";
+
+	snprintf(buf, len, "w%d%c", worker_id, separator);
+	return buf;
+}
+
 static int
 litest_udev_rule_filter(const struct dirent *entry)
 {
-	return strneq(entry->d_name,
-		      UDEV_RULE_PREFIX,
-		      strlen(UDEV_RULE_PREFIX));
+	char prefix[64];
+	char tag[16];
+
+	snprintf(prefix, sizeof(prefix), "%s%s",
+		 UDEV_RULE_PREFIX,
+		 litest_worker_tag(tag, sizeof(tag), '-'));
+
+	return strneq(entry->d_name, prefix, strlen(prefix));
 }
 
 static void
@@ -556,7 +579,10 @@ litest_add_tcase_no_device(struct suite *suite,
 	t->name = strdup(test_name);
 	t->tc = tcase_create(test_name);
 	list_insert(&suite->tests, &t->node);
-	tcase_add_test(t->tc, func);
+	if (range)
+		tcase_add_loop_test(t->tc, func, range->lower, range->upper);
+	else
+		tcase_add_test(t->tc, func);
 	suite_add_tcase(suite->suite, t->tc);
 }
 
@@ -820,6 +846,136 @@ struct libinput_interface interface = {
 	.close_restricted = close_restricted,
 };
 
+struct litest_worker_stats {
+	int nrun;
+	int nfailed;
+};
+
+struct litest_jobs_state {
+	unsigned int next_item;
+	struct litest_worker_stats workers[];
+};
+
+/* Item n of the test x device matrix, each test case is run by one
+ * worker */
+static bool
+litest_find_item(unsigned int n, struct suite **suite, struct test **test)
+{
+	struct suite *s;
+	struct test *t;
+
+	list_for_each(s, &all_tests, node) {
+		list_for_each(t, &s->tests, node) {
+			if (n-- > 0)
+				continue;
+
+			*suite = s;
+			*test = t;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+litest_run_worker(struct litest_jobs_state *state, int id)
+{
+	struct litest_worker_stats *stats = &state->workers[id];
+	struct suite *s;
+	struct test *t;
+	unsigned int n;
+
+	worker_id = id;
+
+	while (true) {
+		Suite *suite;
+		SRunner *sr;
+
+		n = __sync_fetch_and_add(&state->next_item, 1);
+		if (!litest_find_item(n, &s, &t))
+			break;
+
+		suite = suite_create(s->name);
+		suite_add_tcase(suite, t->tc);
+		sr = srunner_create(suite);
+		srunner_run_all(sr, CK_ENV);
+		stats->nrun += srunner_ntests_run(sr);
+		stats->nfailed += srunner_ntests_failed(sr);
+		srunner_free(sr);
+	}
+}
+
+/* Run the test cases in nworkers processes. Each worker's output goes
+ * into a temporary file and is printed once all workers finished, so
+ * the output is not interleaved */
+static int
+litest_run_parallel(int nworkers)
+{
+	struct litest_jobs_state *state;
+	size_t size;
+	FILE **output;
+	pid_t *pids;
+	int i, status;
+	int nrun = 0, failed = 0;
+	char buf[4096];
+	size_t len;
+
+	size = sizeof(*state) + nworkers * sizeof(state->workers[0]);
+	state = mmap(NULL, size, PROT_READ|PROT_WRITE,
+		     MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+	litest_assert(state != MAP_FAILED);
+	memset(state, 0, size);
+
+	output = zalloc(nworkers * sizeof(*output));
+	pids = zalloc(nworkers * sizeof(*pids));
+	litest_assert(output && pids);
+
+	fflush(stdout);
+	fflush(stderr);
+
+	for (i = 0; i < nworkers; i++) {
+		output[i] = tmpfile();
+		litest_assert_notnull(output[i]);
+
+		pids[i] = fork();
+		litest_assert_int_ge(pids[i], 0);
+		if (pids[i] == 0) {
+			dup2(fileno(output[i]), STDOUT_FILENO);
+			dup2(fileno(output[i]), STDERR_FILENO);
+			litest_run_worker(state, i);
+			fflush(stdout);
+			fflush(stderr);
+			_exit(0);
+		}
+	}
+
+	for (i = 0; i < nworkers; i++) {
+		waitpid(pids[i], &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "litest: worker %d failed\n", i);
+			failed++;
+		}
+
+		rewind(output[i]);
+		while ((len = fread(buf, 1, sizeof(buf), output[i])) > 0)
+			fwrite(buf, 1, len, stdout);
+		fclose(output[i]);
+
+		nrun += state->workers[i].nrun;
+		failed += state->workers[i].nfailed;
+	}
+
+	printf("litest: %d workers, Checks: %d, Failures: %d\n",
+	       nworkers, nrun, failed);
+
+	munmap(state, size);
+	free(output);
+	free(pids);
+
+	return failed;
+}
+
 static inline int
 litest_run(int argc, char **argv)
 {
@@ -839,6 +995,11 @@ litest_run(int argc, char **argv)
 			setenv("CK_FORK", "no", 0);
 	}
 
+	if (jobs == 1 && getenv("LITEST_JOBS"))
+		jobs = atoi(getenv("LITEST_JOBS"));
+	if (in_debugger || jobs < 1)
+		jobs = 1;
+
 	list_for_each(s, &all_tests, node) {
 		if (!sr)
 			sr = srunner_create(s->suite);
@@ -848,11 +1009,18 @@ litest_run(int argc, char **argv)
 
 	if (getenv("LITEST_VERBOSE"))
 		verbose = 1;
+	if (getenv("LITEST_FAKE_DEVICES"))
+		use_fake_devices = true;
 
-	litest_init_udev_rules();
+	if (!use_fake_devices)
+		litest_init_udev_rules();
 
-	srunner_run_all(sr, CK_ENV);
-	failed = srunner_ntests_failed(sr);
+	if (jobs > 1) {
+		failed = litest_run_parallel(jobs);
+	} else {
+		srunner_run_all(sr, CK_ENV);
+		failed = srunner_ntests_failed(sr);
+	}
 	srunner_free(sr);
 
 	list_for_each_safe(s, snext, &all_tests, node) {
@@ -869,8 +1037,10 @@ litest_run(int argc, char **argv)
 		free(s);
 	}
 
-	litest_remove_model_quirks();
-	litest_reload_udev_rules();
+	if (!use_fake_devices) {
+		litest_remove_model_quirks();
+		litest_reload_udev_rules();
+	}
 
 	return failed;
 }
@@ -1020,19 +1190,23 @@ litest_init_device_udev_rules(struct litest_test_device *dev)
 	int rc;
 	FILE *f;
 	char *path = NULL;
+	char tag[16];
+	const char *worker_tag = litest_worker_tag(tag, sizeof(tag), '-');
 
 	if (!dev->udev_rule)
 		return NULL;
 
 	rc = xasprintf(&path,
-		      "%s/%s%s.rules",
+		      "%s/%s%s%s.rules",
 		      UDEV_RULES_D,
 		      UDEV_RULE_PREFIX,
+		      worker_tag,
 		      dev->shortname);
 	litest_assert_int_eq(rc,
 			     (int)(
 				   strlen(UDEV_RULES_D) +
 				   strlen(UDEV_RULE_PREFIX) +
+				   strlen(worker_tag) +
 				   strlen(dev->shortname) + 7));
 	f = fopen(path, "w");
 	litest_assert_notnull(f);
@@ -1044,6 +1218,24 @@ litest_init_device_udev_rules(struct litest_test_device *dev)
 	return path;
 }
 
+static struct litest_test_device **
+litest_find_test_device(enum litest_device_type which)
+{
+	struct litest_test_device **dev;
+
+	dev = devices;
+	while (*dev) {
+		if ((*dev)->type == which)
+			break;
+		dev++;
+	}
+
+	if (!*dev)
+		ck_abort_msg("Invalid device type %d\n", which);
+
+	return dev;
+}
+
 static struct litest_device *
 litest_create(enum litest_device_type which,
 	      const char *name_override,
@@ -1059,15 +1251,7 @@ litest_create(enum litest_device_type which,
 	int *events;
 	char *udev_file;
 
-	dev = devices;
-	while (*dev) {
-		if ((*dev)->type == which)
-			break;
-		dev++;
-	}
-
-	if (!*dev)
-		ck_abort_msg("Invalid device type %d\n", which);
+	dev = litest_find_test_device(which);
 
 	d = zalloc(sizeof(*d));
 	litest_assert(d != NULL);
@@ -1104,16 +1288,152 @@ litest_create(enum litest_device_type which,
 
 }
 
-struct libinput *
-litest_create_context(void)
+static void
+litest_init_context(struct libinput *libinput)
 {
-	struct libinput *libinput =
-		libinput_path_create_context(&interface, NULL);
 	litest_assert_notnull(libinput);
 
 	libinput_log_set_handler(libinput, litest_log_handler);
 	if (verbose)
 		libinput_log_set_priority(libinput, LIBINPUT_LOG_PRIORITY_DEBUG);
+}
+
+struct libinput *
+litest_create_context(void)
+{
+	struct libinput *libinput =
+		libinput_path_create_context(&interface, NULL);
+
+	litest_init_context(libinput);
+
+	return libinput;
+}
+
+/* Contexts owned by litest devices run on a virtual clock, the
+ * litest_timeout_* helpers advance it instead of sleeping. Set
+ * LITEST_REAL_TIME to use the real clock instead. */
+struct virtual_time_context {
+	struct list node;
+	struct libinput *libinput;
+	bool fake; /* replay context for fake devices */
+};
+
+static struct list virtual_time_contexts;
+
+static inline void
+litest_virtual_time_init_list(void)
+{
+	if (virtual_time_contexts.next == NULL &&
+	    virtual_time_contexts.prev == NULL)
+		list_init(&virtual_time_contexts);
+}
+
+static void
+litest_virtual_time_register(struct libinput *libinput, bool fake)
+{
+	struct virtual_time_context *c;
+
+	litest_virtual_time_init_list();
+
+	litest_assert_int_eq(libinput_enable_virtual_time(libinput), 0);
+
+	c = zalloc(sizeof(*c));
+	litest_assert_notnull(c);
+	c->libinput = libinput;
+	c->fake = fake;
+	list_insert(&virtual_time_contexts, &c->node);
+}
+
+static void
+litest_virtual_time_unregister(struct libinput *libinput)
+{
+	struct virtual_time_context *c, *tmp;
+
+	litest_virtual_time_init_list();
+
+	list_for_each_safe(c, tmp, &virtual_time_contexts, node) {
+		if (c->libinput != libinput)
+			continue;
+
+		list_remove(&c->node);
+		free(c);
+	}
+}
+
+static bool
+litest_is_fake_context(struct libinput *libinput)
+{
+	struct virtual_time_context *c;
+
+	litest_virtual_time_init_list();
+
+	list_for_each(c, &virtual_time_contexts, node) {
+		if (c->libinput == libinput)
+			return c->fake;
+	}
+
+	return false;
+}
+
+static bool
+litest_uses_virtual_time(struct libinput *libinput)
+{
+	struct virtual_time_context *c;
+
+	litest_virtual_time_init_list();
+
+	list_for_each(c, &virtual_time_contexts, node) {
+		if (c->libinput == libinput)
+			return true;
+	}
+
+	return false;
+}
+
+/* Events already written to the device are read first so they get
+ * timestamped before the clock moves, like they would be by the kernel */
+static void
+litest_advance_time(struct libinput *libinput, unsigned int ms)
+{
+	libinput_dispatch(libinput);
+	libinput_advance_virtual_time(libinput, ms2us(ms));
+}
+
+void
+litest_timeout(unsigned int ms)
+{
+	struct virtual_time_context *c;
+
+	litest_virtual_time_init_list();
+
+	if (list_empty(&virtual_time_contexts)) {
+		msleep(ms);
+		return;
+	}
+
+	list_for_each(c, &virtual_time_contexts, node)
+		litest_advance_time(c->libinput, ms);
+}
+
+static void
+litest_sleep(struct litest_device *d, unsigned int ms)
+{
+	if (litest_uses_virtual_time(d->libinput))
+		litest_advance_time(d->libinput, ms);
+	else
+		msleep(ms);
+}
+
+/* A replay context that only holds fake devices, events are injected
+ * by litest_event() and the clock only moves with litest_timeout() */
+static struct libinput *
+litest_create_fake_context(void)
+{
+	struct libinput *libinput =
+		libinput_replay_create_manual_context(&interface, NULL);
+
+	litest_init_context(libinput);
+	litest_virtual_time_register(libinput, true);
 
 	return libinput;
 }
@@ -1130,6 +1450,26 @@ litest_restore_log_handler(struct libinput *libinput)
 	libinput_log_set_handler(libinput, litest_log_handler);
 }
 
+static void
+litest_init_interface_ranges(struct litest_device *d)
+{
+	if (!d->interface)
+		return;
+
+	d->interface->min[ABS_X] = libevdev_get_abs_minimum(d->evdev, ABS_X);
+	d->interface->max[ABS_X] = libevdev_get_abs_maximum(d->evdev, ABS_X);
+	d->interface->min[ABS_Y] = libevdev_get_abs_minimum(d->evdev, ABS_Y);
+	d->interface->max[ABS_Y] = libevdev_get_abs_maximum(d->evdev, ABS_Y);
+}
+
+static struct litest_device *
+litest_add_fake_device(struct libinput *libinput,
+		       enum litest_device_type which,
+		       const char *name_override,
+		       struct input_id *id_override,
+		       const struct input_absinfo *abs_override,
+		       const int *events_override);
+
 struct litest_device *
 litest_add_device_with_overrides(struct libinput *libinput,
 				 enum litest_device_type which,
@@ -1143,6 +1483,18 @@ litest_add_device_with_overrides(struct libinput *libinput,
 	int rc;
 	const char *path;
 
+	if (litest_is_fake_context(libinput)) {
+		d = litest_add_fake_device(libinput,
+					   which,
+					   name_override,
+					   id_override,
+					   abs_override,
+					   events_override);
+		litest_assert_msg(d != NULL,
+				  "Device cannot be added to a fake context\n");
+		return d;
+	}
+
 	d = litest_create(which,
 			  name_override,
 			  id_override,
@@ -1162,12 +1514,7 @@ litest_add_device_with_overrides(struct libinput *libinput,
 	litest_assert(d->libinput_device != NULL);
 	libinput_device_ref(d->libinput_device);
 
-	if (d->interface) {
-		d->interface->min[ABS_X] = libevdev_get_abs_minimum(d->evdev, ABS_X);
-		d->interface->max[ABS_X] = libevdev_get_abs_maximum(d->evdev, ABS_X);
-		d->interface->min[ABS_Y] = libevdev_get_abs_minimum(d->evdev, ABS_Y);
-		d->interface->max[ABS_Y] = libevdev_get_abs_maximum(d->evdev, ABS_Y);
-	}
+	litest_init_interface_ranges(d);
 	return d;
 }
 
@@ -1190,13 +1537,35 @@ litest_create_device_with_overrides(enum litest_device_type which,
 				    const struct input_absinfo *abs_override,
 				    const int *events_override)
 {
-	struct litest_device *dev =
-		litest_add_device_with_overrides(litest_create_context(),
-						 which,
-						 name_override,
-						 id_override,
-						 abs_override,
-						 events_override);
+	struct litest_device *dev = NULL;
+	struct libinput *libinput;
+
+	if (use_fake_devices) {
+		libinput = litest_create_fake_context();
+		dev = litest_add_fake_device(libinput,
+					     which,
+					     name_override,
+					     id_override,
+					     abs_override,
+					     events_override);
+		/* devices with a custom create always need uinput */
+		if (!dev) {
+			litest_virtual_time_unregister(libinput);
+			libinput_unref(libinput);
+		}
+	}
+
+	if (!dev) {
+		dev = litest_add_device_with_overrides(litest_create_context(),
+						       which,
+						       name_override,
+						       id_override,
+						       abs_override,
+						       events_override);
+		if (!getenv("LITEST_REAL_TIME"))
+			litest_virtual_time_register(dev->libinput, false);
+	}
+
 	dev->owns_context = true;
 	return dev;
 }
@@ -1207,6 +1576,240 @@ litest_create_device(enum litest_device_type which)
 	return litest_create_device_with_overrides(which, NULL, NULL, NULL, NULL);
 }
 
+static struct libevdev *
+litest_create_evdev(const char *name,
+		    const struct input_id *id,
+		    const struct input_absinfo *abs_info,
+		    const int *events);
+
+static void
+litest_recording_add_property(struct litest_device *d,
+			      const char *property)
+{
+	size_t len = strlen(property) + 1;
+
+	litest_assert_int_le(d->recording.properties_size + len,
+			     sizeof(d->recording.properties));
+	memcpy(&d->recording.properties[d->recording.properties_size],
+	       property,
+	       len);
+	d->recording.properties_size += len;
+}
+
+/* There is no udev to apply the device's udev rule, so take the
+ * ENV{KEY}="value" assignments from it. The match conditions are
+ * ignored. */
+static void
+litest_recording_add_udev_rule_properties(struct litest_device *d,
+					  const char *rule)
+{
+	const char *p = rule;
+	const char *key, *key_end, *value, *value_end;
+	char property[256];
+
+	while ((p = strstr(p, "ENV{"))) {
+		key = p + 4;
+		key_end = strchr(key, '}');
+		if (!key_end)
+			break;
+
+		/* skip comparisons like ENV{KEY}=="value" */
+		p = key_end + 1;
+		if (!strneq(p, "=\"", 2))
+			continue;
+
+		value = p + 2;
+		value_end = strchr(value, '"');
+		if (!value_end)
+			break;
+
+		snprintf(property, sizeof(property), "%.*s=%.*s",
+			 (int)(key_end - key), key,
+			 (int)(value_end - value), value);
+		litest_recording_add_property(d, property);
+
+		p = value_end + 1;
+	}
+}
+
+/* Approximates the udev input_id builtin */
+static void
+litest_recording_init_properties(struct litest_device *d,
+				 enum litest_device_feature features)
+{
+	bool is_keyboard = true;
+	int code;
+
+	litest_recording_add_property(d, "ID_INPUT=1");
+
+	if (features & LITEST_TOUCHPAD)
+		litest_recording_add_property(d, "ID_INPUT_TOUCHPAD=1");
+	else if (features & LITEST_TOUCH)
+		litest_recording_add_property(d, "ID_INPUT_TOUCHSCREEN=1");
+
+	if (features & (LITEST_RELATIVE|LITEST_POINTINGSTICK))
+		litest_recording_add_property(d, "ID_INPUT_MOUSE=1");
+	if (features & LITEST_POINTINGSTICK)
+		litest_recording_add_property(d, "ID_INPUT_POINTINGSTICK=1");
+
+	if (features & LITEST_KEYS) {
+		litest_recording_add_property(d, "ID_INPUT_KEY=1");
+
+		for (code = KEY_ESC; code <= KEY_D; code++) {
+			if (!libevdev_has_event_code(d->evdev, EV_KEY, code))
+				is_keyboard = false;
+		}
+		if (is_keyboard)
+			litest_recording_add_property(d,
+						      "ID_INPUT_KEYBOARD=1");
+	}
+}
+
+/**
+ * Create a test device that is not backed by a uinput device. Events
+ * sent to this device are stored in memory with a timestamp that
+ * increases by d->recording.interval after each SYN_REPORT. Use
+ * litest_recorded_device_write() to write them into a recording for
+ * libinput_replay_add_recording(). This works without root and without
+ * /dev/uinput.
+ *
+ * Returns NULL for devices that need a custom create function.
+ */
+static struct litest_device *
+litest_create_recorded(enum litest_device_type which,
+		       const char *name_override,
+		       struct input_id *id_override,
+		       const struct input_absinfo *abs_override,
+		       const int *events_override)
+{
+	struct litest_device *d;
+	struct litest_test_device **dev;
+	struct input_absinfo *abs;
+	int *events;
+
+	dev = litest_find_test_device(which);
+	if ((*dev)->create)
+		return NULL;
+
+	d = zalloc(sizeof(*d));
+	litest_assert(d != NULL);
+
+	abs = merge_absinfo((*dev)->absinfo, abs_override);
+	events = merge_events((*dev)->events, events_override);
+	d->evdev = litest_create_evdev(name_override ? name_override : (*dev)->name,
+				       id_override ? id_override : (*dev)->id,
+				       abs,
+				       events);
+	d->interface = (*dev)->interface;
+	d->recording.time = s2us(1);
+	d->recording.interval = ms2us(10);
+	litest_recording_init_properties(d, (*dev)->features);
+	if ((*dev)->udev_rule)
+		litest_recording_add_udev_rule_properties(d,
+							  (*dev)->udev_rule);
+
+	free(abs);
+	free(events);
+
+	return d;
+}
+
+struct litest_device *
+litest_create_recorded_device(enum litest_device_type which)
+{
+	return litest_create_recorded(which, NULL, NULL, NULL, NULL);
+}
+
+/**
+ * Fill range with the device types of all test devices, for ranged tests
+ * that create their devices themselves from the loop index.
+ */
+void
+litest_device_type_range(struct range *range)
+{
+	struct litest_test_device **dev = devices;
+
+	range->lower = LITEST_NO_DEVICE;
+	range->upper = LITEST_NO_DEVICE;
+
+	for (; *dev; dev++) {
+		range->lower = min((int)(*dev)->type, range->lower);
+		range->upper = max((int)(*dev)->type + 1, range->upper);
+	}
+}
+
+/**
+ * Write the device description and all events sent to the device so far
+ * into a recording at path. The last frame must be complete.
+ */
+void
+litest_recorded_device_write(struct litest_device *d, const char *path)
+{
+	struct record_writer w;
+	struct record_device device;
+	FILE *out;
+	size_t i;
+
+	litest_assert_ptr_null(d->uinput);
+
+	out = fopen(path, "w+");
+	litest_assert_notnull(out);
+
+	record_describe_device(d->evdev, &device);
+	litest_assert_int_eq(record_writer_init(&w, out, &device,
+						d->recording.properties,
+						d->recording.properties_size),
+			     0);
+
+	for (i = 0; i < d->recording.nevents; i++)
+		litest_assert_int_eq(record_writer_add_event(&w,
+							     &d->recording.events[i]),
+				     0);
+	litest_assert(!w.in_frame);
+
+	litest_assert_int_eq(record_writer_finish(&w), 0);
+	record_writer_fini(&w);
+	fclose(out);
+}
+
+static struct litest_device *
+litest_add_fake_device(struct libinput *libinput,
+		       enum litest_device_type which,
+		       const char *name_override,
+		       struct input_id *id_override,
+		       const struct input_absinfo *abs_override,
+		       const int *events_override)
+{
+	struct litest_device *d;
+	char path[] = "/tmp/litest-fake-device-XXXXXX";
+	int fd;
+
+	d = litest_create_recorded(which,
+				   name_override,
+				   id_override,
+				   abs_override,
+				   events_override);
+	if (!d)
+		return NULL;
+
+	/* a recording without frames is just the device description */
+	fd = mkstemp(path);
+	litest_assert_int_ge(fd, 0);
+	close(fd);
+	litest_recorded_device_write(d, path);
+
+	d->libinput = libinput;
+	d->libinput_device = libinput_replay_add_recording(libinput, path);
+	unlink(path);
+	litest_assert(d->libinput_device != NULL);
+	libinput_device_ref(d->libinput_device);
+	d->fake = true;
+
+	litest_init_interface_ranges(d);
+
+	return d;
+}
+
 int
 litest_handle_events(struct litest_device *d)
 {
@@ -1234,17 +1837,50 @@ litest_delete_device(struct litest_device *d)
 		litest_reload_udev_rules();
 	}
 
-	libinput_device_unref(d->libinput_device);
-	libinput_path_remove_device(d->libinput_device);
-	if (d->owns_context)
+	/* fake devices stay in their context until it is destroyed */
+	if (d->libinput_device) {
+		libinput_device_unref(d->libinput_device);
+		if (!d->fake)
+			libinput_path_remove_device(d->libinput_device);
+	}
+	if (d->owns_context) {
+		litest_virtual_time_unregister(d->libinput);
 		libinput_unref(d->libinput);
+	}
 	libevdev_free(d->evdev);
-	libevdev_uinput_destroy(d->uinput);
+	if (d->uinput)
+		libevdev_uinput_destroy(d->uinput);
+	free(d->recording.events);
 	free(d->private);
 	memset(d,0, sizeof(*d));
 	free(d);
 }
 
+static void
+litest_record_event(struct litest_device *d, unsigned int type,
+		    unsigned int code, int value)
+{
+	struct input_event *ev;
+
+	if (d->recording.nevents == d->recording.size) {
+		d->recording.size = max(d->recording.size * 2, 1024);
+		d->recording.events = realloc(d->recording.events,
+					      d->recording.size *
+					      sizeof(*ev));
+		litest_assert_notnull(d->recording.events);
+	}
+
+	ev = &d->recording.events[d->recording.nevents++];
+	ev->time.tv_sec = d->recording.time / s2us(1);
+	ev->time.tv_usec = d->recording.time % s2us(1);
+	ev->type = type;
+	ev->code = code;
+	ev->value = value;
+
+	if (type == EV_SYN && code == SYN_REPORT)
+		d->recording.time += d->recording.interval;
+}
+
 void
 litest_event(struct litest_device *d, unsigned int type,
 	     unsigned int code, int value)
@@ -1254,6 +1890,20 @@ litest_event(struct litest_device *d, unsigned int type,
 	if (d->skip_ev_syn && type == EV_SYN && code == SYN_REPORT)
 		return;
 
+	if (d->fake) {
+		ret = libinput_replay_device_inject_event(d->libinput_device,
+							  type,
+							  code,
+							  value);
+		litest_assert_int_eq(ret, 0);
+		return;
+	}
+
+	if (!d->uinput) {
+		litest_record_event(d, type, code, value);
+		return;
+	}
+
 	ret = libevdev_uinput_write_event(d->uinput, type, code, value);
 	litest_assert_int_eq(ret, 0);
 }
@@ -1485,7 +2135,7 @@ litest_touch_move_to(struct litest_device *d,
 				  y_from + (y_to - y_from)/steps * i);
 		if (sleep_ms) {
 			libinput_dispatch(d->libinput);
-			msleep(sleep_ms);
+			litest_sleep(d, sleep_ms);
 			libinput_dispatch(d->libinput);
 		}
 	}
@@ -1506,7 +2156,7 @@ litest_touch_move_two_touches(struct litest_device *d,
 					y1 + dy / steps * i);
 		if (sleep_ms) {
 			libinput_dispatch(d->libinput);
-			msleep(sleep_ms);
+			litest_sleep(d, sleep_ms);
 		}
 		libinput_dispatch(d->libinput);
 	}
@@ -1531,7 +2181,7 @@ litest_touch_move_three_touches(struct litest_device *d,
 					y2 + dy / steps * i);
 		if (sleep_ms) {
 			libinput_dispatch(d->libinput);
-			msleep(sleep_ms);
+			litest_sleep(d, sleep_ms);
 			libinput_dispatch(d->libinput);
 		}
 	}
@@ -1601,7 +2251,7 @@ litest_hover_move_to(struct litest_device *d,
 				  y_from + (y_to - y_from)/steps * i);
 		if (sleep_ms) {
 			libinput_dispatch(d->libinput);
-			msleep(sleep_ms);
+			litest_sleep(d, sleep_ms);
 			libinput_dispatch(d->libinput);
 		}
 	}
@@ -1624,7 +2274,7 @@ litest_hover_move_two_touches(struct litest_device *d,
 		litest_pop_event_frame(d);
 		if (sleep_ms) {
 			libinput_dispatch(d->libinput);
-			msleep(sleep_ms);
+			litest_sleep(d, sleep_ms);
 			libinput_dispatch(d->libinput);
 		}
 	}
@@ -1742,7 +2392,12 @@ litest_wait_for_event_of_type(struct libinput *li, ...)
 		struct libinput_event *event;
 
 		while ((type = libinput_next_event_type(li)) == LIBINPUT_EVENT_NONE) {
-			poll(&fds, 1, -1);
+			/* timers only fire when the virtual clock moves */
+			if (litest_uses_virtual_time(li) &&
+			    poll(&fds, 1, 0) == 0)
+				libinput_advance_virtual_time(li, ms2us(10));
+			else
+				poll(&fds, 1, -1);
 			libinput_dispatch(li);
 		}
 
@@ -1913,16 +2568,15 @@ litest_assert_empty_queue(struct libinput *li)
 	litest_assert(empty_queue);
 }
 
-static struct libevdev_uinput *
-litest_create_uinput(const char *name,
-		     const struct input_id *id,
-		     const struct input_absinfo *abs_info,
-		     const int *events)
+static struct libevdev *
+litest_create_evdev(const char *name,
+		    const struct input_id *id,
+		    const struct input_absinfo *abs_info,
+		    const int *events)
 {
-	struct libevdev_uinput *uinput;
 	struct libevdev *dev;
 	int type, code;
-	int rc, fd;
+	int rc;
 	const struct input_absinfo *abs;
 	const struct input_absinfo default_abs = {
 		.value = 0,
@@ -1933,12 +2587,14 @@ litest_create_uinput(const char *name,
 		.resolution = 100
 	};
 	char buf[512];
-	const char *devnode;
+	char tag[16];
 
 	dev = libevdev_new();
 	litest_assert(dev != NULL);
 
-	snprintf(buf, sizeof(buf), "litest %s", name);
+	snprintf(buf, sizeof(buf), "litest %s%s",
+		 litest_worker_tag(tag, sizeof(tag), ' '),
+		 name);
 	libevdev_set_name(dev, buf);
 	if (id) {
 		libevdev_set_id_bustype(dev, id->bustype);
@@ -1967,6 +2623,23 @@ litest_create_uinput(const char *name,
 		litest_assert_int_eq(rc, 0);
 	}
 
+	return dev;
+}
+
+static struct libevdev_uinput *
+litest_create_uinput(const char *name,
+		     const struct input_id *id,
+		     const struct input_absinfo *abs_info,
+		     const int *events)
+{
+	struct libevdev_uinput *uinput;
+	struct libevdev *dev;
+	int rc, fd;
+	const struct input_absinfo *abs;
+	const char *devnode;
+
+	dev = litest_create_evdev(name, id, abs_info, events);
+
 	rc = libevdev_uinput_create_from_device(dev,
 					        LIBEVDEV_UINPUT_OPEN_MANAGED,
 						&uinput);
@@ -2315,61 +2988,61 @@ litest_assert_only_typed_events(struct libinput *li,
 void
 litest_timeout_tap(void)
 {
-	msleep(200);
+	litest_timeout(200);
 }
 
 void
 litest_timeout_tapndrag(void)
 {
-	msleep(520);
+	litest_timeout(520);
 }
 
 void
 litest_timeout_softbuttons(void)
 {
-	msleep(300);
+	litest_timeout(300);
 }
 
 void
 litest_timeout_buttonscroll(void)
 {
-	msleep(300);
+	litest_timeout(300);
 }
 
 void
 litest_timeout_finger_switch(void)
 {
-	msleep(120);
+	litest_timeout(120);
 }
 
 void
 litest_timeout_edgescroll(void)
 {
-	msleep(300);
+	litest_timeout(300);
 }
 
 void
 litest_timeout_middlebutton(void)
 {
-	msleep(70);
+	litest_timeout(70);
 }
 
 void
 litest_timeout_dwt_short(void)
 {
-	msleep(220);
+	litest_timeout(220);
 }
 
 void
 litest_timeout_dwt_long(void)
 {
-	msleep(520);
+	litest_timeout(520);
 }
 
 void
 litest_timeout_gesture(void)
 {
-	msleep(120);
+	litest_timeout(120);
 }
 
 void
@@ -2543,6 +3216,8 @@ litest_parse_argv(int argc, char **argv)
 		OPT_FILTER_GROUP,
 		OPT_LIST,
 		OPT_VERBOSE,
+		OPT_FAKE_DEVICES,
+		OPT_JOBS,
 	};
 	static const struct option opts[] = {
 		{ "filter-test", 1, 0, OPT_FILTER_TEST },
@@ -2550,6 +3225,8 @@ litest_parse_argv(int argc, char **argv)
 		{ "filter-group", 1, 0, OPT_FILTER_GROUP },
 		{ "list", 0, 0, OPT_LIST },
 		{ "verbose", 0, 0, OPT_VERBOSE },
+		{ "fake-devices", 0, 0, OPT_FAKE_DEVICES },
+		{ "jobs", 1, 0, OPT_JOBS },
 		{ 0, 0, 0, 0}
 	};
 
@@ -2575,6 +3252,16 @@ litest_parse_argv(int argc, char **argv)
 		case OPT_VERBOSE:
 			verbose = 1;
 			break;
+		case OPT_FAKE_DEVICES:
+			use_fake_devices = true;
+			break;
+		case OPT_JOBS:
+			jobs = atoi(optarg);
+			if (jobs < 1) {
+				fprintf(stderr, "Invalid number of jobs: %s\n", optarg);
+				return LITEST_MODE_ERROR;
+			}
+			break;
 		default:
 			fprintf(stderr, "usage: %s [--list]\n", argv[0]);
 			return LITEST_MODE_ERROR;
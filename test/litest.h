@@ -33,6 +33,7 @@
 #include <libevdev/libevdev.h>
 #include <libevdev/libevdev-uinput.h>
 #include <libinput.h>
+#include <libinput-test.h>
 #include <math.h>
 
 #define litest_assert(cond) \
@@ -181,9 +182,25 @@ struct litest_device {
 	int ntouches_down;
 	bool skip_ev_syn;
 
+	/* in-process device in a replay context, events are injected
+	 * directly instead of written to uinput */
+	bool fake;
+
 	void *private; /* device-specific data */
 
 	char *udev_rule_file;
+
+	/* Only for devices from litest_create_recorded_device(), events
+	 * are stored here instead of written to a uinput device */
+	struct {
+		struct input_event *events;
+		size_t nevents;
+		size_t size;
+		uint64_t time; /* timestamp of the next frame in us */
+		uint64_t interval; /* time between frames in us */
+		char properties[256]; /* KEY=value\0 list */
+		size_t properties_size;
+	} recording;
 };
 
 struct axis_replacement {
@@ -269,6 +286,11 @@ extern void litest_setup_tests(void);
 struct litest_device * litest_create_device(enum litest_device_type which);
 struct litest_device * litest_add_device(struct libinput *libinput,
 					 enum litest_device_type which);
+struct litest_device *
+litest_create_recorded_device(enum litest_device_type which);
+void litest_recorded_device_write(struct litest_device *d,
+				  const char *path);
+void litest_device_type_range(struct range *range);
 struct libevdev_uinput *
 litest_create_uinput_device_from_description(const char *name,
 					     const struct input_id *id,
@@ -424,6 +446,7 @@ struct libevdev_uinput * litest_create_uinput_abs_device(const char *name,
 #define litest_assert_double_ge(a_, b_)\
 	ck_assert_int_ge((int)(a_ * 256), (int)(b_ * 256))
 
+void litest_timeout(unsigned int ms);
 void litest_timeout_tap(void);
 void litest_timeout_tapndrag(void);
 void litest_timeout_softbuttons(void);
@@ -27,7 +27,9 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <libinput.h>
+#include <libinput-shm-ring.h>
 #include <libinput-util.h>
+#include <poll.h>
 #include <unistd.h>
 
 #include "litest.h"
@@ -541,6 +543,102 @@ START_TEST(ratelimit_helpers)
 }
 END_TEST
 
+START_TEST(latency_histogram_helpers)
+{
+	struct latency_histogram h;
+	uint64_t v;
+	unsigned int i, bucket;
+
+	for (v = 0; v < 100000; v++) {
+		bucket = latency_histogram_bucket(v);
+		ck_assert_int_lt(bucket, LATENCY_HISTOGRAM_NBUCKETS);
+		ck_assert_int_le(latency_histogram_bucket_lower_bound(bucket), v);
+		ck_assert_int_gt(latency_histogram_bucket_lower_bound(bucket + 1), v);
+	}
+
+	ck_assert_int_eq(latency_histogram_bucket(0xffffffff),
+			 LATENCY_HISTOGRAM_NBUCKETS - 1);
+	ck_assert_int_eq(latency_histogram_bucket(0xffffffffffffffff),
+			 LATENCY_HISTOGRAM_NBUCKETS - 1);
+
+	memset(&h, 0, sizeof(h));
+	ck_assert_int_eq(latency_histogram_percentile(&h, 50.0), 0);
+
+	for (i = 1; i <= 1000; i++)
+		latency_histogram_add(&h, i);
+
+	ck_assert_int_eq(h.count, 1000);
+	ck_assert_int_eq(h.max, 1000);
+	ck_assert_int_eq(latency_histogram_percentile(&h, 100.0), 1000);
+
+	/* results are within 25% of the real value */
+	v = latency_histogram_percentile(&h, 50.0);
+	ck_assert_int_ge(v, 500);
+	ck_assert_int_le(v, 625);
+	v = latency_histogram_percentile(&h, 90.0);
+	ck_assert_int_ge(v, 900);
+	ck_assert_int_le(v, 1000);
+}
+END_TEST
+
+struct hash_test_entry {
+	struct hash_node node;
+	uint64_t key;
+};
+
+START_TEST(hash_index_helpers)
+{
+	struct hash_index index;
+	struct hash_test_entry entries[1000];
+	struct hash_node *node;
+	struct hash_test_entry *e;
+	unsigned int i, found;
+
+	ck_assert_int_ne(hash_string("event0"), hash_string("event1"));
+	ck_assert_int_ne(hash_uint64(1), hash_uint64(2));
+
+	hash_index_init(&index);
+	ck_assert(hash_index_first(&index, 0) == NULL);
+
+	ck_assert(hash_index_reserve(&index, 100));
+	ck_assert_int_ge(index.nbuckets, 100);
+	ck_assert_int_eq(index.count, 0);
+
+	/* every key twice, the index must hold both */
+	for (i = 0; i < ARRAY_LENGTH(entries); i++) {
+		entries[i].key = i / 2;
+		ck_assert(hash_index_insert(&index,
+					    &entries[i].node,
+					    hash_uint64(entries[i].key)));
+	}
+	ck_assert_int_eq(index.count, ARRAY_LENGTH(entries));
+
+	for (i = 0; i < ARRAY_LENGTH(entries) / 2; i++) {
+		found = 0;
+		for (node = hash_index_first(&index, hash_uint64(i));
+		     node;
+		     node = hash_index_next(node)) {
+			e = container_of(node, e, node);
+			ck_assert_int_eq(e->key, i);
+			found++;
+		}
+		ck_assert_int_eq(found, 2);
+	}
+
+	for (i = 0; i < ARRAY_LENGTH(entries); i += 2)
+		hash_index_remove(&index, &entries[i].node);
+	ck_assert_int_eq(index.count, ARRAY_LENGTH(entries) / 2);
+
+	for (i = 0; i < ARRAY_LENGTH(entries) / 2; i++) {
+		node = hash_index_first(&index, hash_uint64(i));
+		ck_assert(node == &entries[i * 2 + 1].node);
+		ck_assert(hash_index_next(node) == NULL);
+	}
+
+	hash_index_destroy(&index);
+}
+END_TEST
+
 struct parser_test {
 	char *tag;
 	int expected_value;
@@ -774,6 +872,658 @@ START_TEST(fd_no_event_leak)
 }
 END_TEST
 
+START_TEST(virtual_time)
+{
+	struct libinput *li;
+	struct litest_device *dev;
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	uint64_t t1, t2;
+
+	li = litest_create_context();
+
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_advance_virtual_time(li, ms2us(10)),
+			 -EINVAL);
+	litest_restore_log_handler(li);
+
+	ck_assert_int_eq(libinput_enable_virtual_time(li), 0);
+	ck_assert_int_eq(libinput_enable_virtual_time(li), 0);
+
+	dev = litest_add_device(li, LITEST_MOUSE);
+	litest_drain_events(li);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	t1 = libinput_event_pointer_get_time_usec(ptrev);
+	libinput_event_destroy(event);
+
+	ck_assert_int_eq(libinput_advance_virtual_time(li, ms2us(500)), 0);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	t2 = libinput_event_pointer_get_time_usec(ptrev);
+	libinput_event_destroy(event);
+
+	ck_assert_int_eq(t2 - t1, ms2us(500));
+
+	litest_delete_device(dev);
+	libinput_unref(li);
+}
+END_TEST
+
+/* An unlinked temporary file, positioned at the start */
+static int
+handoff_tmpfile(void)
+{
+	char path[] = "/tmp/litest-handoff-XXXXXX";
+	int fd;
+
+	fd = mkstemp(path);
+	ck_assert_int_ge(fd, 0);
+	unlink(path);
+
+	return fd;
+}
+
+START_TEST(handoff_keys)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	struct libinput_event_keyboard *kev;
+	const char *devnode;
+	int fd;
+
+	litest_drain_events(dev->libinput);
+
+	litest_keyboard_key(dev, KEY_A, true);
+	litest_keyboard_key(dev, KEY_B, true);
+	litest_drain_events(dev->libinput);
+
+	fd = handoff_tmpfile();
+	ck_assert_int_eq(libinput_handoff_save(dev->libinput, fd), 0);
+	ck_assert_int_eq(lseek(fd, 0, SEEK_SET), 0);
+
+	/* released while no context reads the device */
+	litest_keyboard_key(dev, KEY_B, false);
+
+	devnode = libevdev_uinput_get_devnode(dev->uinput);
+	li = litest_create_context();
+	ck_assert_int_eq(libinput_handoff_load(li, fd), 0);
+	close(fd);
+
+	device = libinput_path_add_device(li, devnode);
+	ck_assert_notnull(device);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_ADDED);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	kev = litest_is_keyboard_event(event,
+				       KEY_B,
+				       LIBINPUT_KEY_STATE_RELEASED);
+	ck_assert_int_eq(libinput_event_keyboard_get_seat_key_count(kev), 0);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	/* still down, the release is not dropped */
+	litest_keyboard_key(dev, KEY_A, false);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	kev = litest_is_keyboard_event(event,
+				       KEY_A,
+				       LIBINPUT_KEY_STATE_RELEASED);
+	ck_assert_int_eq(libinput_event_keyboard_get_seat_key_count(kev), 0);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	libinput_unref(li);
+	litest_drain_events(dev->libinput);
+}
+END_TEST
+
+START_TEST(handoff_touch)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+	const char *devnode;
+	int fd;
+
+	litest_drain_events(dev->libinput);
+
+	litest_touch_down(dev, 0, 30, 30);
+	litest_touch_down(dev, 1, 70, 70);
+	litest_drain_events(dev->libinput);
+
+	fd = handoff_tmpfile();
+	ck_assert_int_eq(libinput_handoff_save(dev->libinput, fd), 0);
+	ck_assert_int_eq(lseek(fd, 0, SEEK_SET), 0);
+
+	/* lifted while no context reads the device */
+	litest_touch_up(dev, 1);
+
+	devnode = libevdev_uinput_get_devnode(dev->uinput);
+	li = litest_create_context();
+	ck_assert_int_eq(libinput_handoff_load(li, fd), 0);
+	close(fd);
+
+	device = libinput_path_add_device(li, devnode);
+	ck_assert_notnull(device);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_ADDED);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	tev = litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_UP);
+	ck_assert_int_eq(libinput_event_touch_get_seat_slot(tev), 1);
+	libinput_event_destroy(event);
+	event = libinput_get_event(li);
+	litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	/* the carried-over touch keeps its seat slot */
+	litest_touch_down(dev, 1, 50, 50);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_DOWN);
+	ck_assert_int_eq(libinput_event_touch_get_seat_slot(tev), 1);
+	libinput_event_destroy(event);
+	event = libinput_get_event(li);
+	litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	/* and its release is not dropped */
+	litest_touch_up(dev, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_UP);
+	ck_assert_int_eq(libinput_event_touch_get_seat_slot(tev), 0);
+	libinput_event_destroy(event);
+	event = libinput_get_event(li);
+	litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	litest_touch_up(dev, 1);
+	libinput_unref(li);
+	litest_drain_events(dev->libinput);
+}
+END_TEST
+
+static struct libinput *
+handoff_add_device(const char *devnode, int fd)
+{
+	struct libinput *li;
+
+	li = litest_create_context();
+	if (fd >= 0)
+		ck_assert_int_eq(libinput_handoff_load(li, fd), 0);
+	ck_assert_notnull(libinput_path_add_device(li, devnode));
+	litest_drain_events(li);
+
+	return li;
+}
+
+static double
+handoff_next_dx(struct libinput *li)
+{
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	double dx;
+
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	dx = libinput_event_pointer_get_dx(ptrev);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	return dx;
+}
+
+START_TEST(handoff_pointer_accel)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li, *li_handoff, *li_fresh;
+	const char *devnode;
+	double dx, dx_handoff, dx_fresh;
+	int fd, i;
+
+	/* The contexts of litest devices run on a virtual clock, these
+	 * use the event timestamps so their filters agree on the
+	 * velocity */
+	devnode = libevdev_uinput_get_devnode(dev->uinput);
+	li = handoff_add_device(devnode, -1);
+
+	for (i = 0; i < 10; i++) {
+		litest_event(dev, EV_REL, REL_X, 10);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	libinput_dispatch(li);
+	litest_drain_events(li);
+
+	fd = handoff_tmpfile();
+	ck_assert_int_eq(libinput_handoff_save(li, fd), 0);
+	ck_assert_int_eq(lseek(fd, 0, SEEK_SET), 0);
+	li_handoff = handoff_add_device(devnode, fd);
+	close(fd);
+	li_fresh = handoff_add_device(devnode, -1);
+
+	/* the motion history is carried over, the acceleration continues
+	 * where the previous context left off */
+	litest_event(dev, EV_REL, REL_X, 10);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	dx = handoff_next_dx(li);
+	dx_handoff = handoff_next_dx(li_handoff);
+	dx_fresh = handoff_next_dx(li_fresh);
+
+	ck_assert(dx_handoff == dx);
+	ck_assert(dx_fresh != dx);
+
+	libinput_unref(li);
+	libinput_unref(li_handoff);
+	libinput_unref(li_fresh);
+	litest_drain_events(dev->libinput);
+}
+END_TEST
+
+START_TEST(handoff_invalid)
+{
+	struct libinput *li;
+	const char garbage[] = "LIBINPHO but not a handoff";
+	int fd;
+
+	li = litest_create_context();
+
+	fd = handoff_tmpfile();
+	ck_assert_int_eq(write(fd, garbage, sizeof(garbage)),
+			 (int)sizeof(garbage));
+	ck_assert_int_eq(lseek(fd, 0, SEEK_SET), 0);
+	ck_assert_int_eq(libinput_handoff_load(li, fd), -EINVAL);
+	close(fd);
+
+	/* truncated */
+	fd = handoff_tmpfile();
+	ck_assert_int_eq(libinput_handoff_load(li, fd), -EINVAL);
+	close(fd);
+
+	/* a context without devices writes a valid state */
+	fd = handoff_tmpfile();
+	ck_assert_int_eq(libinput_handoff_save(li, fd), 0);
+	ck_assert_int_eq(lseek(fd, 0, SEEK_SET), 0);
+	ck_assert_int_eq(libinput_handoff_load(li, fd), 0);
+
+	/* but not for a different libinput version, stored after the
+	 * magic, format version and device count */
+	ck_assert_int_eq(pwrite(fd, "0.0.0", 6, 16), 6);
+	ck_assert_int_eq(lseek(fd, 0, SEEK_SET), 0);
+	ck_assert_int_eq(libinput_handoff_load(li, fd), -EINVAL);
+	close(fd);
+
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(handoff_device_count)
+{
+	struct libinput *li;
+	char header[64];
+	uint32_t ndevices = 100000;
+	ssize_t len;
+	int fd, pipefd[2];
+
+	li = litest_create_context();
+
+	fd = handoff_tmpfile();
+	ck_assert_int_eq(libinput_handoff_save(li, fd), 0);
+	len = pread(fd, header, sizeof(header), 0);
+	ck_assert_int_gt(len, 0);
+
+	/* more devices than the file has room for, the count is stored
+	 * after the magic and format version */
+	ck_assert_int_eq(pwrite(fd, &ndevices, sizeof(ndevices), 12),
+			 (int)sizeof(ndevices));
+	ck_assert_int_eq(lseek(fd, 0, SEEK_SET), 0);
+	ck_assert_int_eq(libinput_handoff_load(li, fd), -EINVAL);
+	close(fd);
+
+	/* a pipe has no size, the load fails when the records run out */
+	memcpy(&header[12], &ndevices, sizeof(ndevices));
+	ck_assert_int_eq(pipe(pipefd), 0);
+	ck_assert_int_eq(write(pipefd[1], header, len), len);
+	close(pipefd[1]);
+	ck_assert_int_eq(libinput_handoff_load(li, pipefd[0]), -EINVAL);
+	close(pipefd[0]);
+
+	libinput_unref(li);
+}
+END_TEST
+
+static bool
+event_queue_is_readable(struct libinput_event_queue *queue)
+{
+	struct pollfd fds = {
+		.fd = libinput_event_queue_get_fd(queue),
+		.events = POLLIN,
+	};
+
+	return poll(&fds, 1, 0) == 1;
+}
+
+static int
+event_queue_drain(struct libinput_event_queue *queue)
+{
+	struct libinput_event *event;
+	int count = 0;
+
+	while ((event = libinput_event_queue_get_event(queue))) {
+		libinput_event_destroy(event);
+		count++;
+	}
+
+	return count;
+}
+
+START_TEST(event_queue_seat)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_seat *seat;
+	struct libinput_event_queue *queue;
+	struct libinput_event *event;
+
+	litest_drain_events(li);
+
+	queue = libinput_event_queue_create(li);
+	ck_assert_notnull(queue);
+	ck_assert_int_ge(libinput_event_queue_get_fd(queue), 0);
+	ck_assert(!event_queue_is_readable(queue));
+
+	seat = libinput_device_get_seat(dev->libinput_device);
+	libinput_seat_set_event_queue(seat, queue);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	ck_assert_int_eq(libinput_next_event_type(li), LIBINPUT_EVENT_NONE);
+	ck_assert(event_queue_is_readable(queue));
+	ck_assert_int_eq(libinput_event_queue_next_event_type(queue),
+			 LIBINPUT_EVENT_POINTER_MOTION);
+	event = libinput_event_queue_get_event(queue);
+	ck_assert_ptr_eq(libinput_event_get_device(event),
+			 dev->libinput_device);
+	libinput_event_destroy(event);
+
+	event_queue_drain(queue);
+	ck_assert(!event_queue_is_readable(queue));
+
+	/* the seat keeps the queue alive */
+	ck_assert_notnull(libinput_event_queue_unref(queue));
+	libinput_seat_set_event_queue(seat, NULL);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+	ck_assert_int_eq(libinput_next_event_type(li),
+			 LIBINPUT_EVENT_POINTER_MOTION);
+	litest_drain_events(li);
+}
+END_TEST
+
+START_TEST(event_queue_group)
+{
+	struct litest_device *dev = litest_current_device();
+	struct litest_device *keyboard;
+	struct libinput *li = dev->libinput;
+	struct libinput_device_group *group;
+	struct libinput_event_queue *seat_queue, *group_queue;
+
+	keyboard = litest_add_device(li, LITEST_KEYBOARD);
+	litest_drain_events(li);
+
+	seat_queue = libinput_event_queue_create(li);
+	group_queue = libinput_event_queue_create(li);
+
+	group = libinput_device_get_device_group(dev->libinput_device);
+	ck_assert_ptr_ne(group,
+			 libinput_device_get_device_group(keyboard->libinput_device));
+
+	libinput_seat_set_event_queue(libinput_device_get_seat(dev->libinput_device),
+				      seat_queue);
+	libinput_device_group_set_event_queue(group, group_queue);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_keyboard_key(keyboard, KEY_A, true);
+	litest_keyboard_key(keyboard, KEY_A, false);
+	libinput_dispatch(li);
+
+	ck_assert_int_eq(libinput_next_event_type(li), LIBINPUT_EVENT_NONE);
+	ck_assert_int_eq(libinput_event_queue_next_event_type(group_queue),
+			 LIBINPUT_EVENT_POINTER_MOTION);
+	ck_assert_int_eq(libinput_event_queue_next_event_type(seat_queue),
+			 LIBINPUT_EVENT_KEYBOARD_KEY);
+	ck_assert_int_eq(event_queue_drain(seat_queue), 2);
+	event_queue_drain(group_queue);
+
+	litest_delete_device(keyboard);
+	ck_assert_int_eq(libinput_event_queue_next_event_type(seat_queue),
+			 LIBINPUT_EVENT_DEVICE_REMOVED);
+	event_queue_drain(seat_queue);
+
+	libinput_event_queue_unref(seat_queue);
+	libinput_event_queue_unref(group_queue);
+}
+END_TEST
+
+START_TEST(event_queue_context_destroyed)
+{
+	struct libinput *li;
+	struct litest_device *dev;
+	struct libinput_event_queue *queue;
+
+	li = litest_create_context();
+	dev = litest_add_device(li, LITEST_MOUSE);
+	queue = libinput_event_queue_create(li);
+	libinput_seat_set_event_queue(libinput_device_get_seat(dev->libinput_device),
+				      queue);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	litest_delete_device(dev);
+	libinput_unref(li);
+
+	/* queued events are gone with the context, the queue is not */
+	ck_assert_int_eq(libinput_event_queue_get_fd(queue), -1);
+	ck_assert(libinput_event_queue_get_event(queue) == NULL);
+	ck_assert_int_eq(libinput_event_queue_next_event_type(queue),
+			 LIBINPUT_EVENT_NONE);
+	ck_assert(libinput_event_queue_unref(queue) == NULL);
+}
+END_TEST
+
+static int
+shm_ring_publish_all(struct libinput *li, struct libinput_shm_ring *ring)
+{
+	struct libinput_event *event;
+	int count = 0;
+
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li))) {
+		ck_assert_int_eq(libinput_shm_ring_publish(ring, event), 0);
+		libinput_event_destroy(event);
+		count++;
+	}
+
+	return count;
+}
+
+START_TEST(shm_ring_publish)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_shm_ring *ring;
+	struct libinput_shm_reader reader;
+	const struct libinput_shm_record *record;
+	uint32_t device_id;
+	int i;
+
+	litest_drain_events(li);
+
+	ring = libinput_shm_ring_create(li, 5);
+	ck_assert_notnull(ring);
+	ck_assert_int_eq(libinput_shm_reader_init(&reader,
+						  libinput_shm_ring_get_fd(ring)),
+			 0);
+	ck_assert_int_eq(reader.capacity, 8);
+	ck_assert(libinput_shm_reader_peek(&reader) == NULL);
+
+	device_id = libinput_device_get_export_id(dev->libinput_device);
+	ck_assert_int_ne(device_id, 0);
+
+	for (i = 0; i < 3; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_REL, REL_Y, -1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	litest_button_click(dev, BTN_LEFT, true);
+	ck_assert_int_eq(shm_ring_publish_all(li, ring), 4);
+
+	for (i = 0; i < 3; i++) {
+		record = libinput_shm_reader_peek(&reader);
+		ck_assert_notnull(record);
+		ck_assert_int_eq(record->type, LIBINPUT_EVENT_POINTER_MOTION);
+		ck_assert_int_eq(record->device_id, device_id);
+		ck_assert(record->u.motion.dx > 0.0);
+		ck_assert(record->u.motion.dy < 0.0);
+		ck_assert(libinput_shm_reader_consume(&reader, record));
+	}
+
+	record = libinput_shm_reader_peek(&reader);
+	ck_assert_notnull(record);
+	ck_assert_int_eq(record->type, LIBINPUT_EVENT_POINTER_BUTTON);
+	ck_assert_int_eq(record->u.button.button, BTN_LEFT);
+	ck_assert_int_eq(record->u.button.state,
+			 LIBINPUT_BUTTON_STATE_PRESSED);
+	ck_assert_int_eq(record->u.button.seat_button_count, 1);
+	ck_assert(libinput_shm_reader_consume(&reader, record));
+
+	ck_assert(libinput_shm_reader_peek(&reader) == NULL);
+	ck_assert_int_eq(reader.lost, 0);
+
+	litest_button_click(dev, BTN_LEFT, false);
+	libinput_dispatch(li);
+	litest_drain_events(li);
+
+	libinput_shm_reader_fini(&reader);
+	libinput_shm_ring_destroy(ring);
+}
+END_TEST
+
+START_TEST(shm_ring_overflow)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_shm_ring *ring;
+	struct libinput_shm_reader reader;
+	const struct libinput_shm_record *record;
+	int i;
+
+	litest_drain_events(li);
+
+	ring = libinput_shm_ring_create(li, 4);
+	ck_assert_int_eq(libinput_shm_reader_init(&reader,
+						  libinput_shm_ring_get_fd(ring)),
+			 0);
+
+	for (i = 0; i < 5; i++) {
+		litest_keyboard_key(dev, KEY_A, true);
+		litest_keyboard_key(dev, KEY_A, false);
+	}
+	ck_assert_int_eq(shm_ring_publish_all(li, ring), 10);
+
+	/* the six oldest records were overwritten */
+	record = libinput_shm_reader_peek(&reader);
+	ck_assert_notnull(record);
+	ck_assert_int_eq(reader.lost, 6);
+	ck_assert_int_eq(record->type, LIBINPUT_EVENT_KEYBOARD_KEY);
+	ck_assert_int_eq(record->u.keyboard.key, KEY_A);
+	ck_assert_int_eq(record->u.keyboard.state,
+			 LIBINPUT_KEY_STATE_PRESSED);
+
+	/* and this one is overwritten while we read it */
+	for (i = 0; i < 2; i++) {
+		litest_keyboard_key(dev, KEY_A, true);
+		litest_keyboard_key(dev, KEY_A, false);
+	}
+	ck_assert_int_eq(shm_ring_publish_all(li, ring), 4);
+	ck_assert(!libinput_shm_reader_consume(&reader, record));
+
+	i = 0;
+	while ((record = libinput_shm_reader_peek(&reader))) {
+		ck_assert(libinput_shm_reader_consume(&reader, record));
+		i++;
+	}
+	ck_assert_int_eq(i, 4);
+	ck_assert_int_eq(reader.lost, 10);
+
+	libinput_shm_reader_fini(&reader);
+	libinput_shm_ring_destroy(ring);
+}
+END_TEST
+
+START_TEST(shm_ring_read_only)
+{
+	struct libinput *li;
+	struct libinput_shm_ring *ring;
+	int fd;
+	void *map;
+
+	li = litest_create_context();
+
+	litest_disable_log_handler(li);
+	ck_assert(libinput_shm_ring_create(li, 0) == NULL);
+	ck_assert(libinput_shm_ring_create(li, (1 << 20) + 1) == NULL);
+	litest_restore_log_handler(li);
+
+	ring = libinput_shm_ring_create(li, 16);
+	ck_assert_notnull(ring);
+	fd = libinput_shm_ring_get_fd(ring);
+
+	map = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	ck_assert(map == MAP_FAILED);
+	ck_assert_int_lt(ftruncate(fd, 0), 0);
+
+	libinput_shm_ring_destroy(ring);
+	libinput_unref(li);
+}
+END_TEST
+
 void
 litest_setup_tests(void)
 {
@@ -790,11 +1540,29 @@ litest_setup_tests(void)
 
 	litest_add_no_device("misc:matrix", matrix_helpers);
 	litest_add_no_device("misc:ratelimit", ratelimit_helpers);
+	litest_add_no_device("misc:latency", latency_histogram_helpers);
+	litest_add_no_device("misc:hash", hash_index_helpers);
 	litest_add_no_device("misc:parser", dpi_parser);
 	litest_add_no_device("misc:parser", wheel_click_parser);
 	litest_add_no_device("misc:parser", trackpoint_accel_parser);
 	litest_add_no_device("misc:parser", dimension_prop_parser);
 	litest_add_no_device("misc:time", time_conversion);
+	litest_add_no_device("misc:time", virtual_time);
 
 	litest_add_no_device("misc:fd", fd_no_event_leak);
+
+
+	litest_add_for_device("misc:handoff", handoff_keys, LITEST_KEYBOARD);
+	litest_add_for_device("misc:handoff", handoff_touch, LITEST_GENERIC_MULTITOUCH_SCREEN);
+	litest_add_for_device("misc:handoff", handoff_pointer_accel, LITEST_MOUSE);
+	litest_add_no_device("misc:handoff", handoff_invalid);
+	litest_add_no_device("misc:handoff", handoff_device_count);
+
+	litest_add_for_device("misc:event-queue", event_queue_seat, LITEST_MOUSE);
+	litest_add_for_device("misc:event-queue", event_queue_group, LITEST_MOUSE);
+	litest_add_no_device("misc:event-queue", event_queue_context_destroyed);
+
+	litest_add_for_device("misc:shm-ring", shm_ring_publish, LITEST_MOUSE);
+	litest_add_for_device("misc:shm-ring", shm_ring_overflow, LITEST_KEYBOARD);
+	litest_add_no_device("misc:shm-ring", shm_ring_read_only);
 }
@@ -27,6 +27,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <libinput.h>
+#include <poll.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "litest.h"
@@ -345,6 +347,158 @@ START_TEST(path_add_invalid_path)
 }
 END_TEST
 
+struct async_add {
+	struct libinput_device *device;
+	char *path;
+	int count;
+};
+
+static void
+path_device_added(struct libinput *li,
+		  const char *path,
+		  struct libinput_device *device,
+		  void *data)
+{
+	struct async_add *add = data;
+
+	add->count++;
+	add->device = device;
+	free(add->path);
+	add->path = strdup(path);
+}
+
+static void
+wait_for_async_add(struct libinput *li, struct async_add *add)
+{
+	struct pollfd fds;
+	int i;
+
+	fds.fd = libinput_get_fd(li);
+	fds.events = POLLIN;
+	fds.revents = 0;
+
+	for (i = 0; i < 50 && add->count == 0; i++) {
+		poll(&fds, 1, 100);
+		libinput_dispatch(li);
+	}
+}
+
+START_TEST(path_add_device_async)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li;
+	struct libinput_event *event;
+	struct async_add add = {0};
+	const char *devnode;
+
+	devnode = libevdev_uinput_get_devnode(dev->uinput);
+
+	li = libinput_path_create_context(&simple_interface, NULL);
+	ck_assert(li != NULL);
+
+	ck_assert_int_eq(libinput_path_add_device_async(li,
+							devnode,
+							path_device_added,
+							&add),
+			 0);
+	/* nothing happens until dispatch */
+	ck_assert_int_eq(add.count, 0);
+	ck_assert(libinput_get_event(li) == NULL);
+
+	wait_for_async_add(li, &add);
+	ck_assert_int_eq(add.count, 1);
+	ck_assert(add.device != NULL);
+	ck_assert_str_eq(add.path, devnode);
+
+	event = libinput_get_event(li);
+	ck_assert_notnull(event);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_ADDED);
+	ck_assert(libinput_event_get_device(event) == add.device);
+	libinput_event_destroy(event);
+
+	free(add.path);
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(path_add_device_async_new_device)
+{
+	struct libinput *li;
+	struct libevdev_uinput *uinput;
+	struct async_add add = {0};
+
+	li = libinput_path_create_context(&simple_interface, NULL);
+	ck_assert(li != NULL);
+
+	/* udev is usually still busy with the device here */
+	uinput = litest_create_uinput_device("test device", NULL,
+					     EV_KEY, BTN_LEFT,
+					     EV_KEY, BTN_RIGHT,
+					     EV_REL, REL_X,
+					     EV_REL, REL_Y,
+					     -1);
+	ck_assert_int_eq(libinput_path_add_device_async(li,
+							libevdev_uinput_get_devnode(uinput),
+							path_device_added,
+							&add),
+			 0);
+
+	wait_for_async_add(li, &add);
+	ck_assert_int_eq(add.count, 1);
+	ck_assert(add.device != NULL);
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_DEVICE_ADDED);
+
+	free(add.path);
+	libinput_unref(li);
+	libevdev_uinput_destroy(uinput);
+}
+END_TEST
+
+START_TEST(path_add_device_async_invalid_path)
+{
+	struct libinput *li;
+
+	li = litest_create_context();
+
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_path_add_device_async(li, "/tmp/", NULL, NULL),
+			 -ENODEV);
+	ck_assert_int_eq(libinput_path_add_device_async(li,
+							"/tmp/litest-does-not-exist",
+							NULL,
+							NULL),
+			 -ENOENT);
+	litest_restore_log_handler(li);
+
+	libinput_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(path_add_device_async_destroy)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li;
+	struct async_add add = {0};
+
+	li = libinput_path_create_context(&simple_interface, NULL);
+	ck_assert(li != NULL);
+
+	ck_assert_int_eq(libinput_path_add_device_async(li,
+							libevdev_uinput_get_devnode(dev->uinput),
+							path_device_added,
+							&add),
+			 0);
+
+	/* pending devices are dropped silently */
+	libinput_unref(li);
+	ck_assert_int_eq(add.count, 0);
+}
+END_TEST
+
 START_TEST(path_device_sysname)
 {
 	struct litest_device *dev = litest_current_device();
@@ -896,6 +1050,10 @@ litest_setup_tests(void)
 	litest_add("path:device events", path_device_sysname, LITEST_ANY, LITEST_ANY);
 	litest_add_for_device("path:device events", path_add_device, LITEST_SYNAPTICS_CLICKPAD);
 	litest_add_no_device("path:device events", path_add_invalid_path);
+	litest_add_for_device("path:device events", path_add_device_async, LITEST_SYNAPTICS_CLICKPAD);
+	litest_add_no_device("path:device events", path_add_device_async_new_device);
+	litest_add_no_device("path:device events", path_add_device_async_invalid_path);
+	litest_add_for_device("path:device events", path_add_device_async_destroy, LITEST_SYNAPTICS_CLICKPAD);
 	litest_add_for_device("path:device events", path_remove_device, LITEST_SYNAPTICS_CLICKPAD);
 	litest_add_for_device("path:device events", path_double_remove_device, LITEST_SYNAPTICS_CLICKPAD);
 	litest_add_no_device("path:seat", path_seat_recycle);
@@ -1491,8 +1491,8 @@ START_TEST(middlebutton_default_touchpad)
 	int available;
 	const char *name = libinput_device_get_name(dev->libinput_device);
 
-	if (streq(name, "litest AlpsPS/2 ALPS GlidePoint") ||
-	    streq(name, "litest AlpsPS/2 ALPS DualPoint TouchPad"))
+	if (strstr(name, "AlpsPS/2 ALPS GlidePoint") ||
+	    strstr(name, "AlpsPS/2 ALPS DualPoint TouchPad"))
 	    return;
 
 	available = libinput_device_config_middle_emulation_is_available(device);
@@ -1579,6 +1579,85 @@ START_TEST(pointer_time_usec)
 }
 END_TEST
 
+START_TEST(pointer_predict_motion)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput *li = dev->libinput;
+	struct libinput_event_pointer *ptrev;
+	struct libinput_event *event;
+	uint64_t time = 0;
+	double dx, dy;
+	int i, rc;
+
+	litest_drain_events(li);
+
+	rc = libinput_device_predict_pointer(device, 0, &dx, &dy);
+	ck_assert_int_ne(rc, 0);
+	ck_assert_double_eq(dx, 0.0);
+	ck_assert_double_eq(dy, 0.0);
+
+	for (i = 0; i < 5; i++) {
+		litest_event(dev, EV_REL, REL_X, 10);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+		litest_timeout(5);
+	}
+
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li))) {
+		ptrev = litest_is_motion_event(event);
+		time = libinput_event_pointer_get_time_usec(ptrev);
+		libinput_event_destroy(event);
+	}
+
+	rc = libinput_device_predict_pointer(device,
+					     time + ms2us(8),
+					     &dx,
+					     &dy);
+	ck_assert_int_eq(rc, 0);
+	ck_assert_double_gt(dx, 0.0);
+	ck_assert_double_eq(dy, 0.0);
+
+	/* too far in the future, the pointer has stopped */
+	rc = libinput_device_predict_pointer(device,
+					     time + ms2us(500),
+					     &dx,
+					     &dy);
+	ck_assert_int_ne(rc, 0);
+	ck_assert_double_eq(dx, 0.0);
+	ck_assert_double_eq(dy, 0.0);
+
+	/* direction change starts a new motion */
+	litest_event(dev, EV_REL, REL_X, -10);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_drain_events(li);
+
+	rc = libinput_device_predict_pointer(device,
+					     time + ms2us(8),
+					     &dx,
+					     &dy);
+	ck_assert_int_ne(rc, 0);
+	ck_assert_double_eq(dx, 0.0);
+	ck_assert_double_eq(dy, 0.0);
+}
+END_TEST
+
+START_TEST(pointer_predict_no_pointer)
+{
+	struct litest_device *dev = litest_current_device();
+	double dx = 1.0, dy = 1.0;
+	int rc;
+
+	rc = libinput_device_predict_pointer(dev->libinput_device,
+					     0,
+					     &dx,
+					     &dy);
+	ck_assert_int_ne(rc, 0);
+	ck_assert_double_eq(dx, 0.0);
+	ck_assert_double_eq(dy, 0.0);
+}
+END_TEST
+
 void
 litest_setup_tests(void)
 {
@@ -1632,4 +1711,7 @@ litest_setup_tests(void)
 	litest_add_ranged("pointer:state", pointer_absolute_initial_state, LITEST_ABSOLUTE, LITEST_ANY, &axis_range);
 
 	litest_add("pointer:time", pointer_time_usec, LITEST_RELATIVE, LITEST_ANY);
+
+	litest_add("pointer:predict", pointer_predict_motion, LITEST_RELATIVE, LITEST_ANY);
+	litest_add_for_device("pointer:predict", pointer_predict_no_pointer, LITEST_KEYBOARD);
 }
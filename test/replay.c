@@ -0,0 +1,667 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <config.h>
+
+#include <check.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libinput.h>
+#include <poll.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "record-writer.h"
+#include "libinput-util.h"
+#include "litest.h"
+
+#define MOUSE_START_TIME s2us(1000)
+
+struct recorded_frame {
+	unsigned int ms; /* relative to MOUSE_START_TIME */
+	struct input_event events[4];
+};
+
+static const struct recorded_frame mouse_frames[] = {
+	{ 0, {
+		{ .type = EV_REL, .code = REL_X, .value = 1 },
+		{ .type = EV_REL, .code = REL_Y, .value = 1 },
+		{ .type = EV_SYN, .code = SYN_REPORT, .value = 0 },
+	} },
+	{ 10, {
+		{ .type = EV_KEY, .code = BTN_LEFT, .value = 1 },
+		{ .type = EV_SYN, .code = SYN_REPORT, .value = 0 },
+	} },
+	{ 20, {
+		{ .type = EV_KEY, .code = BTN_LEFT, .value = 0 },
+		{ .type = EV_SYN, .code = SYN_REPORT, .value = 0 },
+	} },
+};
+
+static const char mouse_properties[] = "ID_INPUT=1\0ID_INPUT_MOUSE=1";
+
+static char *
+write_recording(const struct recorded_frame *recorded, size_t nrecorded)
+{
+	struct record_writer w;
+	struct record_device device = {
+		.bustype = BUS_USB,
+		.vendor = 0x1234,
+		.product = 0x5678,
+		.types = (1U << EV_SYN) | (1U << EV_KEY) | (1U << EV_REL),
+	};
+	char *path;
+	FILE *out;
+	unsigned int i, j;
+	int fd;
+
+	path = strdup("/tmp/libinput-test-replay-XXXXXX");
+	fd = mkstemp(path);
+	litest_assert_int_ge(fd, 0);
+	out = fdopen(fd, "w+");
+	litest_assert_notnull(out);
+
+	snprintf(device.name, sizeof(device.name), "replay test mouse");
+	record_set_bit(device.codes[EV_SYN], SYN_REPORT);
+	record_set_bit(device.codes[EV_KEY], BTN_LEFT);
+	record_set_bit(device.codes[EV_KEY], BTN_RIGHT);
+	record_set_bit(device.codes[EV_KEY], BTN_MIDDLE);
+	record_set_bit(device.codes[EV_REL], REL_X);
+	record_set_bit(device.codes[EV_REL], REL_Y);
+
+	litest_assert_int_eq(record_writer_init(&w, out, &device,
+						mouse_properties,
+						sizeof(mouse_properties)),
+			     0);
+
+	for (i = 0; i < nrecorded; i++) {
+		const struct recorded_frame *f = &recorded[i];
+		uint64_t time = MOUSE_START_TIME + ms2us(f->ms);
+
+		for (j = 0; j < ARRAY_LENGTH(f->events); j++) {
+			struct input_event ev = f->events[j];
+
+			ev.time.tv_sec = time / s2us(1);
+			ev.time.tv_usec = time % s2us(1);
+			litest_assert_int_eq(record_writer_add_event(&w, &ev),
+					     0);
+
+			if (ev.type == EV_SYN)
+				break;
+		}
+	}
+
+	litest_assert_int_eq(record_writer_finish(&w), 0);
+	record_writer_fini(&w);
+	fclose(out);
+
+	return path;
+}
+
+static char *
+write_mouse_recording(void)
+{
+	return write_recording(mouse_frames, ARRAY_LENGTH(mouse_frames));
+}
+
+static uint64_t
+now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return s2us(ts.tv_sec) + ns2us(ts.tv_nsec);
+}
+
+static void
+replay_until_finished(struct libinput *li)
+{
+	int count = 0;
+
+	while (!libinput_replay_is_finished(li)) {
+		libinput_dispatch(li);
+		litest_assert_int_lt(++count, 100);
+	}
+}
+
+START_TEST(replay_create_invalid)
+{
+	struct libinput *li;
+
+	li = libinput_replay_create_context(NULL, NULL, 0);
+	ck_assert(li == NULL);
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_RECORDED + 1);
+	ck_assert(li == NULL);
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	ck_assert_notnull(li);
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(replay_add_invalid_recording)
+{
+	struct libinput *li;
+	struct libinput_device *device;
+	char path[] = "/tmp/libinput-test-replay-XXXXXX";
+	const char garbage[256] = "not a recording";
+	int fd;
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	litest_disable_log_handler(li);
+
+	device = libinput_replay_add_recording(li, "/tmp/does-not-exist");
+	ck_assert(device == NULL);
+
+	fd = mkstemp(path);
+	ck_assert_int_ge(fd, 0);
+	ck_assert_int_eq(write(fd, garbage, sizeof(garbage)),
+			 (int)sizeof(garbage));
+	close(fd);
+
+	device = libinput_replay_add_recording(li, path);
+	ck_assert(device == NULL);
+	unlink(path);
+
+	litest_restore_log_handler(li);
+
+	libinput_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(replay_invalid_event_code)
+{
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	char *path;
+	const struct recorded_frame out_of_range[] = {
+		{ 0, {
+			{ .type = EV_KEY, .code = KEY_MAX + 1, .value = 1 },
+			{ .type = EV_SYN, .code = SYN_REPORT, .value = 0 },
+		} },
+	};
+	const struct recorded_frame not_on_device[] = {
+		{ 0, {
+			{ .type = EV_KEY, .code = KEY_A, .value = 1 },
+			{ .type = EV_SYN, .code = SYN_REPORT, .value = 0 },
+		} },
+		{ 10, {
+			{ .type = EV_KEY, .code = BTN_LEFT, .value = 1 },
+			{ .type = EV_SYN, .code = SYN_REPORT, .value = 0 },
+		} },
+	};
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	ck_assert_notnull(li);
+
+	/* a code beyond the type's maximum rejects the recording */
+	path = write_recording(out_of_range, ARRAY_LENGTH(out_of_range));
+	litest_disable_log_handler(li);
+	device = libinput_replay_add_recording(li, path);
+	litest_restore_log_handler(li);
+	ck_assert(device == NULL);
+	unlink(path);
+	free(path);
+
+	/* a code the device doesn't have is discarded */
+	path = write_recording(not_on_device, ARRAY_LENGTH(not_on_device));
+	device = libinput_replay_add_recording(li, path);
+	ck_assert_notnull(device);
+	unlink(path);
+	free(path);
+
+	replay_until_finished(li);
+
+	event = libinput_get_event(li);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_ADDED);
+	libinput_event_destroy(event);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(libinput_replay_device_inject_event(device,
+							     EV_KEY,
+							     KEY_MAX + 1,
+							     0),
+			 -EINVAL);
+	ck_assert_int_eq(libinput_replay_device_inject_event(device,
+							     EV_MAX + 1,
+							     0,
+							     0),
+			 -EINVAL);
+	ck_assert_int_eq(libinput_replay_device_inject_event(device,
+							     EV_KEY,
+							     KEY_A,
+							     0),
+			 0);
+	ck_assert_int_eq(libinput_replay_device_inject_event(device,
+							     EV_SYN,
+							     SYN_REPORT,
+							     0),
+			 0);
+	litest_assert_empty_queue(li);
+
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(replay_add_recording_mismatching_backend)
+{
+	struct libinput *li;
+	struct libinput_device *device;
+
+	li = litest_create_context();
+
+	litest_disable_log_handler(li);
+	device = libinput_replay_add_recording(li, "/tmp/does-not-exist");
+	ck_assert(device == NULL);
+	ck_assert(!libinput_replay_is_finished(li));
+	litest_restore_log_handler(li);
+
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(replay_mouse)
+{
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	char *path;
+
+	path = write_mouse_recording();
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	ck_assert_notnull(li);
+
+	device = libinput_replay_add_recording(li, path);
+	ck_assert_notnull(device);
+	ck_assert_str_eq(libinput_device_get_name(device),
+			 "replay test mouse");
+	ck_assert_str_eq(libinput_device_get_sysname(device), "replay0");
+	ck_assert(libinput_device_get_udev_device(device) == NULL);
+	ck_assert(libinput_device_has_capability(device,
+						 LIBINPUT_DEVICE_CAP_POINTER));
+
+	/* the replay drives the clock */
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_advance_virtual_time(li, ms2us(10)),
+			 -EINVAL);
+	litest_restore_log_handler(li);
+
+	replay_until_finished(li);
+
+	event = libinput_get_event(li);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_ADDED);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	ck_assert_int_eq(libinput_event_pointer_get_time_usec(ptrev),
+			 MOUSE_START_TIME);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_button_event(event,
+				       BTN_LEFT,
+				       LIBINPUT_BUTTON_STATE_PRESSED);
+	ck_assert_int_eq(libinput_event_pointer_get_time_usec(ptrev),
+			 MOUSE_START_TIME + ms2us(10));
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_button_event(event,
+				       BTN_LEFT,
+				       LIBINPUT_BUTTON_STATE_RELEASED);
+	ck_assert_int_eq(libinput_event_pointer_get_time_usec(ptrev),
+			 MOUSE_START_TIME + ms2us(20));
+	libinput_event_destroy(event);
+
+	litest_assert_empty_queue(li);
+
+	libinput_unref(li);
+	unlink(path);
+	free(path);
+}
+END_TEST
+
+START_TEST(replay_mouse_recorded_pace)
+{
+	struct libinput *li;
+	struct libinput_device *device;
+	char *path;
+	uint64_t start, end;
+
+	path = write_mouse_recording();
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_RECORDED);
+	device = libinput_replay_add_recording(li, path);
+	ck_assert_notnull(device);
+
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_advance_virtual_time(li, ms2us(10)),
+			 -EINVAL);
+	litest_restore_log_handler(li);
+
+	start = now_usec();
+	while (!libinput_replay_is_finished(li)) {
+		struct pollfd fds = { libinput_get_fd(li), POLLIN, 0 };
+
+		ck_assert_int_ge(poll(&fds, 1, 1000), 0);
+		libinput_dispatch(li);
+	}
+	end = now_usec();
+
+	/* the recording spans 20ms */
+	ck_assert_int_ge(end - start, ms2us(20));
+
+	litest_wait_for_event_of_type(li, LIBINPUT_EVENT_POINTER_BUTTON, -1);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_RELEASED);
+
+	libinput_unref(li);
+	unlink(path);
+	free(path);
+}
+END_TEST
+
+START_TEST(replay_suspend_resume)
+{
+	struct libinput *li;
+	struct libinput_device *device;
+	char *path;
+
+	path = write_mouse_recording();
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	device = libinput_replay_add_recording(li, path);
+	ck_assert_notnull(device);
+
+	/* nothing replayed before the first dispatch */
+	libinput_suspend(li);
+	litest_wait_for_event_of_type(li, LIBINPUT_EVENT_DEVICE_REMOVED, -1);
+	litest_drain_events(li);
+	ck_assert(!libinput_replay_is_finished(li));
+
+	ck_assert_int_eq(libinput_resume(li), 0);
+	litest_wait_for_event_of_type(li, LIBINPUT_EVENT_DEVICE_ADDED, -1);
+	libinput_event_destroy(libinput_get_event(li));
+
+	replay_until_finished(li);
+	litest_wait_for_event_of_type(li, LIBINPUT_EVENT_POINTER_BUTTON, -1);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_RELEASED);
+
+	libinput_unref(li);
+	unlink(path);
+	free(path);
+}
+END_TEST
+
+START_TEST(replay_step)
+{
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	char *path;
+	int nframes = 0;
+
+	path = write_mouse_recording();
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	ck_assert_notnull(li);
+
+	device = libinput_replay_add_recording(li, path);
+	ck_assert_notnull(device);
+
+	event = libinput_get_event(li);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_ADDED);
+	libinput_event_destroy(event);
+
+	while (libinput_replay_step(li) == 1) {
+		nframes++;
+		event = libinput_get_event(li);
+		ck_assert_notnull(event);
+		libinput_event_destroy(event);
+		litest_assert_empty_queue(li);
+	}
+
+	ck_assert_int_eq(nframes, 3);
+	ck_assert(libinput_replay_is_finished(li));
+	ck_assert_int_eq(libinput_replay_step(li), 0);
+
+	libinput_unref(li);
+	unlink(path);
+	free(path);
+}
+END_TEST
+
+START_TEST(replay_litest_recorded_device)
+{
+	struct litest_device *dev;
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	char path[] = "/tmp/litest-replay-XXXXXX";
+	int fd;
+
+	fd = mkstemp(path);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+
+	dev = litest_create_recorded_device(LITEST_MOUSE);
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_REL, REL_Y, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_button_click(dev, BTN_LEFT, true);
+	litest_recorded_device_write(dev, path);
+	litest_delete_device(dev);
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	ck_assert_notnull(li);
+
+	device = libinput_replay_add_recording(li, path);
+	ck_assert_notnull(device);
+	ck_assert(libinput_device_has_capability(device,
+						 LIBINPUT_DEVICE_CAP_POINTER));
+
+	replay_until_finished(li);
+
+	event = libinput_get_event(li);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_ADDED);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	litest_is_motion_event(event);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	litest_is_button_event(event,
+			       BTN_LEFT,
+			       LIBINPUT_BUTTON_STATE_PRESSED);
+	libinput_event_destroy(event);
+
+	litest_assert_empty_queue(li);
+
+	libinput_unref(li);
+	unlink(path);
+}
+END_TEST
+
+START_TEST(replay_fast_throttle_event_queue)
+{
+	struct litest_device *dev;
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event_queue *queue;
+	struct libinput_event *event;
+	char path[] = "/tmp/litest-replay-XXXXXX";
+	unsigned int nevents = 0;
+	int fd, i, count = 0;
+
+	fd = mkstemp(path);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+
+	dev = litest_create_recorded_device(LITEST_MOUSE);
+	for (i = 0; i < 200; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	litest_recorded_device_write(dev, path);
+	litest_delete_device(dev);
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	ck_assert_notnull(li);
+
+	device = libinput_replay_add_recording(li, path);
+	ck_assert_notnull(device);
+	unlink(path);
+
+	queue = libinput_event_queue_create(li);
+	ck_assert_notnull(queue);
+	libinput_seat_set_event_queue(libinput_device_get_seat(device), queue);
+
+	/* events waiting in the seat's queue hold back the replay like
+	 * events waiting in the context's queue, so no dispatch replays
+	 * the whole recording */
+	while (!libinput_replay_is_finished(li)) {
+		unsigned int n = 0;
+
+		libinput_dispatch(li);
+		while ((event = libinput_event_queue_get_event(queue))) {
+			n++;
+			libinput_event_destroy(event);
+		}
+		ck_assert_int_lt(n, 200);
+		nevents += n;
+		litest_assert_int_lt(++count, 100);
+	}
+	ck_assert_int_eq(nevents, 200);
+
+	libinput_event_queue_unref(queue);
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(replay_inject_event)
+{
+	struct litest_device *dev;
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	char path[] = "/tmp/litest-replay-XXXXXX";
+	uint64_t t1, t2;
+	int fd;
+
+	fd = mkstemp(path);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+
+	dev = litest_create_recorded_device(LITEST_MOUSE);
+	litest_recorded_device_write(dev, path);
+	litest_delete_device(dev);
+
+	li = libinput_replay_create_manual_context(NULL, NULL);
+	ck_assert_notnull(li);
+
+	device = libinput_replay_add_recording(li, path);
+	ck_assert_notnull(device);
+	libinput_device_ref(device);
+	unlink(path);
+
+	event = libinput_get_event(li);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_ADDED);
+	libinput_event_destroy(event);
+
+	/* nothing is replayed on dispatch */
+	litest_assert_empty_queue(li);
+	ck_assert(!libinput_replay_is_finished(li));
+
+	ck_assert_int_eq(libinput_replay_device_inject_event(device, EV_REL, REL_X, 1), 0);
+	ck_assert_int_eq(libinput_replay_device_inject_event(device, EV_SYN, SYN_REPORT, 0), 0);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	t1 = libinput_event_pointer_get_time_usec(ptrev);
+	libinput_event_destroy(event);
+
+	ck_assert_int_eq(libinput_advance_virtual_time(li, ms2us(100)), 0);
+
+	ck_assert_int_eq(libinput_replay_device_inject_event(device, EV_REL, REL_X, 1), 0);
+	ck_assert_int_eq(libinput_replay_device_inject_event(device, EV_SYN, SYN_REPORT, 0), 0);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	t2 = libinput_event_pointer_get_time_usec(ptrev);
+	libinput_event_destroy(event);
+
+	ck_assert_int_eq(t2 - t1, ms2us(100));
+	litest_assert_empty_queue(li);
+
+	libinput_suspend(li);
+	ck_assert_int_eq(libinput_replay_device_inject_event(device, EV_REL, REL_X, 1),
+			 -ENODEV);
+
+	libinput_device_unref(device);
+	libinput_unref(li);
+}
+END_TEST
+
+void
+litest_setup_tests(void)
+{
+	litest_add_no_device("replay:create", replay_create_invalid);
+	litest_add_no_device("replay:create", replay_add_invalid_recording);
+	litest_add_no_device("replay:create", replay_add_recording_mismatching_backend);
+	litest_add_no_device("replay:create", replay_invalid_event_code);
+	litest_add_no_device("replay:events", replay_mouse);
+	litest_add_no_device("replay:events", replay_mouse_recorded_pace);
+	litest_add_no_device("replay:events", replay_suspend_resume);
+	litest_add_no_device("replay:events", replay_step);
+	litest_add_no_device("replay:events", replay_litest_recorded_device);
+	litest_add_no_device("replay:events", replay_inject_event);
+	litest_add_no_device("replay:events", replay_fast_throttle_event_queue);
+}
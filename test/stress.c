@@ -0,0 +1,586 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <config.h>
+
+#include <check.h>
+#include <limits.h>
+#include <libinput.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libinput-util.h"
+#include "litest.h"
+#include "litest-alloc.h"
+#include "litest-int.h"
+
+/* Worst-case processing time: a dispatch may take a fixed amount of
+ * time plus a fixed amount for each unit of work, i.e. each evdev event
+ * read, timer triggered or event posted. Anything worse than linear
+ * in the input fails the test long before it becomes noticeable in the
+ * normal test suite.
+ *
+ * Wall-clock budgets depend on the machine and its load, so they are
+ * only checked with LITEST_STRESS_TIMING set. The allocation and stats
+ * counters are checked regardless. */
+#define STRESS_DISPATCH_BUDGET ms2us(10)
+#define STRESS_WORK_BUDGET 50 /* us */
+
+/* Number of devices replayed in parallel for the timer test, each
+ * touchpad sets several timers per tap */
+#define STRESS_NUM_TIMER_DEVICES 1000
+#define STRESS_NUM_TAPS 3
+
+static uint64_t
+stress_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return s2us(ts.tv_sec) + ns2us(ts.tv_nsec);
+}
+
+static void
+stress_assert_duration(uint64_t duration, uint64_t work)
+{
+	if (!getenv("LITEST_STRESS_TIMING"))
+		return;
+
+	/* valgrind is far too slow for any time budget */
+	if (getenv("USING_VALGRIND"))
+		return;
+
+	litest_assert_int_le(duration,
+			     STRESS_DISPATCH_BUDGET + work * STRESS_WORK_BUDGET);
+}
+
+static uint64_t
+stress_stat(struct libinput *li,
+	    struct libinput_device *device,
+	    enum libinput_stat stat)
+{
+	struct libinput_stats *stats;
+	uint64_t value;
+
+	if (device)
+		stats = libinput_device_get_stats(device);
+	else
+		stats = libinput_get_stats(li);
+	litest_assert_notnull(stats);
+
+	value = libinput_stats_get_value(stats, stat);
+	libinput_stats_destroy(stats);
+
+	return value;
+}
+
+static unsigned int
+stress_drain_events(struct libinput *li)
+{
+	struct libinput_event *event;
+	unsigned int n = 0;
+
+	while ((event = libinput_get_event(li))) {
+		n++;
+		libinput_event_destroy(event);
+	}
+
+	return n;
+}
+
+/* Dispatch and drain the events of the device's context, the time spent
+ * in libinput_dispatch() must stay within the budget for the number of
+ * evdev events read, timers triggered and events posted */
+static void
+stress_dispatch(struct litest_device *dev)
+{
+	struct libinput *li = dev->libinput;
+	struct libinput_device *device = dev->libinput_device;
+	uint64_t start, duration, nevdev, ntimers, nposted;
+
+	nevdev = stress_stat(li, device, LIBINPUT_STAT_EVDEV_EVENTS);
+	ntimers = stress_stat(li, NULL, LIBINPUT_STAT_TIMER_WAKEUPS);
+
+	start = stress_now();
+	libinput_dispatch(li);
+	duration = stress_now() - start;
+	nposted = stress_drain_events(li);
+
+	nevdev = stress_stat(li, device, LIBINPUT_STAT_EVDEV_EVENTS) - nevdev;
+	ntimers = stress_stat(li, NULL, LIBINPUT_STAT_TIMER_WAKEUPS) - ntimers;
+	stress_assert_duration(duration, nevdev + ntimers + nposted);
+}
+
+static int log_messages;
+
+static void
+stress_log_handler(struct libinput *libinput,
+		   enum libinput_log_priority priority,
+		   const char *format,
+		   va_list args)
+{
+	log_messages++;
+}
+
+static void
+stress_mt_frame(struct litest_device *dev, int nslots, int i)
+{
+	int slot;
+
+	for (slot = 0; slot < nslots; slot++) {
+		litest_event(dev, EV_ABS, ABS_MT_SLOT, slot);
+		if (i == 0)
+			litest_event(dev, EV_ABS, ABS_MT_TRACKING_ID, slot + 1);
+		litest_event(dev, EV_ABS, ABS_MT_POSITION_X, 1000 + i % 100 + slot);
+		litest_event(dev, EV_ABS, ABS_MT_POSITION_Y, 1000 + i % 50 + slot);
+	}
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+}
+
+static void
+stress_mt_release(struct litest_device *dev, int nslots)
+{
+	int slot;
+
+	for (slot = 0; slot < nslots; slot++) {
+		litest_event(dev, EV_ABS, ABS_MT_SLOT, slot);
+		litest_event(dev, EV_ABS, ABS_MT_TRACKING_ID, -1);
+	}
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+}
+
+START_TEST(stress_syn_dropped_storm)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct litest_alloc_stats before, after;
+	bool is_mt;
+	int nslots;
+	int round, i;
+	const int nrounds = 10;
+	const int nframes = 512; /* overflows any evdev client buffer */
+
+	/* SYN_DROPPED comes from the kernel, there is no buffer to
+	 * overflow for a device that isn't backed by the kernel */
+	if (dev->fake)
+		return;
+
+	is_mt = libevdev_has_event_code(dev->evdev, EV_ABS, ABS_MT_SLOT);
+	if (!is_mt && !libevdev_has_event_code(dev->evdev, EV_REL, REL_X))
+		return;
+
+	nslots = is_mt ? libevdev_get_num_slots(dev->evdev) : 0;
+
+	litest_drain_events(li);
+
+	for (round = 0; round < nrounds; round++) {
+		for (i = 0; i < nframes; i++) {
+			if (is_mt) {
+				stress_mt_frame(dev, nslots, i);
+			} else {
+				litest_event(dev, EV_REL, REL_X, i % 2 ? 1 : -1);
+				litest_event(dev, EV_REL, REL_Y, 1);
+				litest_event(dev, EV_SYN, SYN_REPORT, 0);
+			}
+		}
+		if (is_mt)
+			stress_mt_release(dev, nslots);
+
+		litest_alloc_stats_get(&before);
+		stress_dispatch(dev);
+		litest_alloc_stats_get(&after);
+
+		/* the first round sets up whatever is allocated lazily */
+		if (round > 0 && litest_alloc_stats_supported())
+			litest_assert_int_eq(after.allocs - before.allocs,
+					     after.frees - before.frees);
+	}
+
+	litest_assert_int_ge(stress_stat(li,
+					 dev->libinput_device,
+					 LIBINPUT_STAT_SYN_DROPPED),
+			     (uint64_t)nrounds);
+}
+END_TEST
+
+START_TEST(stress_tracking_id_flapping)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct litest_alloc_stats before, after;
+	int nslots, slot;
+	int i, round;
+	const int nrounds = 10;
+	const int nframes = 100;
+	int tracking_id = 1;
+
+	nslots = libevdev_get_num_slots(dev->evdev);
+	if (nslots < 1)
+		return;
+
+	litest_drain_events(li);
+
+	for (round = 0; round < nrounds; round++) {
+		litest_alloc_stats_get(&before);
+
+		for (i = 0; i < nframes; i++) {
+			/* Every slot starts a new touch in every frame,
+			 * every other frame without ending the previous
+			 * touch first */
+			for (slot = 0; slot < nslots; slot++) {
+				litest_event(dev, EV_ABS, ABS_MT_SLOT, slot);
+				if (i % 2)
+					litest_event(dev,
+						     EV_ABS,
+						     ABS_MT_TRACKING_ID,
+						     -1);
+				litest_event(dev,
+					     EV_ABS,
+					     ABS_MT_TRACKING_ID,
+					     tracking_id++);
+				litest_event(dev,
+					     EV_ABS,
+					     ABS_MT_POSITION_X,
+					     1000 + slot * 100 + i);
+				litest_event(dev,
+					     EV_ABS,
+					     ABS_MT_POSITION_Y,
+					     1000 + slot * 50 + i);
+			}
+			litest_event(dev, EV_SYN, SYN_REPORT, 0);
+			stress_dispatch(dev);
+		}
+
+		stress_mt_release(dev, nslots);
+		stress_dispatch(dev);
+		litest_timeout(500);
+		stress_dispatch(dev);
+
+		litest_alloc_stats_get(&after);
+
+		if (round > 0 && litest_alloc_stats_supported())
+			litest_assert_int_eq(after.allocs - before.allocs,
+					     after.frees - before.frees);
+	}
+}
+END_TEST
+
+START_TEST(stress_fake_finger_flapping)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct litest_alloc_stats before, after;
+	const unsigned int tools[] = {
+		BTN_TOOL_FINGER,
+		BTN_TOOL_DOUBLETAP,
+		BTN_TOOL_TRIPLETAP,
+		BTN_TOOL_QUADTAP,
+		BTN_TOOL_QUINTTAP,
+	};
+	unsigned int state, prev = 0;
+	unsigned int seed = 1;
+	bool has_btn_touch;
+	int nslots, slot;
+	int i, t, round;
+	const int nrounds = 10;
+	const int nframes = 200;
+
+	nslots = libevdev_get_num_slots(dev->evdev);
+	has_btn_touch = libevdev_has_event_code(dev->evdev, EV_KEY, BTN_TOUCH);
+	litest_drain_events(li);
+
+	for (round = 0; round < nrounds; round++) {
+		litest_alloc_stats_get(&before);
+
+		for (i = 0; i < nframes; i++) {
+			/* A pseudo-random set of BTN_TOUCH (bit 0) and
+			 * BTN_TOOL_* bits per frame, including states the
+			 * kernel should never send, e.g. several tools at
+			 * once or a tool without BTN_TOUCH */
+			seed = seed * 1103515245 + 12345;
+			state = (seed >> 16) & 0x3f;
+
+			for (t = 0; t < (int)ARRAY_LENGTH(tools); t++) {
+				unsigned int bit = 1 << (t + 1);
+
+				if (!libevdev_has_event_code(dev->evdev,
+							     EV_KEY,
+							     tools[t]) ||
+				    (state & bit) == (prev & bit))
+					continue;
+
+				litest_event(dev,
+					     EV_KEY,
+					     tools[t],
+					     !!(state & bit));
+			}
+			if (has_btn_touch && (state & 0x1) != (prev & 0x1))
+				litest_event(dev, EV_KEY, BTN_TOUCH, state & 0x1);
+			prev = state;
+
+			for (slot = 0; slot < nslots; slot++) {
+				litest_event(dev, EV_ABS, ABS_MT_SLOT, slot);
+				litest_event(dev,
+					     EV_ABS,
+					     ABS_MT_TRACKING_ID,
+					     (state >> slot) & 0x1 ? slot + 1 : -1);
+				litest_event(dev,
+					     EV_ABS,
+					     ABS_MT_POSITION_X,
+					     2000 + slot * 500 + i);
+				litest_event(dev,
+					     EV_ABS,
+					     ABS_MT_POSITION_Y,
+					     2000 + slot * 300 + i);
+			}
+			litest_event(dev, EV_ABS, ABS_X, 2000 + i);
+			litest_event(dev, EV_ABS, ABS_Y, 2000 + i);
+			litest_event(dev, EV_SYN, SYN_REPORT, 0);
+			stress_dispatch(dev);
+		}
+
+		/* release everything */
+		for (t = 0; t < (int)ARRAY_LENGTH(tools); t++) {
+			if (prev & (1 << (t + 1)) &&
+			    libevdev_has_event_code(dev->evdev,
+						    EV_KEY,
+						    tools[t]))
+				litest_event(dev, EV_KEY, tools[t], 0);
+		}
+		if (has_btn_touch && prev & 0x1)
+			litest_event(dev, EV_KEY, BTN_TOUCH, 0);
+		prev = 0;
+		if (nslots > 0)
+			stress_mt_release(dev, nslots);
+		else
+			litest_event(dev, EV_SYN, SYN_REPORT, 0);
+		stress_dispatch(dev);
+		litest_timeout(500);
+		stress_dispatch(dev);
+
+		litest_alloc_stats_get(&after);
+
+		if (round > 0 && litest_alloc_stats_supported())
+			litest_assert_int_eq(after.allocs - before.allocs,
+					     after.frees - before.frees);
+	}
+}
+END_TEST
+
+static struct libinput *
+stress_replay_context(struct litest_device *dev)
+{
+	struct libinput *li;
+	struct libinput_device *device;
+	char path[] = "/tmp/litest-stress-XXXXXX";
+	int fd;
+
+	fd = mkstemp(path);
+	litest_assert_int_ge(fd, 0);
+	close(fd);
+
+	litest_recorded_device_write(dev, path);
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	litest_assert_notnull(li);
+	libinput_log_set_handler(li, stress_log_handler);
+
+	device = libinput_replay_add_recording(li, path);
+	litest_assert_notnull(device);
+	unlink(path);
+
+	return li;
+}
+
+static void
+stress_replay(struct libinput *li)
+{
+	uint64_t start, duration, nevdev, ntimers, nposted;
+	int rc;
+
+	stress_drain_events(li);
+
+	do {
+		nevdev = stress_stat(li, NULL, LIBINPUT_STAT_EVDEV_EVENTS);
+		ntimers = stress_stat(li, NULL, LIBINPUT_STAT_TIMER_WAKEUPS);
+
+		start = stress_now();
+		rc = libinput_replay_step(li);
+		duration = stress_now() - start;
+		nposted = stress_drain_events(li);
+
+		nevdev = stress_stat(li, NULL, LIBINPUT_STAT_EVDEV_EVENTS) -
+			 nevdev;
+		ntimers = stress_stat(li, NULL, LIBINPUT_STAT_TIMER_WAKEUPS) -
+			  ntimers;
+		stress_assert_duration(duration, nevdev + ntimers + nposted);
+	} while (rc != 0);
+}
+
+START_TEST(stress_slot_out_of_range)
+{
+	enum litest_device_type which = _i; /* ranged test */
+	struct litest_device *dev;
+	struct libinput *li;
+	int nslots;
+	int i;
+
+	dev = litest_create_recorded_device(which);
+	if (!dev)
+		return;
+
+	nslots = libevdev_get_num_slots(dev->evdev);
+	if (nslots < 1) {
+		litest_delete_device(dev);
+		return;
+	}
+
+	/* The kernel filters invalid slots, but a buggy driver or
+	 * recording may not. Every frame touches in-range slots and
+	 * slots beyond mt.slots_len, including negative ones. */
+	for (i = 0; i < 1000; i++) {
+		const int slots[] = {
+			0, nslots - 1, nslots, nslots + 1, 1000, INT_MAX, -1, -100,
+		};
+		int s = slots[i % ARRAY_LENGTH(slots)];
+
+		litest_event(dev, EV_ABS, ABS_MT_SLOT, s);
+		if (i % 3 == 0)
+			litest_event(dev,
+				     EV_ABS,
+				     ABS_MT_TRACKING_ID,
+				     i % 2 ? i : -1);
+		litest_event(dev, EV_ABS, ABS_MT_POSITION_X, 1000 + i % 100);
+		litest_event(dev, EV_ABS, ABS_MT_POSITION_Y, 1000 + i % 100);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	stress_mt_release(dev, nslots);
+	dev->recording.time += ms2us(1000);
+
+	li = stress_replay_context(dev);
+	litest_delete_device(dev);
+
+	log_messages = 0;
+	stress_replay(li);
+
+	/* all complaints about the device are ratelimited */
+	litest_assert_int_le(log_messages, 20);
+
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(stress_many_timers)
+{
+	struct litest_device *dev;
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	char path[] = "/tmp/litest-stress-XXXXXX";
+	int fd;
+	int i, rc;
+	unsigned int nbuttons = 0;
+	uint64_t start, duration, nevdev, ntimers, nposted;
+
+	dev = litest_create_recorded_device(LITEST_SYNAPTICS_TOPBUTTONPAD);
+	litest_assert_notnull(dev);
+
+	for (i = 0; i < STRESS_NUM_TAPS; i++) {
+		litest_touch_down(dev, 0, 50, 50);
+		litest_touch_up(dev, 0);
+		dev->recording.time += ms2us(500);
+	}
+
+	fd = mkstemp(path);
+	litest_assert_int_ge(fd, 0);
+	close(fd);
+	litest_recorded_device_write(dev, path);
+	litest_delete_device(dev);
+
+	li = libinput_replay_create_context(NULL, NULL,
+					    LIBINPUT_REPLAY_PACE_FAST);
+	litest_assert_notnull(li);
+	libinput_log_set_handler(li, stress_log_handler);
+
+	/* All devices replay the same taps at the same time, so every
+	 * frame and every timeout arms or triggers the timers of all
+	 * devices at once */
+	for (i = 0; i < STRESS_NUM_TIMER_DEVICES; i++) {
+		device = libinput_replay_add_recording(li, path);
+		litest_assert_notnull(device);
+		libinput_device_config_tap_set_enabled(device,
+						       LIBINPUT_CONFIG_TAP_ENABLED);
+	}
+	unlink(path);
+
+	stress_drain_events(li);
+
+	do {
+		nevdev = stress_stat(li, NULL, LIBINPUT_STAT_EVDEV_EVENTS);
+		ntimers = stress_stat(li, NULL, LIBINPUT_STAT_TIMER_WAKEUPS);
+
+		start = stress_now();
+		rc = libinput_replay_step(li);
+		duration = stress_now() - start;
+
+		nposted = 0;
+		while ((event = libinput_get_event(li))) {
+			if (libinput_event_get_type(event) ==
+			    LIBINPUT_EVENT_POINTER_BUTTON)
+				nbuttons++;
+			nposted++;
+			libinput_event_destroy(event);
+		}
+
+		nevdev = stress_stat(li, NULL, LIBINPUT_STAT_EVDEV_EVENTS) -
+			 nevdev;
+		ntimers = stress_stat(li, NULL, LIBINPUT_STAT_TIMER_WAKEUPS) -
+			  ntimers;
+		stress_assert_duration(duration, nevdev + ntimers + nposted);
+	} while (rc != 0);
+
+	/* every tap on every device is a button press and release */
+	litest_assert_int_eq(nbuttons,
+			     STRESS_NUM_TIMER_DEVICES * STRESS_NUM_TAPS * 2U);
+
+	libinput_unref(li);
+}
+END_TEST
+
+void
+litest_setup_tests(void)
+{
+	struct range devices;
+
+	litest_device_type_range(&devices);
+	litest_add("stress:syn-dropped", stress_syn_dropped_storm, LITEST_ANY, LITEST_ANY);
+	litest_add("stress:tracking-id", stress_tracking_id_flapping, LITEST_TOUCHPAD, LITEST_ANY);
+	litest_add("stress:tracking-id", stress_tracking_id_flapping, LITEST_TOUCH, LITEST_ANY);
+	litest_add("stress:fake-fingers", stress_fake_finger_flapping, LITEST_TOUCHPAD, LITEST_ANY);
+	litest_add_ranged_no_device("stress:slots", stress_slot_out_of_range, &devices);
+	litest_add_no_device("stress:timers", stress_many_timers);
+}
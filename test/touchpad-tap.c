@@ -59,6 +59,50 @@ START_TEST(touchpad_1fg_tap)
 }
 END_TEST
 
+static size_t
+trace_size(struct libinput_device *device)
+{
+	int fds[2];
+	char buf[64 * 1024];
+	ssize_t len;
+
+	ck_assert_int_eq(pipe(fds), 0);
+	ck_assert_int_eq(libinput_device_dump_trace(device, fds[1]), 0);
+	len = read(fds[0], buf, sizeof(buf));
+	ck_assert_int_gt(len, 0);
+	close(fds[0]);
+	close(fds[1]);
+
+	return len;
+}
+
+START_TEST(touchpad_1fg_tap_trace)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	size_t before, after;
+
+	litest_enable_tap(dev->libinput_device);
+	litest_drain_events(li);
+
+	before = trace_size(dev->libinput_device);
+
+	litest_touch_down(dev, 0, 50, 50);
+	litest_touch_up(dev, 0);
+	libinput_dispatch(li);
+	litest_timeout_tap();
+	libinput_dispatch(li);
+	litest_drain_events(li);
+
+	/* at least three 16-byte entries: idle → touch → tapped → idle */
+	after = trace_size(dev->libinput_device);
+	ck_assert_int_ge(after - before, 3 * 16);
+
+	ck_assert_int_lt(libinput_device_dump_trace(dev->libinput_device, -1),
+			 0);
+}
+END_TEST
+
 START_TEST(touchpad_1fg_doubletap)
 {
 	struct litest_device *dev = litest_current_device();
@@ -135,7 +179,7 @@ START_TEST(touchpad_1fg_multitap)
 		litest_touch_down(dev, 0, 50, 50);
 		litest_touch_up(dev, 0);
 		libinput_dispatch(li);
-		msleep(10);
+		litest_timeout(10);
 	}
 
 	litest_timeout_tap();
@@ -183,7 +227,7 @@ START_TEST(touchpad_1fg_multitap_n_drag_move)
 		litest_touch_down(dev, 0, 50, 50);
 		litest_touch_up(dev, 0);
 		libinput_dispatch(li);
-		msleep(10);
+		litest_timeout(10);
 	}
 
 	libinput_dispatch(li);
@@ -252,12 +296,12 @@ START_TEST(touchpad_1fg_multitap_n_drag_2fg)
 		litest_touch_down(dev, 0, 50, 50);
 		litest_touch_up(dev, 0);
 		libinput_dispatch(li);
-		msleep(10);
+		litest_timeout(10);
 	}
 
 	libinput_dispatch(li);
 	litest_touch_down(dev, 0, 50, 50);
-	msleep(10);
+	litest_timeout(10);
 	litest_touch_down(dev, 1, 70, 50);
 	libinput_dispatch(li);
 
@@ -323,7 +367,7 @@ START_TEST(touchpad_1fg_multitap_n_drag_click)
 		litest_touch_down(dev, 0, 50, 50);
 		litest_touch_up(dev, 0);
 		libinput_dispatch(li);
-		msleep(10);
+		litest_timeout(10);
 	}
 
 	litest_touch_down(dev, 0, 50, 50);
@@ -383,7 +427,7 @@ START_TEST(touchpad_1fg_multitap_n_drag_timeout)
 		litest_touch_down(dev, 0, 50, 50);
 		litest_touch_up(dev, 0);
 		libinput_dispatch(li);
-		msleep(10);
+		litest_timeout(10);
 	}
 
 	libinput_dispatch(li);
@@ -454,7 +498,7 @@ START_TEST(touchpad_1fg_multitap_n_drag_tap)
 		litest_touch_down(dev, 0, 50, 50);
 		litest_touch_up(dev, 0);
 		libinput_dispatch(li);
-		msleep(10);
+		litest_timeout(10);
 	}
 
 	libinput_dispatch(li);
@@ -527,7 +571,7 @@ START_TEST(touchpad_1fg_multitap_n_drag_tap_click)
 		litest_touch_down(dev, 0, 50, 50);
 		litest_touch_up(dev, 0);
 		libinput_dispatch(li);
-		msleep(10);
+		litest_timeout(10);
 	}
 
 	libinput_dispatch(li);
@@ -1783,6 +1827,7 @@ litest_setup_tests(void)
 	struct range multitap_range = {3, 8};
 
 	litest_add("touchpad:tap", touchpad_1fg_tap, LITEST_TOUCHPAD, LITEST_ANY);
+	litest_add("touchpad:tap", touchpad_1fg_tap_trace, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add("touchpad:tap", touchpad_1fg_doubletap, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add_ranged("touchpad:tap", touchpad_1fg_multitap, LITEST_TOUCHPAD, LITEST_ANY, &multitap_range);
 	litest_add_ranged("touchpad:tap", touchpad_1fg_multitap_n_drag_timeout, LITEST_TOUCHPAD, LITEST_ANY, &multitap_range);
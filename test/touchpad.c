@@ -2356,7 +2356,7 @@ START_TEST(touchpad_dwt_enable_touch)
 
 	/* finger down after last key event, but
 	   we're still within timeout - no events */
-	msleep(10);
+	litest_timeout(10);
 	litest_touch_down(touchpad, 0, 50, 50);
 	litest_touch_move_to(touchpad, 0, 50, 50, 70, 50, 10, 1);
 	litest_assert_empty_queue(li);
@@ -2388,7 +2388,7 @@ START_TEST(touchpad_dwt_touch_hold)
 	litest_drain_events(li);
 
 	litest_keyboard_key(keyboard, KEY_A, true);
-	msleep(1); /* make sure touch starts after key press */
+	litest_timeout(1); /* make sure touch starts after key press */
 	litest_touch_down(touchpad, 0, 50, 50);
 	litest_touch_move_to(touchpad, 0, 50, 50, 70, 50, 5, 1);
 
@@ -2559,7 +2559,7 @@ START_TEST(touchpad_dwt_tap_drag)
 
 	litest_keyboard_key(keyboard, KEY_A, true);
 	libinput_dispatch(li);
-	msleep(1); /* make sure touch starts after key press */
+	litest_timeout(1); /* make sure touch starts after key press */
 	litest_touch_down(touchpad, 0, 50, 50);
 	litest_touch_up(touchpad, 0);
 	litest_touch_down(touchpad, 0, 50, 50);
@@ -3470,7 +3470,7 @@ START_TEST(touchpad_tool_tripletap_touch_count)
 	litest_event(dev, EV_KEY, BTN_TOUCH, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	libinput_dispatch(li);
-	msleep(2);
+	litest_timeout(2);
 
 	/* touch 2 down */
 	litest_event(dev, EV_ABS, ABS_MT_SLOT, 1);
@@ -3482,7 +3482,7 @@ START_TEST(touchpad_tool_tripletap_touch_count)
 	litest_event(dev, EV_KEY, BTN_TOOL_DOUBLETAP, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	libinput_dispatch(li);
-	msleep(2);
+	litest_timeout(2);
 
 	/* touch 3 down, coordinate jump + ends slot 1 */
 	litest_event(dev, EV_ABS, ABS_MT_SLOT, 0);
@@ -3498,7 +3498,7 @@ START_TEST(touchpad_tool_tripletap_touch_count)
 	litest_event(dev, EV_KEY, BTN_TOOL_TRIPLETAP, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	libinput_dispatch(li);
-	msleep(2);
+	litest_timeout(2);
 
 	/* slot 2 reactivated:
 	 * Note, slot is activated close enough that we don't accidentally
@@ -3519,7 +3519,7 @@ START_TEST(touchpad_tool_tripletap_touch_count)
 	litest_event(dev, EV_ABS, ABS_PRESSURE, 78);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	libinput_dispatch(li);
-	msleep(2);
+	litest_timeout(2);
 
 	/* now a click should trigger middle click */
 	litest_event(dev, EV_KEY, BTN_LEFT, 1);
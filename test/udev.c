@@ -29,6 +29,8 @@
 #include <libinput.h>
 #include <libinput-util.h>
 #include <libudev.h>
+#include <poll.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "litest.h"
@@ -131,6 +133,95 @@ START_TEST(udev_create_empty_seat)
 }
 END_TEST
 
+static int
+count_added_devices(struct libinput *li, const char *physical_name)
+{
+	struct libinput_event *event;
+	struct libinput_device *device;
+	struct libinput_seat *seat;
+	int count = 0;
+
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li))) {
+		if (libinput_event_get_type(event) ==
+		    LIBINPUT_EVENT_DEVICE_ADDED) {
+			device = libinput_event_get_device(event);
+			seat = libinput_device_get_seat(device);
+			if (physical_name)
+				ck_assert_str_eq(libinput_seat_get_physical_name(seat),
+						 physical_name);
+			count++;
+		}
+		libinput_event_destroy(event);
+	}
+
+	return count;
+}
+
+START_TEST(udev_create_seats)
+{
+	struct libinput *li;
+	struct udev *udev;
+	const char *seats[] = { "seatdoesntexist", "seat0", NULL };
+	const char *no_seats[] = { NULL };
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_udev_assign_seats(li, no_seats), -1);
+	ck_assert_int_eq(libinput_udev_assign_seats(li, seats), 0);
+	ck_assert_int_eq(libinput_udev_assign_seats(li, seats), -1);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), -1);
+
+	ck_assert_int_gt(count_added_devices(li, "seat0"), 0);
+
+	libinput_unref(li);
+	udev_unref(udev);
+}
+END_TEST
+
+START_TEST(udev_create_all_seats)
+{
+	struct libinput *li;
+	struct udev *udev;
+	int nseat0, nall;
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+	nseat0 = count_added_devices(li, "seat0");
+	libinput_unref(li);
+
+	li = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert_int_eq(libinput_udev_assign_seats(li, NULL), 0);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), -1);
+	nall = count_added_devices(li, NULL);
+	libinput_unref(li);
+
+	ck_assert_int_gt(nseat0, 0);
+	ck_assert_int_ge(nall, nseat0);
+
+	udev_unref(udev);
+}
+END_TEST
+
+START_TEST(udev_assign_seats_wrong_backend)
+{
+	struct libinput *li;
+	const char *seats[] = { "seat0", NULL };
+
+	li = litest_create_context();
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_udev_assign_seats(li, seats), -1);
+	litest_restore_log_handler(li);
+	libinput_unref(li);
+}
+END_TEST
+
 START_TEST(udev_set_user_data)
 {
 	struct libinput *li;
@@ -395,6 +486,415 @@ START_TEST(udev_suspend_resume)
 }
 END_TEST
 
+static void
+count_device_events(struct libinput *li, int *added, int *removed)
+{
+	struct libinput_event *event;
+
+	*added = 0;
+	*removed = 0;
+
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li))) {
+		switch (libinput_event_get_type(event)) {
+		case LIBINPUT_EVENT_DEVICE_ADDED:
+			(*added)++;
+			break;
+		case LIBINPUT_EVENT_DEVICE_REMOVED:
+			(*removed)++;
+			break;
+		default:
+			break;
+		}
+		libinput_event_destroy(event);
+	}
+}
+
+START_TEST(udev_soft_suspend_resume)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li;
+	struct udev *udev;
+	int added, removed;
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_udev_set_soft_suspend(li, 1), 0);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+
+	count_device_events(li, &added, &removed);
+	ck_assert_int_gt(added, 0);
+
+	/* devices stay around across a suspend/resume cycle */
+	libinput_suspend(li);
+	count_device_events(li, &added, &removed);
+	ck_assert_int_eq(added, 0);
+	ck_assert_int_eq(removed, 0);
+
+	libinput_resume(li);
+	count_device_events(li, &added, &removed);
+	ck_assert_int_eq(added, 0);
+	ck_assert_int_eq(removed, 0);
+
+	/* and send events after resuming */
+	litest_touch_down(dev, 0, 50, 50);
+	litest_touch_move_to(dev, 0, 50, 50, 70, 50, 10, 0);
+	litest_touch_up(dev, 0);
+
+	libinput_dispatch(li);
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_POINTER_MOTION);
+
+	libinput_unref(li);
+	udev_unref(udev);
+}
+END_TEST
+
+START_TEST(udev_soft_suspend_hotplug)
+{
+	struct litest_device *mouse, *keyboard;
+	struct libinput *li;
+	struct udev *udev;
+	int added, removed;
+
+	mouse = litest_create_device(LITEST_MOUSE);
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_udev_set_soft_suspend(li, 1), 0);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+	litest_drain_events(li);
+
+	libinput_suspend(li);
+	litest_delete_device(mouse);
+	keyboard = litest_create_device(LITEST_KEYBOARD);
+
+	/* only the changes are announced */
+	libinput_resume(li);
+	count_device_events(li, &added, &removed);
+	ck_assert_int_eq(added, 1);
+	ck_assert_int_eq(removed, 1);
+
+	libinput_unref(li);
+	udev_unref(udev);
+
+	litest_delete_device(keyboard);
+}
+END_TEST
+
+START_TEST(udev_soft_suspend_wrong_backend)
+{
+	struct libinput *li;
+
+	li = litest_create_context();
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_udev_set_soft_suspend(li, 1), -1);
+	litest_restore_log_handler(li);
+	libinput_unref(li);
+}
+END_TEST
+
+struct async_opens {
+	struct libinput_open_request *requests[256];
+	char *paths[256];
+	int flags[256];
+	size_t nrequests;
+};
+
+static void
+open_restricted_async(struct libinput_open_request *request,
+		      const char *path,
+		      int flags,
+		      void *data)
+{
+	struct async_opens *opens = data;
+	size_t n = opens->nrequests;
+
+	ck_assert_int_lt(n, ARRAY_LENGTH(opens->requests));
+	opens->requests[n] = request;
+	opens->paths[n] = strdup(path);
+	opens->flags[n] = flags;
+	opens->nrequests++;
+}
+
+static const struct libinput_async_interface async_interface = {
+	.open_restricted_async = open_restricted_async,
+};
+
+static int
+complete_async_opens(struct async_opens *opens, int *fds)
+{
+	size_t i = opens->nrequests;
+	int fd;
+
+	/* complete in reverse order, devices are still added in the
+	 * order they were requested */
+	while (i-- > 0) {
+		fd = open_restricted(opens->paths[i], opens->flags[i], NULL);
+		if (fds)
+			fds[i] = fd;
+		libinput_open_request_complete(opens->requests[i], fd);
+		free(opens->paths[i]);
+	}
+
+	i = opens->nrequests;
+	opens->nrequests = 0;
+
+	return i;
+}
+
+START_TEST(udev_async_open)
+{
+	struct litest_device *dev = litest_current_device();
+	struct async_opens opens = {0};
+	struct libinput *li;
+	struct libinput_event *event;
+	struct libinput_device *device;
+	struct udev_device *udev_device;
+	struct udev *udev;
+	const char *devnode;
+	int added = 0, removed;
+	bool found = false;
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, &opens, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_set_async_interface(li, &async_interface), 0);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+
+	/* nothing is added until the opens complete */
+	count_device_events(li, &added, &removed);
+	ck_assert_int_eq(added, 0);
+	ck_assert_int_gt(opens.nrequests, 0);
+
+	complete_async_opens(&opens, NULL);
+
+	devnode = libevdev_uinput_get_devnode(dev->uinput);
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li))) {
+		if (libinput_event_get_type(event) ==
+		    LIBINPUT_EVENT_DEVICE_ADDED) {
+			device = libinput_event_get_device(event);
+			udev_device = libinput_device_get_udev_device(device);
+			if (streq(udev_device_get_devnode(udev_device), devnode))
+				found = true;
+			udev_device_unref(udev_device);
+			added++;
+		}
+		libinput_event_destroy(event);
+	}
+	ck_assert_int_gt(added, 0);
+	ck_assert(found);
+
+	libinput_unref(li);
+	udev_unref(udev);
+}
+END_TEST
+
+START_TEST(udev_async_open_soft_resume)
+{
+	struct async_opens opens = {0};
+	struct libinput *li;
+	struct udev *udev;
+	int added, removed;
+	int nopens;
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, &opens, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_set_async_interface(li, &async_interface), 0);
+	ck_assert_int_eq(libinput_udev_set_soft_suspend(li, 1), 0);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+
+	nopens = complete_async_opens(&opens, NULL);
+	count_device_events(li, &added, &removed);
+	ck_assert_int_gt(added, 0);
+
+	/* kept devices are re-opened through the async interface */
+	libinput_suspend(li);
+	libinput_resume(li);
+	ck_assert_int_ge(opens.nrequests, added);
+	ck_assert_int_le(opens.nrequests, nopens);
+	complete_async_opens(&opens, NULL);
+
+	count_device_events(li, &added, &removed);
+	ck_assert_int_eq(added, 0);
+	ck_assert_int_eq(removed, 0);
+
+	libinput_unref(li);
+	udev_unref(udev);
+}
+END_TEST
+
+START_TEST(udev_async_open_after_destroy)
+{
+	struct async_opens opens = {0};
+	struct libinput *li;
+	struct udev *udev;
+	int fds[ARRAY_LENGTH(opens.requests)];
+	int i, nopens;
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, &opens, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_set_async_interface(li, &async_interface), 0);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+	ck_assert_int_gt(opens.nrequests, 0);
+
+	libinput_unref(li);
+
+	/* nobody wants these fds anymore, libinput closes them */
+	nopens = complete_async_opens(&opens, fds);
+	for (i = 0; i < nopens; i++) {
+		if (fds[i] < 0)
+			continue;
+		ck_assert_int_eq(fcntl(fds[i], F_GETFD), -1);
+	}
+
+	udev_unref(udev);
+}
+END_TEST
+
+/* Dispatch for a while, bursts of uevents are held back for a moment.
+ * Counts the added and removed events for each of the device nodes. */
+static void
+count_hotplug_events(struct libinput *li,
+		     const char **devnodes,
+		     int *added,
+		     int *removed,
+		     size_t ndevnodes)
+{
+	enum libinput_event_type type;
+	struct libinput_event *event;
+	struct libinput_device *device;
+	struct udev_device *udev_device;
+	struct pollfd fds;
+	size_t i;
+	int loop;
+
+	fds.fd = libinput_get_fd(li);
+	fds.events = POLLIN;
+	fds.revents = 0;
+
+	for (loop = 0; loop < 10; loop++) {
+		poll(&fds, 1, 20);
+		libinput_dispatch(li);
+		while ((event = libinput_get_event(li))) {
+			type = libinput_event_get_type(event);
+			if (type != LIBINPUT_EVENT_DEVICE_ADDED &&
+			    type != LIBINPUT_EVENT_DEVICE_REMOVED) {
+				libinput_event_destroy(event);
+				continue;
+			}
+
+			device = libinput_event_get_device(event);
+			udev_device = libinput_device_get_udev_device(device);
+			for (i = 0; i < ndevnodes; i++) {
+				if (!streq(udev_device_get_devnode(udev_device),
+					   devnodes[i]))
+					continue;
+
+				if (type == LIBINPUT_EVENT_DEVICE_ADDED)
+					added[i]++;
+				else
+					removed[i]++;
+			}
+			udev_device_unref(udev_device);
+			libinput_event_destroy(event);
+		}
+	}
+}
+
+START_TEST(udev_hotplug_burst)
+{
+	struct litest_device *devices[4];
+	const char *devnodes[ARRAY_LENGTH(devices)];
+	int added[ARRAY_LENGTH(devices)] = {0};
+	int removed[ARRAY_LENGTH(devices)] = {0};
+	struct libinput *li;
+	struct udev *udev;
+	unsigned int i;
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+	litest_drain_events(li);
+
+	devices[0] = litest_create_device(LITEST_MOUSE);
+	devices[1] = litest_create_device(LITEST_KEYBOARD);
+	devices[2] = litest_create_device(LITEST_NEXUS4_TOUCH_SCREEN);
+	devices[3] = litest_create_device(LITEST_SYNAPTICS_CLICKPAD);
+	for (i = 0; i < ARRAY_LENGTH(devices); i++)
+		devnodes[i] = libevdev_uinput_get_devnode(devices[i]->uinput);
+
+	/* all uevents are handled in one go, every device is added
+	 * exactly once */
+	count_hotplug_events(li,
+			     devnodes,
+			     added,
+			     removed,
+			     ARRAY_LENGTH(devices));
+	for (i = 0; i < ARRAY_LENGTH(devices); i++) {
+		ck_assert_int_eq(added[i], 1);
+		ck_assert_int_eq(removed[i], 0);
+	}
+
+	libinput_unref(li);
+	udev_unref(udev);
+
+	for (i = 0; i < ARRAY_LENGTH(devices); i++)
+		litest_delete_device(devices[i]);
+}
+END_TEST
+
+START_TEST(udev_hotplug_flap)
+{
+	struct litest_device *dev;
+	const char *devnode;
+	char *devnode_copy;
+	int added = 0, removed = 0;
+	struct libinput *li;
+	struct udev *udev;
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+	litest_drain_events(li);
+
+	/* a device that comes and goes before we look at the uevents
+	 * is never added, or added and removed again */
+	dev = litest_create_device(LITEST_MOUSE);
+	devnode_copy = strdup(libevdev_uinput_get_devnode(dev->uinput));
+	litest_delete_device(dev);
+
+	devnode = devnode_copy;
+	count_hotplug_events(li, &devnode, &added, &removed, 1);
+	ck_assert_int_le(added, 1);
+	ck_assert_int_eq(added, removed);
+
+	libinput_unref(li);
+	udev_unref(udev);
+	free(devnode_copy);
+}
+END_TEST
+
 START_TEST(udev_device_sysname)
 {
 	struct libinput *li;
@@ -432,6 +932,77 @@ START_TEST(udev_device_sysname)
 }
 END_TEST
 
+START_TEST(udev_device_order)
+{
+	struct litest_device *devices[4];
+	struct libinput *li;
+	struct libinput_event *ev;
+	struct libinput_device *device;
+	struct udev_device *udev_device;
+	struct udev *udev;
+	struct udev_enumerate *e;
+	struct udev_list_entry *entry;
+	const char *syspaths[256];
+	const char *syspath;
+	size_t nsyspaths = 0, idx = 0;
+	int nadded = 0;
+	unsigned int i;
+
+	devices[0] = litest_create_device(LITEST_MOUSE);
+	devices[1] = litest_create_device(LITEST_KEYBOARD);
+	devices[2] = litest_create_device(LITEST_NEXUS4_TOUCH_SCREEN);
+	devices[3] = litest_create_device(LITEST_SYNAPTICS_CLICKPAD);
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	e = udev_enumerate_new(udev);
+	udev_enumerate_add_match_subsystem(e, "input");
+	udev_enumerate_scan_devices(e);
+	udev_list_entry_foreach(entry, udev_enumerate_get_list_entry(e)) {
+		ck_assert_int_lt(nsyspaths, ARRAY_LENGTH(syspaths));
+		syspaths[nsyspaths++] = udev_list_entry_get_name(entry);
+	}
+
+	li = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+
+	/* devices are probed in parallel but must be added in the
+	 * order of the udev enumeration */
+	libinput_dispatch(li);
+	while ((ev = libinput_get_event(li))) {
+		if (libinput_event_get_type(ev) !=
+		    LIBINPUT_EVENT_DEVICE_ADDED) {
+			libinput_event_destroy(ev);
+			continue;
+		}
+
+		device = libinput_event_get_device(ev);
+		udev_device = libinput_device_get_udev_device(device);
+		ck_assert(udev_device != NULL);
+		syspath = udev_device_get_syspath(udev_device);
+		while (idx < nsyspaths && !streq(syspaths[idx], syspath))
+			idx++;
+		ck_assert_int_lt(idx, nsyspaths);
+		nadded++;
+
+		udev_device_unref(udev_device);
+
+		libinput_event_destroy(ev);
+	}
+
+	ck_assert_int_ge(nadded, ARRAY_LENGTH(devices));
+
+	libinput_unref(li);
+	udev_enumerate_unref(e);
+	udev_unref(udev);
+
+	for (i = 0; i < ARRAY_LENGTH(devices); i++)
+		litest_delete_device(devices[i]);
+}
+END_TEST
+
 START_TEST(udev_seat_recycle)
 {
 	struct udev *udev;
@@ -514,6 +1085,9 @@ litest_setup_tests(void)
 	litest_add_no_device("udev:create", udev_create_seat0);
 	litest_add_no_device("udev:create", udev_create_empty_seat);
 	litest_add_no_device("udev:create", udev_set_user_data);
+	litest_add_no_device("udev:create", udev_create_seats);
+	litest_add_no_device("udev:create", udev_create_all_seats);
+	litest_add_no_device("udev:create", udev_assign_seats_wrong_backend);
 
 	litest_add_no_device("udev:seat", udev_added_seat_default);
 	litest_add_no_device("udev:seat", udev_change_seat);
@@ -521,6 +1095,15 @@ litest_setup_tests(void)
 	litest_add_for_device("udev:suspend", udev_double_suspend, LITEST_SYNAPTICS_CLICKPAD);
 	litest_add_for_device("udev:suspend", udev_double_resume, LITEST_SYNAPTICS_CLICKPAD);
 	litest_add_for_device("udev:suspend", udev_suspend_resume, LITEST_SYNAPTICS_CLICKPAD);
+	litest_add_for_device("udev:suspend", udev_soft_suspend_resume, LITEST_SYNAPTICS_CLICKPAD);
+	litest_add_no_device("udev:suspend", udev_soft_suspend_hotplug);
+	litest_add_no_device("udev:suspend", udev_soft_suspend_wrong_backend);
+	litest_add_for_device("udev:async", udev_async_open, LITEST_SYNAPTICS_CLICKPAD);
+	litest_add_for_device("udev:async", udev_async_open_soft_resume, LITEST_SYNAPTICS_CLICKPAD);
+	litest_add_for_device("udev:async", udev_async_open_after_destroy, LITEST_SYNAPTICS_CLICKPAD);
 	litest_add_for_device("udev:device events", udev_device_sysname, LITEST_SYNAPTICS_CLICKPAD);
+	litest_add_no_device("udev:device events", udev_device_order);
+	litest_add_no_device("udev:hotplug", udev_hotplug_burst);
+	litest_add_no_device("udev:hotplug", udev_hotplug_flap);
 	litest_add_for_device("udev:seat", udev_seat_recycle, LITEST_SYNAPTICS_CLICKPAD);
 }
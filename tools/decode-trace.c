@@ -0,0 +1,196 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <evdev-mt-touchpad.h>
+
+static void
+usage(void)
+{
+	printf("Usage: %s [trace-file]\n"
+	       "\n"
+	       "Decode a state machine trace written by libinput_device_dump_trace().\n"
+	       "If no file is given, the trace is read from stdin.\n"
+	       "\n"
+	       "The trace format is internal to libinput, this tool must be from\n"
+	       "the same libinput version that wrote the trace.\n",
+	       program_invocation_short_name);
+}
+
+static int
+read_all(int fd, void *data, size_t len)
+{
+	char *p = data;
+	ssize_t rc;
+
+	while (len > 0) {
+		rc = read(fd, p, len);
+		if (rc < 0 && errno == EINTR)
+			continue;
+		if (rc <= 0)
+			return -1;
+		p += rc;
+		len -= rc;
+	}
+
+	return 0;
+}
+
+static const char *
+or_number(const char *str, unsigned int value)
+{
+	static char buf[4][16];
+	static unsigned int idx;
+
+	if (str)
+		return str;
+
+	idx = (idx + 1) % ARRAY_LENGTH(buf);
+	snprintf(buf[idx], sizeof(buf[idx]), "<%u>", value);
+	return buf[idx];
+}
+
+static void
+print_entry(const struct evdev_trace_entry *e, uint64_t start_time)
+{
+	const char *subsystem, *old_state, *event, *new_state;
+
+	switch (e->subsystem) {
+	case EVDEV_TRACE_TAP:
+		subsystem = "tap";
+		old_state = tap_state_to_str(e->old_state);
+		event = tap_event_to_str(e->event);
+		new_state = tap_state_to_str(e->new_state);
+		break;
+	case EVDEV_TRACE_BUTTON:
+		subsystem = "button";
+		old_state = button_state_to_str(e->old_state);
+		event = button_event_to_str(e->event);
+		new_state = button_state_to_str(e->new_state);
+		break;
+	case EVDEV_TRACE_EDGE_SCROLL:
+		subsystem = "edge";
+		old_state = edge_state_to_str(e->old_state);
+		event = edge_event_to_str(e->event);
+		new_state = edge_state_to_str(e->new_state);
+		break;
+	case EVDEV_TRACE_GESTURE:
+		subsystem = "gesture";
+		old_state = gesture_state_to_str(e->old_state);
+		event = "-";
+		new_state = gesture_state_to_str(e->new_state);
+		break;
+	case EVDEV_TRACE_MIDDLEBUTTON:
+		subsystem = "middlebutton";
+		old_state = middlebutton_state_to_str(e->old_state);
+		event = middlebutton_event_to_str(e->event);
+		new_state = middlebutton_state_to_str(e->new_state);
+		break;
+	default:
+		subsystem = "unknown";
+		old_state = NULL;
+		event = NULL;
+		new_state = NULL;
+		break;
+	}
+
+	printf("%+10.3fms	%-12s	",
+	       (int64_t)(e->time - start_time) / 1000.0,
+	       subsystem);
+	if (e->touch >= 0)
+		printf("touch %-2d	", e->touch);
+	else
+		printf("        	");
+	printf("%s → %s → %s\n",
+	       or_number(old_state, e->old_state),
+	       or_number(event, e->event),
+	       or_number(new_state, e->new_state));
+}
+
+int
+main(int argc, char **argv)
+{
+	struct evdev_trace_header header;
+	struct evdev_trace_entry *entries;
+	uint32_t i;
+	int fd = STDIN_FILENO;
+
+	if (argc > 2 ||
+	    (argc == 2 && (streq(argv[1], "--help") || streq(argv[1], "-h")))) {
+		usage();
+		return argc > 2;
+	}
+
+	if (argc == 2) {
+		fd = open(argv[1], O_RDONLY);
+		if (fd < 0) {
+			fprintf(stderr, "Failed to open %s (%s)\n",
+				argv[1], strerror(errno));
+			return 1;
+		}
+	}
+
+	if (read_all(fd, &header, sizeof(header)) != 0 ||
+	    header.magic != EVDEV_TRACE_MAGIC) {
+		fprintf(stderr, "Not a libinput trace\n");
+		return 1;
+	}
+
+	if (header.version != EVDEV_TRACE_VERSION ||
+	    header.entry_size != sizeof(struct evdev_trace_entry)) {
+		fprintf(stderr,
+			"Trace version %u is not supported by this tool\n",
+			header.version);
+		return 1;
+	}
+
+	if (header.nentries == 0) {
+		printf("Trace is empty\n");
+		return 0;
+	}
+
+	entries = calloc(header.nentries, sizeof(*entries));
+	if (!entries ||
+	    read_all(fd, entries, header.nentries * sizeof(*entries)) != 0) {
+		fprintf(stderr, "Failed to read trace entries\n");
+		free(entries);
+		return 1;
+	}
+
+	for (i = 0; i < header.nentries; i++)
+		print_entry(&entries[i], entries[0].time);
+
+	free(entries);
+	if (fd != STDIN_FILENO)
+		close(fd);
+
+	return 0;
+}
@@ -36,6 +36,7 @@
 
 #include <libinput.h>
 #include <libevdev/libevdev.h>
+#include <libinput-util.h>
 
 #include "shared.h"
 
@@ -45,6 +46,14 @@ static const uint32_t screen_height = 100;
 struct tools_context context;
 static unsigned int stop = 0;
 
+/* Devices whose latency histograms are printed, each one is hooked up to
+ * its libinput_device through the device's user data */
+struct latency_device {
+	struct libinput_device *device;
+	struct latency_device *prev, *next;
+};
+static struct latency_device *latency_devices;
+
 static void
 print_event_header(struct libinput_event *ev)
 {
@@ -366,6 +375,132 @@ print_gesture_event_with_coords(struct libinput_event *ev)
 	}
 }
 
+static void
+track_latency_device(struct libinput_event *ev)
+{
+	struct libinput_device *dev = libinput_event_get_device(ev);
+	struct latency_device *ld;
+
+	if (context.options.latency_interval == 0)
+		return;
+
+	switch (libinput_event_get_type(ev)) {
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+		ld = zalloc(sizeof(*ld));
+		if (!ld) {
+			fprintf(stderr,
+				"%s: out of memory, not tracking latencies\n",
+				libinput_device_get_sysname(dev));
+			return;
+		}
+		ld->device = libinput_device_ref(dev);
+		ld->next = latency_devices;
+		if (latency_devices)
+			latency_devices->prev = ld;
+		latency_devices = ld;
+		libinput_device_set_user_data(dev, ld);
+		break;
+	case LIBINPUT_EVENT_DEVICE_REMOVED:
+		ld = libinput_device_get_user_data(dev);
+		if (!ld)
+			return;
+		if (ld->prev)
+			ld->prev->next = ld->next;
+		else
+			latency_devices = ld->next;
+		if (ld->next)
+			ld->next->prev = ld->prev;
+		libinput_device_set_user_data(dev, NULL);
+		libinput_device_unref(ld->device);
+		free(ld);
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+print_latency_histogram(struct libinput_device *dev,
+			enum libinput_event_type type,
+			const char *typename,
+			enum libinput_latency_stage stage,
+			const char *stagename)
+{
+	struct libinput_latency_histogram *h;
+
+	h = libinput_device_get_latency_histogram(dev, type, stage);
+	if (!h)
+		return;
+
+	if (libinput_latency_histogram_get_count(h) > 0)
+		printf("%-7s	%-21s	%s	count %llu	"
+		       "p50 %lluus	p90 %lluus	p99 %lluus	max %lluus\n",
+		       libinput_device_get_sysname(dev),
+		       typename,
+		       stagename,
+		       (unsigned long long)libinput_latency_histogram_get_count(h),
+		       (unsigned long long)libinput_latency_histogram_get_percentile(h, 50.0),
+		       (unsigned long long)libinput_latency_histogram_get_percentile(h, 90.0),
+		       (unsigned long long)libinput_latency_histogram_get_percentile(h, 99.0),
+		       (unsigned long long)libinput_latency_histogram_get_max(h));
+
+	libinput_latency_histogram_destroy(h);
+}
+
+static void
+print_latencies(void)
+{
+	static const struct {
+		enum libinput_event_type type;
+		const char *name;
+	} types[] = {
+		{ LIBINPUT_EVENT_KEYBOARD_KEY, "KEYBOARD_KEY" },
+		{ LIBINPUT_EVENT_POINTER_MOTION, "POINTER_MOTION" },
+		{ LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE, "POINTER_MOTION_ABSOLUTE" },
+		{ LIBINPUT_EVENT_POINTER_BUTTON, "POINTER_BUTTON" },
+		{ LIBINPUT_EVENT_POINTER_AXIS, "POINTER_AXIS" },
+		{ LIBINPUT_EVENT_TOUCH_DOWN, "TOUCH_DOWN" },
+		{ LIBINPUT_EVENT_TOUCH_UP, "TOUCH_UP" },
+		{ LIBINPUT_EVENT_TOUCH_MOTION, "TOUCH_MOTION" },
+		{ LIBINPUT_EVENT_TOUCH_CANCEL, "TOUCH_CANCEL" },
+		{ LIBINPUT_EVENT_TOUCH_FRAME, "TOUCH_FRAME" },
+		{ LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN, "GESTURE_SWIPE_BEGIN" },
+		{ LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE, "GESTURE_SWIPE_UPDATE" },
+		{ LIBINPUT_EVENT_GESTURE_SWIPE_END, "GESTURE_SWIPE_END" },
+		{ LIBINPUT_EVENT_GESTURE_PINCH_BEGIN, "GESTURE_PINCH_BEGIN" },
+		{ LIBINPUT_EVENT_GESTURE_PINCH_UPDATE, "GESTURE_PINCH_UPDATE" },
+		{ LIBINPUT_EVENT_GESTURE_PINCH_END, "GESTURE_PINCH_END" },
+	};
+	struct latency_device *ld;
+	size_t t;
+
+	for (ld = latency_devices; ld; ld = ld->next) {
+		struct libinput_device *dev = ld->device;
+
+		for (t = 0; t < ARRAY_LENGTH(types); t++) {
+			print_latency_histogram(dev,
+						types[t].type,
+						types[t].name,
+						LIBINPUT_LATENCY_STAGE_KERNEL_TO_DISPATCH,
+						"kernel->dispatch");
+			print_latency_histogram(dev,
+						types[t].type,
+						types[t].name,
+						LIBINPUT_LATENCY_STAGE_DISPATCH_TO_DEQUEUE,
+						"dispatch->dequeue");
+		}
+	}
+}
+
+static uint64_t
+now_ms(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return tp.tv_sec * 1000ULL + tp.tv_nsec / 1000000;
+}
+
 static int
 handle_and_print_events(struct libinput *li)
 {
@@ -384,6 +519,7 @@ handle_and_print_events(struct libinput *li)
 			print_device_notify(ev);
 			tools_device_apply_config(libinput_event_get_device(ev),
 						  &context.options);
+			track_latency_device(ev);
 			break;
 		case LIBINPUT_EVENT_KEYBOARD_KEY:
 			print_key_event(ev);
@@ -453,6 +589,7 @@ mainloop(struct libinput *li)
 {
 	struct pollfd fds;
 	struct sigaction act;
+	uint64_t interval, next_print;
 
 	fds.fd = libinput_get_fd(li);
 	fds.events = POLLIN;
@@ -473,8 +610,28 @@ mainloop(struct libinput *li)
 		fprintf(stderr, "Expected device added events on startup but got none. "
 				"Maybe you don't have the right permissions?\n");
 
-	while (!stop && poll(&fds, 1, -1) > -1)
+	if (context.options.latency_interval == 0) {
+		while (!stop && poll(&fds, 1, -1) > -1)
+			handle_and_print_events(li);
+		return;
+	}
+
+	interval = context.options.latency_interval * 1000ULL;
+	next_print = now_ms() + interval;
+
+	while (!stop) {
+		uint64_t now = now_ms();
+
+		if (now >= next_print) {
+			print_latencies();
+			next_print = now + interval;
+		}
+
+		if (poll(&fds, 1, next_print - now) < 0)
+			break;
+
 		handle_and_print_events(li);
+	}
 }
 
 int
@@ -0,0 +1,307 @@
+/*
+ * Copyright © 2016 the libinput contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <libudev.h>
+#include <libevdev/libevdev.h>
+
+#include <libinput-util.h>
+#include <record-writer.h>
+
+/* udev properties that affect how libinput configures the device */
+static const char *property_prefixes[] = {
+	"ID_INPUT",
+	"ID_SEAT",
+	"LIBINPUT_",
+	"MOUSE_",
+	"POINTINGSTICK_",
+	"WL_",
+};
+
+static volatile sig_atomic_t stop = 0;
+
+static void
+sighandler(int signal)
+{
+	stop = 1;
+}
+
+static void
+usage(void)
+{
+	printf("Usage: %s [--help] --output-file=<file> /dev/input/event0\n"
+	       "\n"
+	       "Record the events of the given device into a file, until\n"
+	       "interrupted with Ctrl+C.\n"
+	       "\n"
+	       "Options:\n"
+	       "--output-file=<file> .... the file to write the recording to\n"
+	       "--help .......... Print this help.\n",
+	       program_invocation_short_name);
+}
+
+/* The udev properties with one of the property_prefixes as
+ * "KEY=value\0" list. Returns NULL on allocation failure. */
+static char *
+describe_properties(struct udev_device *udev_device, size_t *size)
+{
+	struct udev_list_entry *entry;
+	char *properties = NULL, *p;
+	size_t len = 0, i;
+
+	*size = 0;
+	if (!udev_device)
+		return strdup("");
+
+	udev_list_entry_foreach(entry,
+				udev_device_get_properties_list_entry(udev_device)) {
+		const char *key = udev_list_entry_get_name(entry);
+		const char *value = udev_list_entry_get_value(entry);
+
+		if (!value)
+			value = "";
+
+		for (i = 0; i < ARRAY_LENGTH(property_prefixes); i++) {
+			const char *prefix = property_prefixes[i];
+
+			if (strncmp(key, prefix, strlen(prefix)) != 0)
+				continue;
+
+			len = strlen(key) + 1 + strlen(value) + 1;
+			p = realloc(properties, *size + len);
+			if (!p) {
+				free(properties);
+				return NULL;
+			}
+			properties = p;
+
+			snprintf(properties + *size, len, "%s=%s", key, value);
+			*size += len;
+			break;
+		}
+	}
+
+	return properties ? properties : strdup("");
+}
+
+static int
+record_device_events(struct record_writer *w, struct libevdev *evdev, int fd)
+{
+	struct pollfd fds;
+	struct input_event ev;
+	int rc;
+
+	fds.fd = fd;
+	fds.events = POLLIN;
+	fds.revents = 0;
+
+	while (!stop) {
+		rc = poll(&fds, 1, -1);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+
+		do {
+			rc = libevdev_next_event(evdev,
+						 LIBEVDEV_READ_FLAG_NORMAL,
+						 &ev);
+			if (rc == LIBEVDEV_READ_STATUS_SYNC) {
+				/* SYN_DROPPED is a frame of its own, the
+				 * sync events that follow describe the
+				 * current device state */
+				if (record_writer_add_event(w, &ev) != 0)
+					return -1;
+
+				do {
+					rc = libevdev_next_event(evdev,
+								 LIBEVDEV_READ_FLAG_SYNC,
+								 &ev);
+					if (rc == LIBEVDEV_READ_STATUS_SYNC &&
+					    record_writer_add_event(w, &ev) != 0)
+						return -1;
+				} while (rc == LIBEVDEV_READ_STATUS_SYNC);
+
+				rc = LIBEVDEV_READ_STATUS_SUCCESS;
+			} else if (rc == LIBEVDEV_READ_STATUS_SUCCESS) {
+				if (record_writer_add_event(w, &ev) != 0)
+					return -1;
+			}
+		} while (rc == LIBEVDEV_READ_STATUS_SUCCESS);
+
+		if (rc != -EAGAIN)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int
+record(FILE *out, struct libevdev *evdev, int fd,
+       struct udev_device *udev_device)
+{
+	struct record_writer w;
+	struct record_device device;
+	char *properties;
+	size_t properties_size;
+	int rc = -1;
+
+	record_describe_device(evdev, &device);
+	properties = describe_properties(udev_device, &properties_size);
+	if (!properties)
+		return -1;
+
+	if (record_writer_init(&w,
+			       out,
+			       &device,
+			       properties,
+			       properties_size) != 0)
+		goto out;
+
+	if (record_device_events(&w, evdev, fd) != 0)
+		fprintf(stderr, "Error reading from device: %s\n",
+			strerror(errno));
+
+	if (record_writer_finish(&w) != 0)
+		goto out;
+
+	fprintf(stderr, "Recorded %" PRIu64 " events in %" PRIu64 " frames\n",
+		w.header.nevents, w.header.nframes);
+	rc = 0;
+
+out:
+	record_writer_fini(&w);
+	free(properties);
+
+	return rc;
+}
+
+int
+main(int argc, char **argv)
+{
+	FILE *out;
+	struct libevdev *evdev = NULL;
+	struct udev *udev = NULL;
+	struct udev_device *udev_device = NULL;
+	struct sigaction act;
+	struct stat st;
+	const char *output = NULL;
+	const char *path;
+	int fd, rc = 1;
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		static struct option opts[] = {
+			{ "output-file", 1, 0, 'o' },
+			{ "help", 0, 0, 'h' },
+			{ 0, 0, 0, 0 },
+		};
+
+		c = getopt_long(argc, argv, "ho:", opts, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'h':
+			usage();
+			return 0;
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	if (!output || optind != argc - 1) {
+		usage();
+		return 1;
+	}
+
+	path = argv[optind];
+	fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	if (libevdev_new_from_fd(fd, &evdev) != 0) {
+		fprintf(stderr, "Failed to initialize %s\n", path);
+		goto out;
+	}
+	libevdev_set_clock_id(evdev, CLOCK_MONOTONIC);
+
+	udev = udev_new();
+	if (udev && fstat(fd, &st) == 0)
+		udev_device = udev_device_new_from_devnum(udev, 'c', st.st_rdev);
+	if (!udev_device)
+		fprintf(stderr,
+			"Warning: no udev device for %s, udev properties are not recorded\n",
+			path);
+
+	out = fopen(output, "w+");
+	if (!out) {
+		fprintf(stderr, "Failed to open %s: %s\n", output, strerror(errno));
+		goto out;
+	}
+	setvbuf(out, NULL, _IOFBF, 64 * 1024);
+
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = sighandler;
+	sigaction(SIGINT, &act, NULL);
+	sigaction(SIGTERM, &act, NULL);
+
+	fprintf(stderr, "Recording %s, press Ctrl+C to stop\n",
+		libevdev_get_name(evdev));
+
+	if (record(out, evdev, fd, udev_device) != 0)
+		fprintf(stderr, "Failed to write %s: %s\n", output, strerror(errno));
+	else
+		rc = 0;
+
+	fclose(out);
+out:
+	if (udev_device)
+		udev_device_unref(udev_device);
+	if (udev)
+		udev_unref(udev);
+	libevdev_free(evdev);
+	close(fd);
+
+	return rc;
+}
@@ -60,6 +60,7 @@ enum options {
 	OPT_SCROLL_BUTTON,
 	OPT_SPEED,
 	OPT_PROFILE,
+	OPT_SHOW_LATENCY,
 };
 
 static void
@@ -104,6 +105,7 @@ tools_usage()
 	       "Other options:\n"
 	       "--grab .......... Exclusively grab all openend devices\n"
 	       "--verbose ....... Print debugging output.\n"
+	       "--show-latency=<seconds> .... Print per-device event latencies at the given interval\n"
 	       "--help .......... Print this help.\n",
 		program_invocation_short_name);
 }
@@ -162,6 +164,7 @@ tools_parse_args(int argc, char **argv, struct tools_context *context)
 			{ "set-scroll-button", 1, 0, OPT_SCROLL_BUTTON },
 			{ "set-profile", 1, 0, OPT_PROFILE },
 			{ "speed", 1, 0, OPT_SPEED },
+			{ "show-latency", 1, 0, OPT_SHOW_LATENCY },
 			{ 0, 0, 0, 0}
 		};
 
@@ -306,6 +309,19 @@ tools_parse_args(int argc, char **argv, struct tools_context *context)
 				return 1;
 			}
 			break;
+		case OPT_SHOW_LATENCY:
+			if (!optarg) {
+				tools_usage();
+				return 1;
+			}
+			options->latency_interval = atoi(optarg);
+			if (options->latency_interval <= 0) {
+				fprintf(stderr,
+					"Invalid latency interval %s\n",
+					optarg);
+				return 1;
+			}
+			break;
 		default:
 			tools_usage();
 			return 1;
@@ -49,6 +49,7 @@ struct tools_options {
 	double speed;
 	int dwt;
 	enum libinput_config_accel_profile profile;
+	int latency_interval; /* in seconds, 0 to disable */
 };
 
 struct tools_context {